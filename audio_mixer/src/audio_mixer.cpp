@@ -1,6 +1,45 @@
+#include <cmath>
+#include <numbers>
 #include <print>
+#include <vector>
+
+#include "audio_mixer.h"
 
 int main()
 {
-    std::println("hello,audio mixer !");
-}
\ No newline at end of file
+    // Two producers (a 44.1 KHz mono tone, a 48 KHz stereo tone) mixed into one 48 KHz stereo stream.
+    audio_ctx output_ctx{sample_rate::SR48000, "Stereo"};
+    audio_ctx tone_ctx{sample_rate::SR44100, "Mono"};
+
+    audio_mixer<int16_t> mixer(output_ctx);
+    const auto tone  = mixer.add_input();
+    const auto music = mixer.add_input();
+    if (!tone || !music)
+        return 1;
+
+    mixer.set_gain(*tone, 0.5F);
+
+    constexpr std::size_t period_frame = 480;
+    constexpr std::size_t period_count = 100;
+
+    std::vector<int16_t> tone_block(441);
+    std::vector<int16_t> music_block(period_frame * 2);
+    std::vector<int16_t> output(period_frame * 2);
+
+    std::size_t short_periods = 0;
+    for (std::size_t period = 0; period < period_count; ++period)
+    {
+        for (std::size_t i = 0; i < tone_block.size(); ++i)
+            tone_block[i] = static_cast<int16_t>(8000 * std::sin(2 * std::numbers::pi * 440 * static_cast<double>((period * tone_block.size()) + i) / 44100));
+        for (std::size_t i = 0; i < period_frame; ++i)
+            music_block[2 * i] = music_block[(2 * i) + 1] = static_cast<int16_t>(4000 * std::sin(2 * std::numbers::pi * 220 * static_cast<double>((period * period_frame) + i) / 48000));
+
+        mixer.input_queue(*tone)->push_audio(tone_ctx, tone_block.data(), tone_block.size());
+        mixer.input_queue(*music)->push_audio(output_ctx, music_block.data(), period_frame);
+
+        if (!mixer.mix(output.data(), period_frame))
+            ++short_periods;
+    }
+
+    std::println("mixed {} periods of {} frames, {} with a short input", period_count, period_frame, short_periods);
+}
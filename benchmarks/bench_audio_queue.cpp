@@ -0,0 +1,268 @@
+#include <benchmark/benchmark.h>
+#include "audio_queue.h"
+
+#include <array>
+#include <chrono>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// push_audio / pop_audio throughput and per-call latency.
+// Calls are timed one by one (manual time) : the untimed half of each iteration keeps the queue level.
+
+namespace
+{
+    constexpr std::array<std::string_view, 4> layouts{"Mono", "Stereo", "5.1", "7.1"};
+    constexpr std::size_t drain_block = 16384;
+
+    sample_rate rate_of(int64_t hz)
+    {
+        switch (hz)
+        {
+        case 44100: return sample_rate::SR44100;
+        case 96000: return sample_rate::SR96000;
+        default:	return sample_rate::SR48000;
+        }
+    }
+
+    template <typename Call>
+    double time_call(Call&& call)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        call();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    template <audio_sample_type AudioType>
+    void drain(audio_queue<AudioType>& queue)
+    {
+        static std::vector<float> sink(drain_block);
+        while (queue.pop_float(sink) == sink.size()) {}
+    }
+
+    void report(benchmark::State& state, std::size_t frames, std::size_t channels, std::size_t sample_size)
+    {
+        const auto items = static_cast<int64_t>(state.iterations() * frames);
+        state.SetItemsProcessed(items); // Frames per second
+        state.SetBytesProcessed(items * static_cast<int64_t>(channels * sample_size));
+    }
+} // namespace
+
+// Same context on both sides : conversion and enqueue only.
+template <audio_sample_type AudioType>
+static void BM_push_audio(benchmark::State& state)
+{
+    const auto frames = static_cast<std::size_t>(state.range(0));
+    audio_ctx  ctx{sample_rate::SR48000, "Stereo"};
+    audio_queue<AudioType> queue(ctx, 1000);
+
+    std::vector<AudioType> input(frames * 2, AudioType{});
+    queue.prepare_input(ctx);
+
+    for (auto _ : state)
+    {
+        state.SetIterationTime(time_call([&] { benchmark::DoNotOptimize(queue.push_audio(ctx, input.data(), frames)); }));
+        drain(queue);
+    }
+    report(state, frames, 2, sizeof(AudioType));
+}
+
+template <audio_sample_type AudioType>
+static void BM_pop_audio(benchmark::State& state)
+{
+    const auto frames = static_cast<std::size_t>(state.range(0));
+    audio_ctx  ctx{sample_rate::SR48000, "Stereo"};
+    audio_queue<AudioType> queue(ctx, 1000);
+
+    std::vector<AudioType> buffer(frames * 2, AudioType{});
+    queue.prepare_input(ctx);
+
+    for (auto _ : state)
+    {
+        queue.push_audio(ctx, buffer.data(), frames);
+        state.SetIterationTime(time_call([&] { benchmark::DoNotOptimize(queue.pop_audio(ctx, buffer.data(), frames)); }));
+        benchmark::ClobberMemory();
+    }
+    report(state, frames, 2, sizeof(AudioType));
+}
+
+#define AUDIO_QUEUE_TYPE_BENCHMARK(bench, type) \
+    BENCHMARK_TEMPLATE(bench, type)->ArgName("frames")->RangeMultiplier(2)->Range(32, 8192)->UseManualTime()
+
+AUDIO_QUEUE_TYPE_BENCHMARK(BM_push_audio, uint8_t);
+AUDIO_QUEUE_TYPE_BENCHMARK(BM_push_audio, int16_t);
+AUDIO_QUEUE_TYPE_BENCHMARK(BM_push_audio, int32_t);
+AUDIO_QUEUE_TYPE_BENCHMARK(BM_push_audio, float);
+AUDIO_QUEUE_TYPE_BENCHMARK(BM_push_audio, double);
+AUDIO_QUEUE_TYPE_BENCHMARK(BM_push_audio, int24_packed);
+AUDIO_QUEUE_TYPE_BENCHMARK(BM_push_audio, int24_in_32);
+
+AUDIO_QUEUE_TYPE_BENCHMARK(BM_pop_audio, uint8_t);
+AUDIO_QUEUE_TYPE_BENCHMARK(BM_pop_audio, int16_t);
+AUDIO_QUEUE_TYPE_BENCHMARK(BM_pop_audio, int32_t);
+AUDIO_QUEUE_TYPE_BENCHMARK(BM_pop_audio, float);
+AUDIO_QUEUE_TYPE_BENCHMARK(BM_pop_audio, double);
+AUDIO_QUEUE_TYPE_BENCHMARK(BM_pop_audio, int24_packed);
+AUDIO_QUEUE_TYPE_BENCHMARK(BM_pop_audio, int24_in_32);
+
+// Every channel layout pair, without resampling.
+static void BM_push_audio_layout(benchmark::State& state)
+{
+    const auto frames = static_cast<std::size_t>(state.range(2));
+    audio_ctx  input_ctx{sample_rate::SR48000, layouts[static_cast<std::size_t>(state.range(0))]};
+    audio_ctx  output_ctx{sample_rate::SR48000, layouts[static_cast<std::size_t>(state.range(1))]};
+    audio_queue<int16_t> queue(output_ctx, 1000);
+
+    std::vector<int16_t> input(frames * input_ctx.m_channel_num, 0);
+    queue.prepare_input(input_ctx);
+
+    for (auto _ : state)
+    {
+        state.SetIterationTime(time_call([&] { benchmark::DoNotOptimize(queue.push_audio(input_ctx, input.data(), frames)); }));
+        drain(queue);
+    }
+    report(state, frames, input_ctx.m_channel_num, sizeof(int16_t));
+}
+BENCHMARK(BM_push_audio_layout)
+    ->ArgNames({"in", "out", "frames"})
+    ->ArgsProduct({{0, 1, 2, 3}, {0, 1, 2, 3}, {256, 4096}})
+    ->UseManualTime();
+
+// Input rate to a 48 KHz queue : 48000 is the no-resampling baseline.
+static void BM_push_audio_resample(benchmark::State& state)
+{
+    const auto frames = static_cast<std::size_t>(state.range(1));
+    audio_ctx  input_ctx{rate_of(state.range(0)), "Stereo"};
+    audio_ctx  output_ctx{sample_rate::SR48000, "Stereo"};
+    audio_queue<int16_t> queue(output_ctx, 1000);
+
+    std::vector<int16_t> input(frames * 2, 0);
+    queue.prepare_input(input_ctx);
+
+    for (auto _ : state)
+    {
+        state.SetIterationTime(time_call([&] { benchmark::DoNotOptimize(queue.push_audio(input_ctx, input.data(), frames)); }));
+        drain(queue);
+    }
+    report(state, frames, 2, sizeof(int16_t));
+}
+BENCHMARK(BM_push_audio_resample)
+    ->ArgNames({"rate", "frames"})
+    ->ArgsProduct({{44100, 48000, 96000}, {32, 256, 2048, 8192}})
+    ->UseManualTime();
+
+// 1P1C and multi-producer contention on the ring itself : thread 0 consumes, every other thread produces.
+// Each thread runs the same iteration count, the consumer takes one block per producer per iteration.
+static void BM_ring_contention(benchmark::State& state)
+{
+    const auto samples = static_cast<std::size_t>(state.range(0));
+    static audio_ring* ring = nullptr;
+
+    if (state.thread_index() == 0)
+        ring = new audio_ring(1 << 16);
+
+    const std::size_t producers = static_cast<std::size_t>(state.threads()) - 1;
+    const std::size_t wanted	= state.thread_index() == 0 ? samples * producers : samples;
+    std::vector<float> block(wanted, 0.0F);
+
+    for (auto _ : state)
+        for (std::size_t moved = 0; moved < wanted; std::this_thread::yield())
+            moved += state.thread_index() == 0 ? ring->read(block.data() + moved, wanted - moved) : ring->write(block.data() + moved, wanted - moved);
+
+    if (state.thread_index() == 0)
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * wanted)); // Samples through the ring
+
+    if (state.thread_index() == 0)
+    {
+        delete ring;
+        ring = nullptr;
+    }
+}
+BENCHMARK(BM_ring_contention)->ArgName("samples")->Arg(64)->Arg(1024)->ThreadRange(2, 8)->UseRealTime();
+
+// push_audio / pop_audio under contention : every thread is a producer with its own input context
+// (one producer per context, see audio_queue) and a consumer popping as much as it pushed.
+static void BM_queue_contention(benchmark::State& state)
+{
+    constexpr std::size_t frames = 256;
+    static const audio_ctx output_ctx{sample_rate::SR48000, "Stereo"};
+    static audio_queue<int16_t>* queue = nullptr;
+
+    if (state.thread_index() == 0)
+        queue = new audio_queue<int16_t>(output_ctx, 1000);
+
+    // Same rate on every context : each push enqueues exactly what the pop takes back
+    const audio_ctx		 input_ctx{sample_rate::SR48000, layouts[static_cast<std::size_t>(state.thread_index())]};
+    std::vector<int16_t> input(frames * 8, 0);
+    std::vector<float>	 output(frames * 2);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(queue->push_audio(input_ctx, input.data(), frames));
+        for (std::size_t popped = 0; popped < output.size(); std::this_thread::yield())
+            popped += queue->pop_float(std::span{output}.subspan(popped));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * frames));
+
+    if (state.thread_index() == 0)
+    {
+        delete queue;
+        queue = nullptr;
+    }
+}
+BENCHMARK(BM_queue_contention)->DenseThreadRange(1, static_cast<int>(layouts.size()))->UseRealTime();
+
+// A float source rendering in the expected context : render to a buffer, push_audio, pop_float, then use it (in_place:0),
+// against rendering into acquire_write() and using acquire_read() without copy (in_place:1).
+static void BM_render_in_place(benchmark::State& state)
+{
+    const auto frames	= static_cast<std::size_t>(state.range(0));
+    const bool in_place = state.range(1) != 0;
+    audio_ctx  ctx{sample_rate::SR48000, "Stereo"};
+    audio_queue<float> queue(ctx, 1000);
+
+    std::vector<float> rendered(frames * 2);
+    std::vector<float> popped(frames * 2);
+    queue.prepare_input(ctx);
+
+    const auto render = [](std::span<float> samples, std::size_t first)
+    {
+        for (std::size_t i = 0; i < samples.size(); ++i)
+            samples[i] = static_cast<float>((first + i) & 0xFF) * (1.0F / 256.0F);
+    };
+    const auto use = [](std::span<const float> samples)
+    {
+        float sum = 0.0F;
+        for (const float sample : samples)
+            sum += sample;
+        return sum;
+    };
+
+    for (auto _ : state)
+    {
+        float sum = 0.0F;
+        if (in_place)
+        {
+            auto write = queue.acquire_write(frames);
+            for (std::size_t region = 0, first = 0; region < write.regions(); first += write.interleaved(region++).size())
+                render(write.interleaved(region), first);
+            write.commit(frames);
+
+            auto read = queue.acquire_read(frames);
+            for (std::size_t region = 0; region < read.regions(); ++region)
+                sum += use(read.interleaved(region));
+            read.release(frames);
+        }
+        else
+        {
+            render(rendered, 0);
+            queue.push_audio(ctx, rendered.data(), frames);
+            queue.pop_float(popped);
+            sum = use(popped);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    report(state, frames, 2, sizeof(float));
+}
+BENCHMARK(BM_render_in_place)->ArgNames({"frames", "in_place"})->ArgsProduct({{64, 256, 2048}, {0, 1}});
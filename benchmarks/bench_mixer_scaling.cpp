@@ -0,0 +1,50 @@
+#include <benchmark/benchmark.h>
+#include "audio_mixer.h"
+
+#include <thread>
+#include <vector>
+
+// Mix pass throughput of a large input count, from 1 thread to every core.
+static void BM_mixer_scaling(benchmark::State& state)
+{
+    const auto threads = static_cast<std::size_t>(state.range(0));
+    const auto inputs  = static_cast<std::size_t>(state.range(1));
+    constexpr std::size_t frames = 480;
+
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    audio_mixer<float> mixer(ctx, inputs, 200, threads);
+
+    std::vector<std::size_t> ids;
+    for (std::size_t i = 0; i < inputs; ++i)
+        ids.push_back(*mixer.add_input());
+
+    std::vector<float> period(frames * 2, 0.01f);
+    std::vector<float> output(frames * 2);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        for (auto id : ids)
+            mixer.input_queue(id)->push_audio(ctx, period.data(), frames);
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(mixer.mix(output.data(), frames));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * inputs * frames)); // Input frames mixed
+    state.counters["threads"] = static_cast<double>(threads);
+}
+
+static void scaling_arguments(benchmark::internal::Benchmark* bench)
+{
+    const auto cores = static_cast<int64_t>(std::max(1U, std::thread::hardware_concurrency()));
+    for (int64_t inputs : {64, 256, 1024})
+        for (int64_t threads = 1; threads <= cores; threads *= 2)
+            bench->Args({threads, inputs});
+    for (int64_t inputs : {64, 256, 1024})
+        if ((cores & (cores - 1)) != 0)
+            bench->Args({cores, inputs});
+}
+
+BENCHMARK(BM_mixer_scaling)->ArgNames({"threads", "inputs"})->Apply(scaling_arguments)->UseRealTime()->Unit(benchmark::kMicrosecond);
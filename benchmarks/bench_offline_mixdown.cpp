@@ -0,0 +1,78 @@
+#include <benchmark/benchmark.h>
+#include "offline_mixdown.h"
+
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr std::size_t stem_seconds = 10;
+
+    // Stereo 48 KHz int16 stems (straight from the mapping) and mono 44.1 KHz float stems (converted and resampled).
+    std::filesystem::path write_stem(std::size_t index, bool resampled)
+    {
+        const auto path = std::filesystem::temp_directory_path() / ("bench_stem_" + std::to_string(index) + (resampled ? "_44k.wav" : "_48k.wav"));
+        if (std::filesystem::exists(path))
+            return path;
+
+        if (resampled)
+        {
+            std::vector<float> samples(44100 * stem_seconds);
+            for (std::size_t i = 0; i < samples.size(); ++i)
+                samples[i] = 0.1f * static_cast<float>(std::sin(static_cast<double>(i * (index + 1)) * 0.01));
+            auto writer = wav_writer::create(path, audio_ctx{sample_rate::SR44100, "Mono"}, pcm_encoding::float32);
+            writer->write(std::as_bytes(std::span{samples}));
+        }
+        else
+        {
+            std::vector<int16_t> samples(48000 * stem_seconds * 2);
+            for (std::size_t i = 0; i < samples.size(); ++i)
+                samples[i] = static_cast<int16_t>(3000 * std::sin(static_cast<double>((i / 2) * (index + 1)) * 0.01));
+            auto writer = wav_writer::create(path, audio_ctx{sample_rate::SR48000, "Stereo"}, pcm_encoding::int16);
+            writer->write(std::as_bytes(std::span{samples}));
+        }
+        return path;
+    }
+} // namespace
+
+// Stems mixed as fast as possible, output to a file written by blocks (or discarded). Reports multiples of real time.
+static void BM_offline_mixdown(benchmark::State& state)
+{
+    const auto stems     = static_cast<std::size_t>(state.range(0));
+    const bool resampled = state.range(1) != 0;
+    const bool to_file   = state.range(2) != 0;
+    audio_ctx output_ctx{sample_rate::SR48000, "Stereo"};
+
+    std::vector<mapped_file> files;
+    std::vector<pcm_stream>  streams;
+    for (std::size_t i = 0; i < stems; ++i)
+    {
+        files.push_back(*mapped_file::open(write_stem(i, resampled)));
+        streams.push_back(*parse_wav(files.back().bytes()));
+    }
+    const auto output_path = std::filesystem::temp_directory_path() / "bench_mixdown_out.wav";
+
+    double audio_seconds = 0.0;
+    for (auto _ : state)
+    {
+        offline_mixdown<int16_t> mixdown(output_ctx, stems);
+        for (const auto& stream : streams)
+            mixdown.add_input(stream, resample_quality::linear);
+
+        const auto stats = to_file ? *mixdown.render_to_file(output_path)
+                                   : mixdown.render([](std::span<const int16_t> period) { benchmark::DoNotOptimize(period.data()); return true; });
+        audio_seconds += static_cast<double>(stats.m_frames) / 48000.0;
+    }
+
+    state.counters["x_realtime"] = benchmark::Counter(audio_seconds, benchmark::Counter::kIsRate);
+    state.SetItemsProcessed(static_cast<int64_t>(audio_seconds * 48000.0)); // Output frames
+    std::filesystem::remove(output_path);
+}
+
+BENCHMARK(BM_offline_mixdown)
+    ->ArgNames({"stems", "resampled", "file"})
+    ->ArgsProduct({{1, 8, 32}, {0, 1}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
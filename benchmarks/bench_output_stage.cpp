@@ -0,0 +1,126 @@
+#include <benchmark/benchmark.h>
+#include "audio_mixer.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr std::size_t inputs = 16;
+    constexpr std::size_t frames = 480;
+
+    // Mix sums, peaks well above full scale
+    std::vector<float> loud_block(std::size_t samples)
+    {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+        std::vector<float> block(samples);
+        for (auto& s : block)
+            s = dist(rng);
+        return block;
+    }
+
+    output_stage stage_of(int64_t index)
+    {
+        switch (index)
+        {
+        case 0:  return {.m_limiter = limiter_mode::clamp};
+        case 1:  return {.m_limiter = limiter_mode::soft_knee};
+        default: return {.m_limiter = limiter_mode::soft_knee, .m_dither = true};
+        }
+    }
+} // namespace
+
+// Limiter alone over a float block : the previous clamp loop against the soft-knee kernel.
+static void BM_limit_block(benchmark::State& state)
+{
+    const bool soft   = state.range(0) != 0;
+    const auto source = loud_block(static_cast<std::size_t>(state.range(1)));
+    auto block        = source;
+
+    for (auto _ : state)
+    {
+        std::ranges::copy(source, block.begin());
+        if (soft)
+            soft_limit(block, 0.9f);
+        else
+            for (auto& sample : block)
+                sample = std::clamp(sample, -1.0f, 1.0f);
+        benchmark::DoNotOptimize(block.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(1));
+}
+
+BENCHMARK(BM_limit_block)->ArgNames({"soft", "samples"})->ArgsProduct({{0, 1}, {256, 4096}});
+
+// Whole mixer pass with each output stage : 0 clamp, 1 soft knee, 2 soft knee + dither.
+template <typename AudioType>
+static void BM_mixer_output_stage(benchmark::State& state)
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    audio_mixer<AudioType> mixer(ctx, inputs);
+    mixer.set_output_stage(stage_of(state.range(0)));
+
+    std::vector<std::size_t> ids;
+    for (std::size_t i = 0; i < inputs; ++i)
+        ids.push_back(*mixer.add_input());
+
+    const auto loud = loud_block(frames * 2);
+    std::vector<AudioType> period(frames * 2);
+    convert_from_float(std::span<const float>{loud}, std::span{period});
+    std::vector<AudioType> output(frames * 2);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        for (auto id : ids)
+            mixer.input_queue(id)->push_audio(ctx, period.data(), frames);
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(mixer.mix(output.data(), frames));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * frames)); // Output frames
+}
+
+BENCHMARK_TEMPLATE(BM_mixer_output_stage, float)->ArgName("stage")->DenseRange(0, 2);
+BENCHMARK_TEMPLATE(BM_mixer_output_stage, int16_t)->ArgName("stage")->DenseRange(0, 2);
+
+// Reference : the same inputs mixed by pop_audio into the output, one clamp (and conversion) per input.
+template <typename AudioType>
+static void BM_queue_clamp_per_input(benchmark::State& state)
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+
+    std::vector<std::unique_ptr<audio_queue<AudioType>>> queues;
+    for (std::size_t i = 0; i < inputs; ++i)
+        queues.push_back(std::make_unique<audio_queue<AudioType>>(ctx));
+
+    const auto loud = loud_block(frames * 2);
+    std::vector<AudioType> period(frames * 2);
+    convert_from_float(std::span<const float>{loud}, std::span{period});
+    std::vector<AudioType> output(frames * 2);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        for (auto& queue : queues)
+            queue->push_audio(ctx, period.data(), frames);
+        std::ranges::fill(output, make_audio_converters<AudioType>().second(0.0f));
+        state.ResumeTiming();
+
+        for (auto& queue : queues)
+            benchmark::DoNotOptimize(queue->pop_audio(ctx, output.data(), frames));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * frames)); // Output frames
+}
+
+BENCHMARK_TEMPLATE(BM_queue_clamp_per_input, float);
+BENCHMARK_TEMPLATE(BM_queue_clamp_per_input, int16_t);
@@ -0,0 +1,93 @@
+#include <benchmark/benchmark.h>
+#include "audio_mixer.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    constexpr std::size_t input_period  = 441; // 10 ms at 44.1 KHz
+    constexpr std::size_t output_period = 480; // 10 ms at 48 KHz
+    constexpr double      period_second = 0.01;
+
+    std::vector<float> stereo_tone(std::size_t index)
+    {
+        std::vector<float> period(input_period * 2);
+        for (std::size_t i = 0; i < period.size(); ++i)
+            period[i] = 0.1f * static_cast<float>(std::sin(static_cast<double>((i / 2) * (index + 1)) * 0.01));
+        return period;
+    }
+
+    resample_quality quality_of(int64_t index)
+    {
+        return index == 0 ? resample_quality::best : resample_quality::fastest;
+    }
+} // namespace
+
+// 44.1 KHz stereo streams into a 48 KHz mix : each queue resampling on push (its own libsamplerate state),
+// against the queues staying at 44.1 KHz and the mix pass resampling them in one batch.
+// streams_per_core : streams handled in real time by one core (CPU time of the producers' pushes and of the mix).
+static void BM_mixer_resampled_streams(benchmark::State& state)
+{
+    const auto streams = static_cast<std::size_t>(state.range(0));
+    const bool batched = state.range(1) != 0;
+    const auto quality = quality_of(state.range(2));
+
+    audio_ctx input_ctx{sample_rate::SR44100, "Stereo"};
+    audio_ctx output_ctx{sample_rate::SR48000, "Stereo"};
+    audio_mixer<float> mixer(output_ctx, streams);
+
+    std::vector<std::size_t>        ids;
+    std::vector<std::vector<float>> tones;
+    for (std::size_t i = 0; i < streams; ++i)
+    {
+        ids.push_back(*(batched ? mixer.add_input(sample_rate::SR44100, quality) : mixer.add_input(quality)));
+        tones.push_back(stereo_tone(i));
+    }
+    std::vector<float> output(output_period * 2);
+
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < streams; ++i)
+            mixer.input_queue(ids[i])->push_audio(input_ctx, tones[i].data(), input_period);
+
+        benchmark::DoNotOptimize(mixer.mix(output.data(), output_period));
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["streams_per_core"] = benchmark::Counter(static_cast<double>(state.iterations() * streams) * period_second, benchmark::Counter::kIsRate);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * streams * output_period)); // Output frames, all streams
+}
+
+BENCHMARK(BM_mixer_resampled_streams)
+    ->ArgNames({"streams", "batched", "fastest"})
+    ->ArgsProduct({{16, 128, 512}, {0, 1}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Kernel alone : one period of every stereo stream through a shared table, lanes side by side.
+static void BM_batch_resampler(benchmark::State& state)
+{
+    const auto streams = static_cast<std::size_t>(state.range(0));
+    const auto lanes   = streams * 2;
+
+    batch_resampler batch(polyphase_filter::shared(44100, 48000, quality_of(state.range(1))), lanes, output_period);
+    const auto      tone = stereo_tone(0);
+
+    for (auto _ : state)
+    {
+        const std::size_t frames = batch.input_frames_for(output_period);
+        for (std::size_t frame = 0; frame < frames; ++frame)
+            for (std::size_t lane = 0; lane < lanes; ++lane)
+                batch.input(frame)[lane] = tone[(frame * 2) + (lane & 1U)];
+
+        batch.process(output_period, 0, lanes);
+        batch.advance(output_period);
+        benchmark::DoNotOptimize(batch.output(0));
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["streams_per_core"] = benchmark::Counter(static_cast<double>(state.iterations() * streams) * period_second, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_batch_resampler)->ArgNames({"streams", "fastest"})->ArgsProduct({{16, 128, 512}, {0, 1}});
@@ -0,0 +1,217 @@
+/**
+ * @file audio_file.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-11-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "audio_prop_def.h"
+
+/**
+ * @brief Sample encoding of PCM data in a file, little-endian.
+ *
+ */
+enum class pcm_encoding : std::uint8_t
+{
+	uint8,	 // 8-bit unsigned
+	int16,	 // 16-bit signed
+	int24,	 // 24-bit signed, packed on 3 bytes
+	int32,	 // 32-bit signed (also 24 valid bits in a 32-bit container, left-justified)
+	float32, // IEEE float
+	float64	 // IEEE double
+};
+
+/**
+ * @brief Bytes of one sample of an encoding.
+ *
+ */
+constexpr std::size_t sample_bytes(pcm_encoding encoding)
+{
+	switch (encoding)
+	{
+		case pcm_encoding::uint8:	return 1;
+		case pcm_encoding::int16:	return 2;
+		case pcm_encoding::int24:	return 3;
+		case pcm_encoding::int32:	return 4;
+		case pcm_encoding::float32: return 4;
+		case pcm_encoding::float64: return 8;
+	}
+	return 0;
+}
+
+/**
+ * @brief Encoding of a sample type, std::nullopt if files have no such encoding (int24_in_32...).
+ *
+ */
+template <audio_sample_type AudioType>
+constexpr std::optional<pcm_encoding> pcm_encoding_of()
+{
+	if constexpr (std::is_same_v<AudioType, uint8_t>)
+		return pcm_encoding::uint8;
+	else if constexpr (std::is_same_v<AudioType, int16_t>)
+		return pcm_encoding::int16;
+	else if constexpr (std::is_same_v<AudioType, int24_packed>)
+		return pcm_encoding::int24;
+	else if constexpr (std::is_same_v<AudioType, int32_t>)
+		return pcm_encoding::int32;
+	else if constexpr (std::is_same_v<AudioType, float>)
+		return pcm_encoding::float32;
+	else if constexpr (std::is_same_v<AudioType, double>)
+		return pcm_encoding::float64;
+	else
+		return std::nullopt;
+}
+
+/**
+ * @brief Call visitor(std::type_identity<SampleType>{}) with the sample type of an encoding.
+ *
+ */
+template <typename Visitor>
+decltype(auto) visit_encoding(pcm_encoding encoding, Visitor&& visitor)
+{
+	switch (encoding)
+	{
+		case pcm_encoding::uint8:	return visitor(std::type_identity<uint8_t>{});
+		case pcm_encoding::int16:	return visitor(std::type_identity<int16_t>{});
+		case pcm_encoding::int24:	return visitor(std::type_identity<int24_packed>{});
+		case pcm_encoding::int32:	return visitor(std::type_identity<int32_t>{});
+		case pcm_encoding::float32: return visitor(std::type_identity<float>{});
+		case pcm_encoding::float64: break;
+	}
+	return visitor(std::type_identity<double>{});
+}
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * Pages are loaded on first access, sequential read-ahead is requested : a file larger than memory
+ * streams through the page cache. Move-only, unmapped on destruction.
+ *
+ */
+class mapped_file
+{
+public:
+
+	/**
+     * @brief Map a file.
+     *
+     * @return std::optional<mapped_file> The mapping, std::nullopt if the file can not be opened or mapped
+     */
+	static std::optional<mapped_file> open(const std::filesystem::path& path);
+
+	mapped_file(mapped_file&& other) noexcept;
+	mapped_file& operator=(mapped_file&& other) noexcept;
+	mapped_file(const mapped_file&)			   = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+	~mapped_file();
+
+	[[nodiscard]] std::span<const std::byte> bytes() const { return {m_data, m_size}; }
+
+private:
+
+	mapped_file() = default;
+	void unmap();
+
+	const std::byte* m_data = nullptr;
+	std::size_t		 m_size = 0;
+#if defined(_WIN32)
+	void* m_mapping = nullptr; // File mapping handle
+#endif
+};
+
+/**
+ * @brief Interleaved PCM frames viewed in place (a mapped file, a buffer...) : nothing is copied.
+ *
+ */
+struct pcm_stream
+{
+	audio_ctx				   m_context;
+	pcm_encoding			   m_encoding = pcm_encoding::int16;
+	std::span<const std::byte> m_data; // Whole frames
+
+	[[nodiscard]] std::size_t frame_bytes() const { return sample_bytes(m_encoding) * m_context.m_channel_num; }
+	[[nodiscard]] std::size_t frame_count() const { return m_data.size() / frame_bytes(); }
+};
+
+/**
+ * @brief Parse a WAV file (PCM, IEEE float or extensible) : its context, encoding and data chunk.
+ *
+ * A data chunk longer than the file (stream written without its final size) is cut to the whole frames present.
+ *
+ * @param file Bytes of the whole file
+ * @return std::optional<pcm_stream> View of the samples, std::nullopt for a malformed file, an unsupported
+ * encoding, sample rate or channel count, or a big-endian host
+ */
+std::optional<pcm_stream> parse_wav(std::span<const std::byte> file);
+
+/**
+ * @brief View raw headerless PCM, whose context and encoding are known by the caller.
+ *
+ * A trailing partial frame is ignored.
+ *
+ */
+pcm_stream raw_pcm(std::span<const std::byte> data, audio_ctx context, pcm_encoding encoding);
+
+/**
+ * @brief WAV file written by large blocks, its sizes patched on close().
+ *
+ * Sizes above the 4 GiB limit of RIFF are saturated (readers then cut the data at the end of the file).
+ *
+ */
+class wav_writer
+{
+public:
+
+	/**
+     * @brief Create (or truncate) a WAV file, header included.
+     *
+     * @return std::optional<wav_writer> The writer, std::nullopt if the file can not be created
+     */
+	static std::optional<wav_writer> create(const std::filesystem::path& path, audio_ctx context, pcm_encoding encoding);
+
+	wav_writer(wav_writer&&) noexcept			 = default;
+	wav_writer& operator=(wav_writer&&) noexcept = default;
+	~wav_writer() { close(); }
+
+	/**
+     * @brief Append samples : buffered, written by block_bytes blocks.
+     *
+     * @return false Write error
+     */
+	bool write(std::span<const std::byte> samples);
+
+	/**
+     * @brief Write the last block and patch the sizes of the header. Called by the destructor.
+     *
+     * @return false Write error (now or before)
+     */
+	bool close();
+
+	[[nodiscard]] std::uint64_t data_bytes() const { return m_data_bytes; }
+
+private:
+
+	wav_writer() = default;
+	bool flush_block();
+
+	static constexpr std::size_t block_bytes = std::size_t{1} << 20U;
+
+	std::ofstream		   m_file;
+	std::vector<std::byte> m_block;
+	std::uint64_t		   m_data_bytes = 0;
+	bool				   m_failed		= false;
+};
@@ -0,0 +1,926 @@
+/**
+ * @file audio_mixer.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-10-28
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "audio_queue.h"
+#include "polyphase.h"
+#include "realtime.h"
+#include "shared_audio_queue.h"
+#include "sample_convert.h"
+#include "work_pool.h"
+
+/**
+ * @brief Render thread configuration.
+ *
+ */
+struct render_config
+{
+	std::size_t			   m_period_frame	   = 480;	// Frames mixed per period (10 ms at 48 KHz)
+	std::size_t			   m_output_latency_ms = 100;	// Capacity of the output ring (in latency, ms)
+	bool				   m_realtime_priority = false; // Request SCHED_FIFO (or the platform equivalent)
+	int					   m_priority		   = 80;	// Real-time priority, if requested
+	std::optional<unsigned> m_cpu_core;					// Core to pin the render thread to
+	std::vector<unsigned>  m_worker_cores;				// Cores of the mix pool workers, one each (with m_realtime_priority)
+};
+
+/**
+ * @brief Limiter of the mixed sum, before its conversion to the output sample type.
+ *
+ */
+enum class limiter_mode
+{
+	clamp,	   // Hard clip at full scale
+	soft_knee  // soft_limit() : untouched below the knee, smooth above
+};
+
+/**
+ * @brief Output stage of the mixer : the only place where the float sum of the inputs is limited and quantized.
+ *
+ */
+struct output_stage
+{
+	limiter_mode m_limiter = limiter_mode::soft_knee;
+	float		 m_knee	   = 0.9F;	// Soft knee start, about -1 dBFS
+	bool		 m_dither  = false; // TPDF dither of integer outputs (16-bit, 24-bit, 8-bit)
+};
+
+/**
+ * @brief Render thread timing statistics.
+ *
+ */
+struct render_stats
+{
+	std::uint64_t			 m_periods		   = 0; // Periods rendered
+	std::uint64_t			 m_deadline_misses = 0; // Periods finished after the next period boundary
+	std::uint64_t			 m_output_overruns = 0; // Periods dropped because the output ring was full
+	std::chrono::nanoseconds m_max_jitter{0};		// Worst wake-up delay after a period boundary
+	std::chrono::nanoseconds m_mean_jitter{0};		// Mean wake-up delay after a period boundary
+};
+
+/**
+ * @brief MPMC audio mixer : N input queues summed into one output stream.
+ *
+ * Producers push into their own input queue (any input context, converted by the queue).
+ * A mix pass pops every input as float, accumulates them with their gain and pan in one float buffer
+ * (full headroom : the sum does not depend on the input order), then limits and converts it once
+ * to the output sample type (see output_stage).
+ *
+ * Inputs at another sample rate can stay at their own rate in their queue (add_input(sample_rate, ...)) : the mix
+ * pass then resamples all the inputs of a (rate, quality) group in one batch_resampler call, with one shared filter table.
+ *
+ * Inputs are added and removed from control threads, concurrently with the mix pass,
+ * which never blocks on them. A mix pass can be shared by a pool of worker threads
+ * (thread_count), with the same result as a single-threaded pass. Mix passes themselves must not run concurrently : either call
+ * mix() from one thread, or start() the render thread and read() its output.
+ *
+ * @tparam AudioType Sample type of the producers and of the mixed output
+ */
+template<audio_sample_type AudioType>
+class audio_mixer
+{
+public:
+
+	/**
+     * @brief Construct a mixer.
+     *
+     * @param output_ctx Output audio context, also the expected context of every input queue
+     * @param max_inputs Maximum number of simultaneous inputs
+     * @param input_latency_ms Capacity of each input queue (in latency, ms)
+     * @param thread_count Threads sharing each mix pass, the mixing thread included
+     */
+	audio_mixer(audio_ctx	output_ctx,
+				std::size_t max_inputs		 = default_max_inputs,
+				std::size_t input_latency_ms = default_latency_ms,
+				std::size_t thread_count	 = 1)
+		: m_output_context(output_ctx),
+		  m_input_latency_ms(input_latency_ms),
+		  m_max_inputs(max_inputs),
+		  m_slots(std::make_unique<input_slot[]>(max_inputs)),
+		  m_accumulator(mix_block_frame * static_cast<std::size_t>(output_ctx.m_channel_num)),
+		  m_group_count(std::max<std::size_t>((max_inputs + group_inputs - 1) / group_inputs, 1)),
+		  m_partials(m_group_count * m_accumulator.size()),
+		  m_group_complete(std::make_unique<bool[]>(m_group_count))
+	{
+		if (thread_count > 1)
+			m_pool = std::make_unique<work_pool>(thread_count);
+	}
+
+	/* A mixer is shared by reference between producers, control and render threads */
+	audio_mixer(const audio_mixer&)			   = delete;
+	audio_mixer(audio_mixer&&)				   = delete;
+	audio_mixer& operator=(const audio_mixer&) = delete;
+	audio_mixer& operator=(audio_mixer&&)	   = delete;
+
+	~audio_mixer() { stop(); }
+
+	/**
+     * @brief Register a new input.
+     *
+     * @param quality Resampling quality / cost tier of the input (cheap tiers for voice or monitoring feeds)
+     * @return std::optional<std::size_t> Input id, std::nullopt if max_inputs are already registered
+     */
+	std::optional<std::size_t> add_input(resample_quality quality = resample_quality::best)
+	{
+		std::scoped_lock lock(m_control);
+		const auto		 id = free_slot();
+		if (!id)
+			return std::nullopt;
+
+		m_slots[*id].m_input = std::make_unique<input>(m_output_context, m_input_latency_ms, quality);
+		m_slots[*id].m_active.store(true, std::memory_order_seq_cst);
+		return id;
+	}
+
+	/**
+     * @brief Register a new input whose audio stays at its own sample rate until the mix pass.
+     *
+     * The queue of the input expects input_rate (and the output channel layout). Every mix pass resamples the inputs
+     * of the same (input_rate, quality) together : one batch_resampler per group, one polyphase table per group,
+     * the kernel running across the streams. Such an input keeps the shared position of its group : a short queue
+     * is padded with silence, and its queue does no drift compensation of its own.
+     *
+     * @param input_rate Sample rate pushed by the producer (the output rate falls back to add_input(quality))
+     * @param quality Filter tier of the group
+     * @return std::optional<std::size_t> Input id, std::nullopt if max_inputs are already registered
+     */
+	std::optional<std::size_t> add_input(sample_rate input_rate, resample_quality quality = resample_quality::best)
+	{
+		if (input_rate == m_output_context.m_sample_rate)
+			return add_input(quality);
+
+		std::scoped_lock lock(m_control);
+		const auto		 id = free_slot();
+		if (!id)
+			return std::nullopt;
+
+		auto&			  group	   = resample_group_for(input_rate, quality);
+		const std::size_t channels = m_output_context.m_channel_num;
+		const auto		  block	   = static_cast<std::size_t>(std::ranges::find(group.m_taken, false) - group.m_taken.begin());
+		group.m_taken[block]	   = true;
+		group.publish_lanes(channels);
+
+		audio_ctx queue_context		= m_output_context;
+		queue_context.m_sample_rate = input_rate;
+
+		auto in			 = std::make_unique<input>(queue_context, m_input_latency_ms, quality);
+		in->m_group		 = &group;
+		in->m_first_lane = block * channels;
+
+		m_slots[*id].m_input = std::move(in);
+		m_slots[*id].m_active.store(true, std::memory_order_seq_cst);
+		return id;
+	}
+
+	/**
+     * @brief Register a new input whose queue is shared with a producer process, under a segment name.
+     *
+     * The mixer creates the segment (output context, input latency) as its consumer, the producer process attaches
+     * with shared_audio_queue<T>::open(name, shared_queue_role::producer) and pushes straight into the ring the mix pass
+     * pops from. Each mix pass wakes a producer waiting for room. remove_input() detaches and removes the name.
+     *
+     * @param name Segment name, unique on the machine
+     * @param quality Resampling quality of the mixer side (the producer chooses its own)
+     * @return std::optional<std::size_t> Input id, std::nullopt if max_inputs are already registered or the segment can not be created
+     */
+	std::optional<std::size_t> add_shared_input(std::string_view name, resample_quality quality = resample_quality::best)
+	{
+		std::scoped_lock lock(m_control);
+		const auto		 id = free_slot();
+		if (!id)
+			return std::nullopt;
+
+		auto shared = shared_audio_queue<AudioType>::create(name, shared_queue_role::consumer, m_output_context, m_input_latency_ms, quality);
+		if (!shared)
+			return std::nullopt;
+
+		m_slots[*id].m_input = std::make_unique<input>(std::move(shared));
+		m_slots[*id].m_active.store(true, std::memory_order_seq_cst);
+		return id;
+	}
+
+	/**
+     * @brief Shared queue of an input of add_shared_input() : producer liveness, waits.
+     *
+     * @return shared_audio_queue<AudioType>* The queue, nullptr for an unknown or not shared input. Owned by the mixer,
+     * valid until remove_input(id) : the caller stops using it before removing the input.
+     */
+	shared_audio_queue<AudioType>* shared_input(std::size_t id)
+	{
+		std::scoped_lock lock(m_control);
+		if (id >= m_max_inputs || !m_slots[id].m_active.load(std::memory_order_relaxed))
+			return nullptr;
+		return m_slots[id].m_input->m_shared.get();
+	}
+
+	/**
+     * @brief Unregister an input and destroy its queue, once no mix pass can still use it.
+     *
+     * @param id Input id
+     * @return true Input removed
+     * @return false Unknown input
+     */
+	bool remove_input(std::size_t id)
+	{
+		std::scoped_lock lock(m_control);
+		if (id >= m_max_inputs || !m_slots[id].m_active.load(std::memory_order_relaxed))
+			return false;
+
+		m_slots[id].m_active.store(false, std::memory_order_seq_cst);
+
+		// A pass running now may have seen the input active : wait for it to end.
+		if (const auto pass = m_pass.load(std::memory_order_seq_cst); (pass & 1U) != 0)
+			while (m_pass.load(std::memory_order_acquire) == pass)
+				std::this_thread::yield();
+
+		if (auto* group = m_slots[id].m_input->m_group)
+		{
+			group->m_taken[m_slots[id].m_input->m_first_lane / m_output_context.m_channel_num] = false;
+			group->publish_lanes(m_output_context.m_channel_num);
+		}
+		m_slots[id].m_input.reset();
+		return true;
+	}
+
+	/**
+     * @brief Queue of an input, where its producer pushes audio.
+     *
+     * @param id Input id
+     * @return audio_queue<AudioType>* The queue, nullptr for an unknown input. Owned by the mixer, valid until
+     * remove_input(id) : its producer stops pushing before the input is removed.
+     * Its context() is the output context, or the input rate of add_input(sample_rate, ...).
+     */
+	audio_queue<AudioType>* input_queue(std::size_t id)
+	{
+		std::scoped_lock lock(m_control);
+		if (id >= m_max_inputs || !m_slots[id].m_active.load(std::memory_order_relaxed))
+			return nullptr;
+		return &m_slots[id].m_input->m_queue;
+	}
+
+	/**
+     * @brief Ramp the linear gain of an input to a new value, a fade is a long ramp.
+     *
+     * @param ramp_frames Length of the ramp, in frames (0 : immediate)
+     */
+	void set_gain(std::size_t id, float gain, std::size_t ramp_frames = mix_control::default_ramp_frame)
+	{
+		std::scoped_lock lock(m_control); // remove_input() may free the input meanwhile
+		if (id < m_max_inputs && m_slots[id].m_active.load(std::memory_order_relaxed))
+			m_slots[id].m_input->m_queue.control().set_gain(gain, ramp_frames);
+	}
+
+	/**
+     * @brief Ramp the pan of an input to a new position, -1 (left) to 1 (right).
+     *
+     * @param ramp_frames Length of the ramp, in frames (0 : immediate)
+     */
+	void set_pan(std::size_t id, float pan, std::size_t ramp_frames = mix_control::default_ramp_frame)
+	{
+		std::scoped_lock lock(m_control);
+		if (id < m_max_inputs && m_slots[id].m_active.load(std::memory_order_relaxed))
+			m_slots[id].m_input->m_queue.control().set_pan(pan, ramp_frames);
+	}
+
+	/**
+     * @brief Mute or unmute an input. A muted input is still drained.
+     *
+     */
+	void set_mute(std::size_t id, bool mute)
+	{
+		std::scoped_lock lock(m_control);
+		if (id < m_max_inputs && m_slots[id].m_active.load(std::memory_order_relaxed))
+			m_slots[id].m_input->m_mute.store(mute, std::memory_order_relaxed);
+	}
+
+	/**
+     * @brief Set the limiter and dither of the mixed sum. Not available while the render thread runs.
+     *
+     * @return false The render thread owns the output stage
+     */
+	bool set_output_stage(const output_stage& stage)
+	{
+		if (m_render.joinable())
+			return false;
+
+		m_output_stage = stage;
+		return true;
+	}
+
+	/**
+     * @brief Current limiter and dither of the mixed sum.
+     *
+     */
+	[[nodiscard]]
+	const output_stage& output() const { return m_output_stage; }
+
+	/**
+     * @brief Mix one output period of every active input.
+     *
+     * The output buffer is overwritten. Inputs running short contribute what they have.
+     * Not available while the render thread runs.
+     *
+     * @param output_buffer Output buffer array (output context)
+     * @param frame_count Output buffer frame count
+     * @return true Every active input delivered the whole period
+     * @return false At least one active input ran short (or the render thread owns the mix)
+     */
+	bool mix(AudioType* output_buffer, std::size_t frame_count)
+	{
+		if (m_render.joinable())
+			return false;
+
+		const std::size_t total_samples = frame_count * m_output_context.m_channel_num;
+		bool			  complete		= true;
+
+		for (std::size_t mixed = 0; mixed < total_samples; mixed += m_accumulator.size())
+		{
+			const auto accumulator = std::span{m_accumulator}.first(std::min(m_accumulator.size(), total_samples - mixed));
+
+			complete &= mix_block(accumulator);
+			quantize(accumulator, std::span{output_buffer + mixed, accumulator.size()}, m_dither);
+		}
+
+		return complete;
+	}
+
+	/**
+     * @brief Start the render thread : one mix pass per period, published into the output ring.
+     *
+     * The thread wakes at each period boundary of the output sample rate, independently of when
+     * consumers read. Consumers get the mixed stream with read().
+     *
+     * The output ring of a previous start() is kept (emptied) if its size is unchanged. A resized ring replaces it,
+     * the old one stays allocated until the mixer is destroyed : a consumer may still be reading it.
+     *
+     * @param config Period, output ring size and scheduling options
+     * @return true Render thread started
+     * @return false Already running, or the output latency can not hold one period
+     */
+	bool start(const render_config& config = {})
+	{
+		if (m_render.joinable())
+			return false;
+
+		const std::size_t channels		 = m_output_context.m_channel_num;
+		const std::size_t capacity		 = channels * (m_output_context.m_sample_rate * config.m_output_latency_ms / 1000);
+		const std::size_t period_samples = std::max<std::size_t>(config.m_period_frame, 1) * channels;
+		if (capacity < period_samples) // Every period would be dropped as an overrun
+			return false;
+
+		if (auto* ring = m_output.load(std::memory_order_relaxed); ring != nullptr && ring->capacity() == capacity)
+			ring->discard(ring->size());
+		else
+		{
+			m_output_rings.push_back(std::make_unique<audio_ring>(capacity));
+			m_output.store(m_output_rings.back().get(), std::memory_order_release);
+		}
+
+		m_periods.store(0, std::memory_order_relaxed);
+		m_deadline_misses.store(0, std::memory_order_relaxed);
+		m_output_overruns.store(0, std::memory_order_relaxed);
+		m_jitter_max_ns.store(0, std::memory_order_relaxed);
+		m_jitter_sum_ns.store(0, std::memory_order_relaxed);
+
+		m_render = std::jthread([this, config](std::stop_token stop) { render_loop(stop, config); });
+		return true;
+	}
+
+	/**
+     * @brief Stop the render thread and wait for its end.
+     *
+     */
+	void stop()
+	{
+		if (!m_render.joinable())
+			return;
+
+		m_render.request_stop();
+		m_render.join();
+	}
+
+	/**
+     * @brief Read the mixed stream published by the render thread, from any number of consumer threads.
+     *
+     * @param output_buffer Output buffer array (output context), overwritten. Missing frames are silent.
+     * @param frame_count Output buffer frame count
+     * @return true The whole period was available
+     * @return false The output ring ran short (or the render thread was never started)
+     */
+	bool read(AudioType* output_buffer, std::size_t frame_count)
+	{
+		audio_ring* ring = m_output.load(std::memory_order_acquire);
+		if (ring == nullptr)
+			return false;
+
+		const std::size_t				channels	  = m_output_context.m_channel_num;
+		const std::size_t				total_samples = frame_count * channels;
+		const std::size_t				block_samples = read_block_sample / channels * channels; // Whole frames
+		std::array<float, read_block_sample> block;
+
+		// Consumers may read concurrently : each thread dithers with a generator of its own.
+		thread_local tpdf_dither dither(static_cast<std::uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())));
+
+		std::size_t popped = 0;
+		while (popped < total_samples)
+		{
+			const auto output_block = std::span{output_buffer + popped, std::min(block_samples, total_samples - popped)};
+			const auto block_popped = ring->read(block.data(), output_block.size(), channels);
+
+			// Silence where the ring ran short
+			std::fill(block.begin() + static_cast<std::ptrdiff_t>(block_popped), block.begin() + static_cast<std::ptrdiff_t>(output_block.size()), 0.0F);
+			quantize(std::span{block}.first(output_block.size()), output_block, dither);
+
+			popped += output_block.size();
+			if (block_popped != output_block.size())
+			{
+				std::ranges::fill(std::span{output_buffer + popped, total_samples - popped}, convert_silence());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+     * @brief Render thread timing statistics, since the last start().
+     *
+     */
+	[[nodiscard]]
+	render_stats stats() const
+	{
+		render_stats snapshot;
+		snapshot.m_periods		   = m_periods.load(std::memory_order_relaxed);
+		snapshot.m_deadline_misses = m_deadline_misses.load(std::memory_order_relaxed);
+		snapshot.m_output_overruns = m_output_overruns.load(std::memory_order_relaxed);
+		snapshot.m_max_jitter	   = std::chrono::nanoseconds(m_jitter_max_ns.load(std::memory_order_relaxed));
+		if (snapshot.m_periods != 0)
+			snapshot.m_mean_jitter = std::chrono::nanoseconds(m_jitter_sum_ns.load(std::memory_order_relaxed) / snapshot.m_periods);
+		return snapshot;
+	}
+
+	/**
+     * @brief Output audio context of the mixer.
+     *
+     */
+	[[nodiscard]]
+	const audio_ctx& context() const { return m_output_context; }
+
+private:
+
+	struct resample_group;
+
+	/**
+     * @brief A registered input : its queue and mix parameters.
+     *
+     */
+	struct input
+	{
+		input(audio_ctx ctx, std::size_t latency_ms, resample_quality quality)
+			: m_owned(std::make_unique<audio_queue<AudioType>>(ctx, latency_ms, quality)),
+			  m_queue(*m_owned)
+		{}
+
+		explicit input(std::unique_ptr<shared_audio_queue<AudioType>> shared)
+			: m_shared(std::move(shared)),
+			  m_queue(m_shared->queue())
+		{}
+
+		std::unique_ptr<audio_queue<AudioType>>		   m_owned;	 // Queue of the input, or
+		std::unique_ptr<shared_audio_queue<AudioType>> m_shared; // its ring in memory shared with a producer process
+		audio_queue<AudioType>&						   m_queue;	 // Gain and pan in its control()
+		std::atomic<bool>	   m_mute{false};
+
+		// Inputs resampled by group (set before activation, then only touched by the mix pass)
+		resample_group*		   m_group		= nullptr;
+		std::size_t			   m_first_lane = 0;	 // First of its channels lanes in the group
+		bool				   m_fresh		= true;	 // Lane history not cleared yet
+		bool				   m_gathered	= false; // Popped into the group for the current block
+		bool				   m_complete	= true;	 // Its queue delivered the whole block
+	};
+
+	/**
+     * @brief Inputs of the same (input rate, quality) : one batch of lanes, channels lanes per input.
+     *
+     */
+	struct resample_group
+	{
+		resample_group(std::size_t index, sample_rate rate, resample_quality quality, std::uint32_t output_rate, std::size_t max_inputs, std::size_t channels,
+					   std::size_t max_frames)
+			: m_index(index),
+			  m_input_rate(rate),
+			  m_quality(quality),
+			  m_batch(polyphase_filter::shared(rate, output_rate, quality), max_inputs * channels, max_frames),
+			  m_taken(max_inputs, false)
+		{}
+
+		/**
+         * @brief Lanes up to the last block taken, for the next mix passes (m_control held) : removed inputs past it cost nothing.
+         *
+         */
+		void publish_lanes(std::size_t channels)
+		{
+			const auto last = std::ranges::find(m_taken.rbegin(), m_taken.rend(), true);
+			m_lanes.store(static_cast<std::size_t>(m_taken.rend() - last) * channels, std::memory_order_release);
+		}
+
+		std::size_t				 m_index; // In m_resample_groups
+		sample_rate				 m_input_rate;
+		resample_quality		 m_quality;
+		batch_resampler			 m_batch;
+		std::vector<bool>		 m_taken;	// Lane block of each input, guarded by m_control
+		std::atomic<std::size_t> m_lanes{0}; // Lanes up to the last block taken, published to the mix pass
+		std::size_t				 m_block_input = 0; // Input frames of the current block (mix pass)
+	};
+
+	/**
+     * @brief Registry slot, m_input is only touched by the mix pass while m_active is set.
+     *
+     */
+	struct input_slot
+	{
+		std::unique_ptr<input> m_input;
+		std::atomic<bool>	   m_active{false};
+	};
+
+	/**
+     * @brief One mix pass over a block : sum of every active input with its gain, then the limiter.
+     *
+     * Inputs are summed by fixed groups of group_inputs ids (one partial sum each, spread over the pool),
+     * then partial sums are merged by a pairwise tree of fixed shape. Groups and tree only depend on
+     * max_inputs : the result is bit for bit the same whatever the thread count.
+     *
+     * @param accumulator Float block to fill (at most m_accumulator.size() samples)
+     * @return true Every active input delivered the whole block
+     */
+	bool mix_block(std::span<float> accumulator)
+	{
+		m_pass.fetch_add(1, std::memory_order_seq_cst); // Odd : pass running
+
+		const std::size_t block_size = accumulator.size();
+		const auto		  partial	 = [&](std::size_t group) { return std::span{m_partials}.subspan(group * m_accumulator.size(), block_size); };
+
+		if (const std::size_t resample_groups = m_resample_group_count.load(std::memory_order_acquire); resample_groups != 0)
+			resample_block(resample_groups, block_size / m_output_context.m_channel_num);
+
+		for_each_group(m_group_count, [&](std::size_t group) { m_group_complete[group] = mix_group(group, partial(group)); });
+
+		// Pairwise tree : partial[i] += partial[i + stride], stride doubling up to the root.
+		for (std::size_t stride = 1; stride < m_group_count; stride *= 2)
+			for_each_group((m_group_count + (2 * stride) - 1) / (2 * stride), [&](std::size_t pair)
+			{
+				const std::size_t left = pair * 2 * stride;
+				if (left + stride >= m_group_count)
+					return;
+
+				const auto sum	 = partial(left);
+				const auto other = partial(left + stride);
+				for (std::size_t i = 0; i < block_size; ++i)
+					sum[i] += other[i];
+			});
+
+		std::ranges::copy(partial(0), accumulator.begin());
+
+		// One limiter for the whole mix, on the sum of every input (integer conversions clamp by themselves).
+		if (m_output_stage.m_limiter == limiter_mode::soft_knee)
+			soft_limit(accumulator, m_output_stage.m_knee);
+		else if constexpr (std::is_floating_point_v<AudioType>)
+			for (auto& sample : accumulator)
+				sample = std::clamp(sample, -1.0F, 1.0F);
+
+		m_pass.fetch_add(1, std::memory_order_release); // Even : no pass running
+		return std::all_of(m_group_complete.get(), m_group_complete.get() + m_group_count, [](bool complete) { return complete; });
+	}
+
+	/**
+     * @brief Partial sum of one group of inputs, in input id order.
+     *
+     * @param group Group index
+     * @param partial Float block to fill
+     * @return true Every active input of the group delivered the whole block
+     */
+	bool mix_group(std::size_t group, std::span<float> partial)
+	{
+		bool complete = true;
+
+		std::ranges::fill(partial, 0.0F);
+		for (std::size_t id = group * group_inputs; id < std::min(m_max_inputs, (group + 1) * group_inputs); ++id)
+		{
+			auto& slot = m_slots[id];
+			if (!slot.m_active.load(std::memory_order_seq_cst))
+				continue;
+
+			auto& in = *slot.m_input;
+			if (in.m_group)
+			{
+				complete &= mix_resampled(in, partial);
+				continue;
+			}
+
+			// Accumulated straight from the input queue with its gain and pan ramps, a muted input is only drained.
+			const std::size_t popped = in.m_mute.load(std::memory_order_relaxed)
+										 ? in.m_queue.discard(partial.size())
+										 : in.m_queue.pop_add(partial);
+			complete &= popped == partial.size();
+
+			if (in.m_shared)
+				in.m_shared->signal_space();
+		}
+		return complete;
+	}
+
+	/**
+     * @brief Resample the grouped inputs for a block : pop every input of a group into its lanes, then one batch per group.
+     *
+     * Groups created after the pass started, and inputs activated after their group was gathered, wait for the next block.
+     *
+     * @param resample_groups Groups published when the pass started
+     * @param frames Output frames of the block
+     */
+	void resample_block(std::size_t resample_groups, std::size_t frames)
+	{
+		for (std::size_t index = 0; index < resample_groups; ++index)
+			m_resample_groups[index]->m_block_input = m_resample_groups[index]->m_batch.input_frames_for(frames);
+
+		// Pops, by the same groups of ids as the mix : each input writes its own lanes.
+		for_each_group(m_group_count, [&](std::size_t group)
+		{
+			for (std::size_t id = group * group_inputs; id < std::min(m_max_inputs, (group + 1) * group_inputs); ++id)
+			{
+				auto& slot = m_slots[id];
+				if (!slot.m_active.load(std::memory_order_seq_cst))
+					continue;
+
+				auto& in = *slot.m_input;
+				if (in.m_group && in.m_group->m_index < resample_groups)
+					gather(in);
+			}
+		});
+
+		// Lane ranges of a group are independent : spread over the pool, then one shared step forward.
+		for (std::size_t index = 0; index < resample_groups; ++index)
+		{
+			auto&			  batch = m_resample_groups[index]->m_batch;
+			const std::size_t lanes = m_resample_groups[index]->m_lanes.load(std::memory_order_acquire);
+			for_each_group((lanes + resample_chunk_lane - 1) / resample_chunk_lane,
+						   [&](std::size_t chunk) { batch.process(frames, chunk * resample_chunk_lane, resample_chunk_lane); });
+			batch.advance(frames);
+		}
+	}
+
+	/**
+     * @brief Pop the input frames of the block of a grouped input into its lanes, silence where it runs short.
+     *
+     */
+	void gather(input& in)
+	{
+		auto&			  group	   = *in.m_group;
+		const std::size_t channels = m_output_context.m_channel_num;
+		const std::size_t frames   = group.m_block_input;
+
+		if (in.m_fresh)
+		{
+			for (std::size_t channel = 0; channel < channels; ++channel)
+				group.m_batch.clear_lane(in.m_first_lane + channel);
+			in.m_fresh = false;
+		}
+
+		std::array<float, gather_tile_sample> tile;
+		const std::size_t					  tile_frames = tile.size() / channels;
+
+		in.m_complete = true;
+		for (std::size_t done = 0; done < frames; done += tile_frames)
+		{
+			const std::size_t count	 = std::min(tile_frames, frames - done);
+			const std::size_t popped = in.m_complete ? in.m_queue.pop_float(std::span{tile}.first(count * channels)) : 0;
+			std::fill(tile.begin() + static_cast<std::ptrdiff_t>(popped), tile.begin() + static_cast<std::ptrdiff_t>(count * channels), 0.0F);
+			in.m_complete &= popped == count * channels;
+
+			// Channel by channel : a few samples per frame are not worth a copy call
+			for (std::size_t channel = 0; channel < channels; ++channel)
+				for (std::size_t frame = 0; frame < count; ++frame)
+					group.m_batch.input(done + frame)[in.m_first_lane + channel] = tile[(frame * channels) + channel];
+		}
+		in.m_gathered = true;
+	}
+
+	/**
+     * @brief Accumulate the resampled block of a grouped input with its gain and pan ramps.
+     *
+     * @return true The input delivered the whole block
+     */
+	bool mix_resampled(input& in, std::span<float> partial)
+	{
+		if (!in.m_gathered) // Activated during this pass
+			return true;
+		in.m_gathered = false;
+
+		if (in.m_mute.load(std::memory_order_relaxed))
+			return in.m_complete;
+
+		const std::size_t channels = m_output_context.m_channel_num;
+		const std::size_t frames   = partial.size() / channels;
+		const auto&		  batch	   = in.m_group->m_batch;
+		const auto		  gains	   = in.m_queue.control().begin();
+
+		// Lanes of the input back to interleaved frames by tiles, then one accumulation pass per tile.
+		std::array<float, gather_tile_sample> tile;
+		const std::size_t					  tile_frames = tile.size() / channels;
+		for (std::size_t done = 0; done < frames; done += tile_frames)
+		{
+			const std::size_t count = std::min(tile_frames, frames - done);
+			for (std::size_t channel = 0; channel < channels; ++channel)
+				for (std::size_t frame = 0; frame < count; ++frame)
+					tile[(frame * channels) + channel] = batch.output(done + frame)[in.m_first_lane + channel];
+			gains.accumulate(&partial[done * channels], tile.data(), done, count);
+		}
+
+		in.m_queue.control().end(frames);
+		return in.m_complete;
+	}
+
+	/**
+     * @brief First free input id (m_control held).
+     *
+     */
+	std::optional<std::size_t> free_slot() const
+	{
+		for (std::size_t id = 0; id < m_max_inputs; ++id)
+			if (!m_slots[id].m_active.load(std::memory_order_relaxed))
+				return id;
+		return std::nullopt;
+	}
+
+	/**
+     * @brief Group of a (rate, quality), created on first use (m_control held). Groups live as long as the mixer.
+     *
+     */
+	resample_group& resample_group_for(sample_rate rate, resample_quality quality)
+	{
+		const std::size_t count = m_resample_group_count.load(std::memory_order_relaxed);
+		for (std::size_t index = 0; index < count; ++index)
+			if (m_resample_groups[index]->m_input_rate == rate && m_resample_groups[index]->m_quality == quality)
+				return *m_resample_groups[index];
+
+		m_resample_groups[count] = std::make_unique<resample_group>(count, rate, quality, m_output_context.m_sample_rate, m_max_inputs,
+																	m_output_context.m_channel_num, mix_block_frame);
+		m_resample_group_count.store(count + 1, std::memory_order_release);
+		return *m_resample_groups[count];
+	}
+
+	/**
+     * @brief Run body(index) for every index of [0, count), over the pool if any.
+     *
+     */
+	template <typename Body>
+	void for_each_group(std::size_t count, Body&& body)
+	{
+		if (m_pool)
+			m_pool->parallel_for(count, body);
+		else
+			for (std::size_t index = 0; index < count; ++index)
+				body(index);
+	}
+
+	/**
+     * @brief Render thread body : sleep until each period boundary, mix, publish.
+     *
+     */
+	void render_loop(std::stop_token stop, render_config config)
+	{
+		// The workers of the pool join every mix pass : they get the same priority, or would hold the thread back.
+		if (config.m_realtime_priority)
+		{
+			realtime::promote_current_thread(config.m_priority);
+			if (m_pool)
+				m_pool->promote_workers(config.m_priority, config.m_worker_cores);
+		}
+		if (config.m_cpu_core)
+			realtime::pin_current_thread(*config.m_cpu_core);
+
+		using clock = std::chrono::steady_clock;
+
+		const std::uint64_t rate		   = m_output_context.m_sample_rate;
+		const std::uint64_t period_frame   = std::max<std::size_t>(config.m_period_frame, 1);
+		const std::size_t	period_samples = period_frame * m_output_context.m_channel_num;
+
+		// Boundary of a period, from its index : rounding never accumulates.
+		const auto start		= clock::now();
+		const auto boundary_of	= [&](std::uint64_t period) { return start + std::chrono::nanoseconds(period * period_frame * 1'000'000'000ULL / rate); };
+		const auto period_after = [&](clock::time_point time) { return (static_cast<std::uint64_t>((time - start).count()) * rate / (period_frame * 1'000'000'000ULL)) + 1; };
+
+		std::vector<float> period_block(period_samples);
+		audio_ring&		   ring = *m_output.load(std::memory_order_relaxed);
+
+		for (std::uint64_t period = 1; !stop.stop_requested();)
+		{
+			const auto deadline = boundary_of(period);
+			std::this_thread::sleep_until(deadline);
+
+			const auto jitter = static_cast<std::uint64_t>(std::max<std::int64_t>((clock::now() - deadline).count(), 0));
+			m_jitter_sum_ns.fetch_add(jitter, std::memory_order_relaxed);
+			if (jitter > m_jitter_max_ns.load(std::memory_order_relaxed))
+				m_jitter_max_ns.store(jitter, std::memory_order_relaxed);
+
+			for (std::size_t mixed = 0; mixed < period_samples; mixed += m_accumulator.size())
+				mix_block(std::span{period_block}.subspan(mixed, std::min(m_accumulator.size(), period_samples - mixed)));
+
+			// The ring keeps whole periods only : a full ring drops this one.
+			if (ring.free() >= period_samples)
+				ring.write(period_block.data(), period_samples);
+			else
+				m_output_overruns.fetch_add(1, std::memory_order_relaxed);
+
+			m_periods.fetch_add(1, std::memory_order_relaxed);
+
+			// Work done after the next boundary : the deadline is missed, skip to the next boundary ahead.
+			++period;
+			if (const auto done = clock::now(); done > boundary_of(period))
+			{
+				m_deadline_misses.fetch_add(1, std::memory_order_relaxed);
+				period = period_after(done);
+			}
+		}
+	}
+
+	/**
+     * @brief Limited float samples to the output sample type, dithered if enabled.
+     *
+     */
+	void quantize(std::span<float> limited, std::span<AudioType> output, tpdf_dither& dither) const
+	{
+		if (m_output_stage.m_dither)
+			dither.template apply<AudioType>(limited);
+		convert_from_float(std::span<const float>{limited}, output);
+	}
+
+	/**
+     * @brief Output sample value of silence.
+     *
+     */
+	static AudioType convert_silence()
+	{
+		return make_audio_converters<AudioType>().second(0.0F);
+	}
+
+	static constexpr std::size_t default_max_inputs = 64;
+	static constexpr std::size_t default_latency_ms = 200;
+	static constexpr std::size_t mix_block_frame	= 1024; // Frames accumulated per mix step
+	static constexpr std::size_t read_block_sample	= 1024; // Samples converted per read step
+	static constexpr std::size_t group_inputs		= 8;	// Inputs summed per partial sum
+	static constexpr std::size_t gather_tile_sample = 2048; // Samples popped per step into the lanes of a group
+	static constexpr std::size_t resample_chunk_lane = 4 * batch_resampler::lane_tile; // Lanes per resampling task
+	static constexpr std::size_t max_resample_groups = sample_rate::count * 5;		   // Input rates x quality tiers
+
+	audio_ctx	m_output_context;
+	std::size_t m_input_latency_ms;
+	std::size_t m_max_inputs;
+
+	std::unique_ptr<input_slot[]> m_slots;
+	std::mutex					  m_control;  // Serializes add / remove and the control calls on inputs
+	std::atomic<std::size_t>	  m_pass{0}; // Mix passes started + ended
+
+	std::vector<float> m_accumulator; // Float sum of one block
+	output_stage	   m_output_stage;
+	tpdf_dither		   m_dither; // Of mix(), read() has one per consumer thread
+
+	// Parallel mix : one partial sum and completion flag per group of inputs
+	std::size_t				   m_group_count;
+	std::vector<float>		   m_partials;
+	std::unique_ptr<bool[]>	   m_group_complete;
+	std::unique_ptr<work_pool> m_pool; // Null for a single-threaded mix
+
+	// Inputs resampled by group : created under m_control, published by the count
+	std::array<std::unique_ptr<resample_group>, max_resample_groups> m_resample_groups;
+	std::atomic<std::size_t>										  m_resample_group_count{0};
+
+	// Render thread, its output ring and timing statistics
+	std::atomic<audio_ring*>				 m_output{nullptr}; // Ring of the last start(), read by consumers
+	std::vector<std::unique_ptr<audio_ring>> m_output_rings;	// Every ring start() allocated
+	std::atomic<std::uint64_t> m_periods{0};
+	std::atomic<std::uint64_t> m_deadline_misses{0};
+	std::atomic<std::uint64_t> m_output_overruns{0};
+	std::atomic<std::uint64_t> m_jitter_max_ns{0};
+	std::atomic<std::uint64_t> m_jitter_sum_ns{0};
+	std::jthread			   m_render; // Last member : stopped and joined first
+};
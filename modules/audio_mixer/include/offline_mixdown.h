@@ -0,0 +1,257 @@
+/**
+ * @file offline_mixdown.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-11-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "audio_file.h"
+#include "audio_mixer.h"
+
+/**
+ * @brief Result of an offline mix-down.
+ *
+ */
+struct mixdown_stats
+{
+	std::size_t				 m_frames		 = 0; // Output frames rendered
+	std::size_t				 m_short_periods = 0; // Periods where an input ran short (resampler latency, shorter stems)
+	std::chrono::nanoseconds m_elapsed{0};		  // Wall time of the render
+	double					 m_realtime_factor = 0.0; // Output duration / wall time
+	bool					 m_complete		   = false; // False if the sink refused a period
+};
+
+/**
+ * @brief Offline mix-down : stems in memory (usually mapped files) rendered as fast as the CPU allows.
+ *
+ * Runs the real-time mixer without its pacing : every period, each input pushes the frames of its stream
+ * covering that period (ceil(end of period x input rate / output rate), in the file encoding converted to AudioType
+ * like a producer would), then one mix() renders the period. A real-time loop with the same period and the same
+ * pushes gives the exact same samples : the offline render validates the real-time path.
+ *
+ * Inputs in the mixer's encoding are pushed straight from the mapping (no copy) when their alignment allows it.
+ *
+ * @tparam AudioType Sample type of the mix and of the output
+ */
+template <audio_sample_type AudioType>
+class offline_mixdown
+{
+public:
+
+	/**
+     * @brief Construct a mix-down.
+     *
+     * @param output_ctx Output audio context
+     * @param max_inputs Maximum number of stems
+     * @param period_frame Frames mixed per period
+     */
+	explicit offline_mixdown(audio_ctx output_ctx, std::size_t max_inputs = default_max_inputs, std::size_t period_frame = default_period_frame)
+		: m_output_context(output_ctx),
+		  m_period_frame(std::max<std::size_t>(period_frame, 1)),
+		  m_mixer(output_ctx, max_inputs)
+	{}
+
+	/**
+     * @brief Add a stem. The stream must outlive the render (keep its mapped_file open).
+     *
+     * @return std::optional<std::size_t> Mixer input id (for gain and pan), std::nullopt if max_inputs are already added
+     */
+	std::optional<std::size_t> add_input(const pcm_stream& stream, resample_quality quality = resample_quality::best)
+	{
+		auto id = m_mixer.add_input(quality);
+		if (id)
+			m_inputs.push_back({.m_stream = stream, .m_id = *id, .m_staging = {}});
+		return id;
+	}
+
+	/**
+     * @brief The mixer : gain, pan, mute of the inputs and output stage.
+     *
+     */
+	[[nodiscard]]
+	audio_mixer<AudioType>& mixer() { return m_mixer; }
+
+	/**
+     * @brief Total frames of the mix : the longest stem at the output rate.
+     *
+     */
+	[[nodiscard]]
+	std::size_t output_frames() const
+	{
+		std::size_t frames = 0;
+		for (const auto& in : m_inputs)
+			frames = std::max(frames, input_to_output(in, in.m_stream.frame_count()));
+		return frames;
+	}
+
+	/**
+     * @brief Render the whole mix, period by period, into a sink.
+     *
+     * @param sink bool(std::span<const AudioType> interleaved period), false stops the render
+     */
+	template <typename Sink>
+	mixdown_stats render(Sink&& sink)
+	{
+		using clock = std::chrono::steady_clock;
+
+		const std::size_t channels = m_output_context.m_channel_num;
+		const std::size_t total	   = output_frames();
+
+		std::vector<AudioType> period(m_period_frame * channels);
+		mixdown_stats		   stats;
+		stats.m_complete = true;
+
+		const auto start = clock::now();
+		while (stats.m_frames < total)
+		{
+			const std::size_t frames = std::min(m_period_frame, total - stats.m_frames);
+			for (auto& in : m_inputs)
+				feed(in, output_to_input(in, stats.m_frames + frames));
+
+			if (!m_mixer.mix(period.data(), frames))
+				++stats.m_short_periods;
+
+			stats.m_frames += frames;
+			if (!sink(std::span<const AudioType>{period.data(), frames * channels}))
+			{
+				stats.m_complete = false;
+				break;
+			}
+		}
+		stats.m_elapsed = clock::now() - start;
+
+		const double seconds = std::chrono::duration<double>(stats.m_elapsed).count();
+		if (seconds > 0.0)
+			stats.m_realtime_factor = static_cast<double>(stats.m_frames) / static_cast<double>(m_output_context.m_sample_rate) / seconds;
+		return stats;
+	}
+
+	/**
+     * @brief Render the whole mix into a WAV file, written by large blocks.
+     *
+     * @return std::optional<mixdown_stats> std::nullopt if the file can not be created or written
+     */
+	std::optional<mixdown_stats> render_to_file(const std::filesystem::path& path)
+		requires (pcm_encoding_of<AudioType>().has_value())
+	{
+		auto writer = wav_writer::create(path, m_output_context, *pcm_encoding_of<AudioType>());
+		if (!writer)
+			return std::nullopt;
+
+		const auto stats = render([&](std::span<const AudioType> period) { return writer->write(std::as_bytes(period)); });
+		if (!writer->close() || !stats.m_complete)
+			return std::nullopt;
+		return stats;
+	}
+
+private:
+
+	struct input
+	{
+		pcm_stream			   m_stream;
+		std::size_t			   m_id;
+		std::size_t			   m_pushed	 = 0;	  // Stream frames pushed
+		bool				   m_flushed = false; // Resampler tail pushed
+		std::vector<AudioType> m_staging;		  // Converted (or realigned) frames
+	};
+
+	[[nodiscard]]
+	std::size_t input_to_output(const input& in, std::size_t frames) const
+	{
+		const std::uint64_t in_rate	 = in.m_stream.m_context.m_sample_rate;
+		const std::uint64_t out_rate = m_output_context.m_sample_rate;
+		return static_cast<std::size_t>(((frames * out_rate) + in_rate - 1) / in_rate);
+	}
+
+	[[nodiscard]]
+	std::size_t output_to_input(const input& in, std::size_t frames) const
+	{
+		const std::uint64_t in_rate	 = in.m_stream.m_context.m_sample_rate;
+		const std::uint64_t out_rate = m_output_context.m_sample_rate;
+		return std::min<std::size_t>(static_cast<std::size_t>(((frames * in_rate) + out_rate - 1) / out_rate), in.m_stream.frame_count());
+	}
+
+	/**
+     * @brief Push the stream of an input up to a frame, then its resampler tail once the stream ends.
+     *
+     */
+	void feed(input& in, std::size_t until)
+	{
+		auto&			  queue	   = *m_mixer.input_queue(in.m_id);
+		const auto&		  context  = in.m_stream.m_context;
+		const std::size_t channels = context.m_channel_num;
+		const std::size_t bytes	   = in.m_stream.frame_bytes();
+
+		while (in.m_pushed < until)
+		{
+			const std::size_t frames = std::min(until - in.m_pushed, stage_frame);
+			const auto		  source = in.m_stream.m_data.subspan(in.m_pushed * bytes, frames * bytes);
+			queue.push_audio(context, samples_of(in, source, frames * channels), frames);
+			in.m_pushed += frames;
+		}
+
+		if (!in.m_flushed && in.m_pushed == in.m_stream.frame_count())
+		{
+			queue.flush_audio(context);
+			in.m_flushed = true;
+		}
+	}
+
+	/**
+     * @brief Samples of a stream block as AudioType : in place if possible, else realigned or converted into the staging buffer.
+     *
+     */
+	const AudioType* samples_of(input& in, std::span<const std::byte> source, std::size_t count)
+	{
+		if (in.m_stream.m_encoding == pcm_encoding_of<AudioType>())
+		{
+			if (reinterpret_cast<std::uintptr_t>(source.data()) % alignof(AudioType) == 0)
+				return reinterpret_cast<const AudioType*>(source.data());
+
+			in.m_staging.resize(count);
+			std::memcpy(in.m_staging.data(), source.data(), source.size());
+			return in.m_staging.data();
+		}
+
+		// Another encoding : through float, by tiles copied first (mapped samples may be misaligned).
+		in.m_staging.resize(count);
+		visit_encoding(in.m_stream.m_encoding, [&]<typename Sample>(std::type_identity<Sample>)
+		{
+			std::array<Sample, convert_tile_sample> tile;
+			std::array<float, convert_tile_sample>	normalized;
+			for (std::size_t done = 0; done < count; done += tile.size())
+			{
+				const std::size_t size = std::min(tile.size(), count - done);
+				std::memcpy(tile.data(), source.data() + (done * sizeof(Sample)), size * sizeof(Sample));
+				convert_to_float(std::span<const Sample>{tile.data(), size}, std::span{normalized});
+				convert_from_float(std::span<const float>{normalized.data(), size}, std::span{in.m_staging.data() + done, size});
+			}
+		});
+		return in.m_staging.data();
+	}
+
+	static constexpr std::size_t default_max_inputs	  = 64;
+	static constexpr std::size_t default_period_frame = 480;  // 10 ms at 48 KHz, like render_config
+	static constexpr std::size_t stage_frame		  = 4096; // Stream frames per push
+	static constexpr std::size_t convert_tile_sample  = 1024; // Samples converted per step from another encoding
+
+	audio_ctx			   m_output_context;
+	std::size_t			   m_period_frame;
+	audio_mixer<AudioType> m_mixer;
+	std::vector<input>	   m_inputs;
+};
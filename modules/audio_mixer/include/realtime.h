@@ -0,0 +1,36 @@
+/**
+ * @file realtime.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief 
+ * @version 0.1
+ * @date 2025-10-30
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ */
+#pragma once
+
+#include <optional>
+
+namespace realtime
+{
+	/**
+     * @brief Request real-time scheduling for the calling thread (SCHED_FIFO on POSIX, time critical on Windows).
+     * 
+     * Usually needs privileges (CAP_SYS_NICE, rtprio limit...), the thread keeps its policy on failure.
+     * 
+     * @param priority POSIX real-time priority, clamped to the range of SCHED_FIFO
+     * @return true The thread is now real-time
+     * @return false The request was refused or is not supported
+     */
+	bool promote_current_thread(int priority);
+
+	/**
+     * @brief Pin the calling thread to one CPU core.
+     * 
+     * @param core Core index
+     * @return true The thread is pinned
+     * @return false The request was refused or is not supported
+     */
+	bool pin_current_thread(unsigned core);
+} // namespace realtime
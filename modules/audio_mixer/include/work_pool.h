@@ -0,0 +1,125 @@
+/**
+ * @file work_pool.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-11-01
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Fork-join pool of worker threads with work stealing over index ranges.
+ *
+ * parallel_for() splits [0, count) in one contiguous range per participant (the calling thread
+ * is one of them). Each participant takes indices from the front of its own range, and once it
+ * is empty steals indices from the back of the others. Ranges are packed (begin, end) words
+ * updated by CAS : no lock and no allocation per call, usable from a real-time thread.
+ *
+ * Which thread runs an index is not deterministic, callers needing reproducible results
+ * must make each index write its own output.
+ *
+ */
+class work_pool
+{
+public:
+
+	/**
+     * @brief Construct a pool.
+     *
+     * @param thread_count Participants of each parallel_for, calling thread included (at least 1)
+     */
+	explicit work_pool(std::size_t thread_count);
+
+	/* Workers keep a pointer to their pool */
+	work_pool(const work_pool&)			   = delete;
+	work_pool(work_pool&&)				   = delete;
+	work_pool& operator=(const work_pool&) = delete;
+	work_pool& operator=(work_pool&&)	   = delete;
+
+	~work_pool();
+
+	/**
+     * @brief Run body(index) for every index of [0, count), return once all are done.
+     *
+     * Not reentrant : one parallel_for at a time per pool.
+     *
+     * @param count Index count (at most 2^32 - 1)
+     * @param body Callable taking a std::size_t index
+     */
+	template <typename Body>
+	void parallel_for(std::size_t count, Body&& body)
+	{
+		using Callable = std::remove_reference_t<Body>;
+		run(count, [](void* context, std::size_t index) { (*static_cast<Callable*>(context))(index); }, std::addressof(body));
+	}
+
+	/**
+     * @brief Schedule the workers like a real-time caller of parallel_for() : it waits for them at every join, at
+     * ordinary priority they would set its deadline.
+     *
+     * Each worker applies it when the next parallel_for() wakes it, before taking work, and keeps it afterwards.
+     * Call it from the thread running parallel_for(), between two calls.
+     *
+     * @param priority Real-time priority, see realtime::promote_current_thread()
+     * @param cores Core of each worker, in order (workers past its end stay unpinned)
+     */
+	void promote_workers(int priority, std::span<const unsigned> cores = {});
+
+	[[nodiscard]] std::size_t size() const { return m_ranges.size(); }
+
+private:
+
+	using task = void (*)(void* context, std::size_t index);
+
+	void run(std::size_t count, task body, void* context);
+	void worker_loop(std::size_t participant);
+	void drain(std::size_t participant);
+
+	static constexpr std::size_t cache_line = 64;
+
+	/**
+     * @brief Remaining indices of one participant, packed as (begin << 32 | end).
+     *
+     */
+	struct alignas(cache_line) range
+	{
+		std::atomic<std::uint64_t> m_bounds{0};
+	};
+
+	/**
+     * @brief Scheduling requested for one worker by promote_workers().
+     *
+     */
+	struct scheduling
+	{
+		int						m_priority = 0;
+		std::optional<unsigned> m_core;
+	};
+
+	std::vector<range>		 m_ranges;
+	std::vector<std::thread> m_workers;
+
+	// Written between parallel_for() calls, read by the workers once woken by the next one
+	std::vector<scheduling> m_scheduling;
+	std::uint64_t			m_scheduling_request = 0; // Bumped by promote_workers()
+
+	task  m_task	= nullptr;
+	void* m_context = nullptr;
+
+	alignas(cache_line) std::atomic<std::uint64_t> m_generation{0}; // One per parallel_for, wakes the workers
+	alignas(cache_line) std::atomic<std::size_t> m_finished{0};		// Workers done with the current generation
+	std::atomic<bool> m_stop{false};
+};
@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <utility>
+
+#include "audio_file.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr std::uint16_t wave_format_pcm        = 0x0001;
+    constexpr std::uint16_t wave_format_float      = 0x0003;
+    constexpr std::uint16_t wave_format_extensible = 0xFFFE;
+
+    constexpr std::size_t chunk_header_bytes = 8;
+    constexpr std::size_t fmt_bytes          = 16; // Up to bits per sample
+    constexpr std::size_t extensible_bytes   = 40; // Up to the sub format GUID
+
+    // Little-endian fields, read byte by byte : no alignment requirement.
+    std::uint32_t read_le(std::span<const std::byte> bytes, std::size_t offset, std::size_t size)
+    {
+        std::uint32_t value = 0;
+        for (std::size_t i = 0; i < size; ++i)
+            value |= static_cast<std::uint32_t>(bytes[offset + i]) << (8U * i);
+        return value;
+    }
+
+    bool has_tag(std::span<const std::byte> bytes, std::size_t offset, std::string_view tag)
+    {
+        return offset + tag.size() <= bytes.size() && std::memcmp(bytes.data() + offset, tag.data(), tag.size()) == 0;
+    }
+
+    std::optional<pcm_encoding> encoding_of(std::uint16_t format, std::uint16_t bits)
+    {
+        if (format == wave_format_float)
+        {
+            if (bits == 32) return pcm_encoding::float32;
+            if (bits == 64) return pcm_encoding::float64;
+        }
+        else if (format == wave_format_pcm)
+        {
+            if (bits == 8)  return pcm_encoding::uint8;
+            if (bits == 16) return pcm_encoding::int16;
+            if (bits == 24) return pcm_encoding::int24;
+            if (bits == 32) return pcm_encoding::int32;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<channel_layout> layout_of(std::uint32_t channels)
+    {
+        switch (channels)
+        {
+        case channel_layout::Mono:          return channel_layout::Mono;
+        case channel_layout::Stereo:        return channel_layout::Stereo;
+        case channel_layout::FivePointOne:  return channel_layout::FivePointOne;
+        case channel_layout::SevenPointOne: return channel_layout::SevenPointOne;
+        default:                            return std::nullopt;
+        }
+    }
+
+    std::optional<sample_rate> rate_of(std::uint32_t rate)
+    {
+        for (const auto known : {sample_rate::SR44100, sample_rate::SR48000, sample_rate::SR88200,
+                                 sample_rate::SR96000, sample_rate::SR176400, sample_rate::SR192000})
+            if (rate == known)
+                return known;
+        return std::nullopt;
+    }
+
+    template <std::size_t Size>
+    void put_le(std::array<std::byte, 44>& header, std::size_t offset, std::uint32_t value)
+    {
+        for (std::size_t i = 0; i < Size; ++i)
+            header[offset + i] = static_cast<std::byte>(value >> (8U * i));
+    }
+} // namespace
+
+// ----------------- mapped_file -----------------
+
+auto
+mapped_file::open(const std::filesystem::path& path)
+-> std::optional<mapped_file>
+{
+    mapped_file file;
+#if defined(_WIN32)
+    HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return std::nullopt;
+
+    LARGE_INTEGER size{};
+    if (GetFileSizeEx(handle, &size) == 0)
+    {
+        CloseHandle(handle);
+        return std::nullopt;
+    }
+
+    // An empty file has no mapping
+    if (size.QuadPart != 0)
+    {
+        file.m_mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (file.m_mapping != nullptr)
+            file.m_data = static_cast<const std::byte*>(MapViewOfFile(file.m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (file.m_data == nullptr)
+        {
+            CloseHandle(handle);
+            return std::nullopt; // The destructor closes the mapping
+        }
+    }
+    CloseHandle(handle); // The mapping keeps the file open
+    file.m_size = static_cast<std::size_t>(size.QuadPart);
+    return file;
+#elif defined(__unix__) || defined(__APPLE__)
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return std::nullopt;
+
+    struct stat status{};
+    if (fstat(descriptor, &status) != 0)
+    {
+        ::close(descriptor);
+        return std::nullopt;
+    }
+
+    // An empty file has no mapping
+    if (status.st_size != 0)
+    {
+        void* data = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (data == MAP_FAILED)
+        {
+            ::close(descriptor);
+            return std::nullopt;
+        }
+        madvise(data, static_cast<std::size_t>(status.st_size), MADV_SEQUENTIAL);
+        file.m_data = static_cast<const std::byte*>(data);
+        file.m_size = static_cast<std::size_t>(status.st_size);
+    }
+    ::close(descriptor); // The mapping keeps the file open
+    return file;
+#else
+    (void)path;
+    return std::nullopt;
+#endif
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0))
+#if defined(_WIN32)
+    , m_mapping(std::exchange(other.m_mapping, nullptr))
+#endif
+{}
+
+auto
+mapped_file::operator=(mapped_file&& other) noexcept
+-> mapped_file&
+{
+    if (this != &other)
+    {
+        unmap();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+#if defined(_WIN32)
+        m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+mapped_file::~mapped_file() { unmap(); }
+
+void
+mapped_file::unmap()
+{
+#if defined(_WIN32)
+    if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+    if (m_mapping != nullptr)
+        CloseHandle(m_mapping);
+    m_mapping = nullptr;
+#elif defined(__unix__) || defined(__APPLE__)
+    if (m_data != nullptr)
+        munmap(const_cast<std::byte*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+// ----------------- PCM views -----------------
+
+auto
+parse_wav(const std::span<const std::byte> file)
+-> std::optional<pcm_stream>
+{
+    // Samples are viewed in place : the host must share the little-endian order of the format.
+    if constexpr (std::endian::native != std::endian::little)
+        return std::nullopt;
+
+    if (!has_tag(file, 0, "RIFF") || !has_tag(file, 8, "WAVE"))
+        return std::nullopt;
+
+    std::optional<pcm_encoding> encoding;
+    std::optional<channel_layout> layout;
+    std::optional<sample_rate> rate;
+
+    for (std::size_t offset = 12; offset + chunk_header_bytes <= file.size();)
+    {
+        const std::size_t size = read_le(file, offset + 4, 4);
+        const std::size_t body = offset + chunk_header_bytes;
+
+        if (has_tag(file, offset, "fmt "))
+        {
+            if (size < fmt_bytes || body + fmt_bytes > file.size())
+                return std::nullopt;
+
+            auto format          = static_cast<std::uint16_t>(read_le(file, body, 2));
+            const auto channels  = read_le(file, body + 2, 2);
+            const auto frequency = read_le(file, body + 4, 4);
+            const auto align     = read_le(file, body + 12, 2);
+            const auto bits      = static_cast<std::uint16_t>(read_le(file, body + 14, 2));
+
+            // Extensible : the actual format is the first field of the sub format GUID
+            if (format == wave_format_extensible)
+            {
+                if (size < extensible_bytes || body + extensible_bytes > file.size())
+                    return std::nullopt;
+                format = static_cast<std::uint16_t>(read_le(file, body + 24, 2));
+            }
+
+            encoding = encoding_of(format, bits);
+            layout   = layout_of(channels);
+            rate     = rate_of(frequency);
+            if (!encoding || !layout || !rate || align != sample_bytes(*encoding) * channels)
+                return std::nullopt;
+        }
+        else if (has_tag(file, offset, "data"))
+        {
+            if (!encoding)
+                return std::nullopt; // fmt comes first
+
+            const std::size_t available = std::min(size, file.size() - body);
+            return raw_pcm(file.subspan(body, available), audio_ctx{audio_format{*rate, *layout}}, *encoding);
+        }
+
+        offset = body + size + (size & 1U); // Chunks are padded to an even size
+    }
+    return std::nullopt;
+}
+
+auto
+raw_pcm(const std::span<const std::byte> data, const audio_ctx context, const pcm_encoding encoding)
+-> pcm_stream
+{
+    const std::size_t frame_bytes = sample_bytes(encoding) * context.m_channel_num;
+    return {.m_context = context, .m_encoding = encoding, .m_data = data.first(data.size() - (data.size() % frame_bytes))};
+}
+
+// ----------------- wav_writer -----------------
+
+auto
+wav_writer::create(const std::filesystem::path& path, const audio_ctx context, const pcm_encoding encoding)
+-> std::optional<wav_writer>
+{
+    wav_writer writer;
+    writer.m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!writer.m_file)
+        return std::nullopt;
+
+    // Canonical 44 bytes header, sizes patched by close()
+    const std::uint32_t channels = context.m_channel_num;
+    const auto          bytes    = static_cast<std::uint32_t>(sample_bytes(encoding));
+    const bool          is_float = encoding == pcm_encoding::float32 || encoding == pcm_encoding::float64;
+
+    std::array<std::byte, 44> header{};
+    std::memcpy(header.data(), "RIFF", 4);
+    std::memcpy(header.data() + 8, "WAVEfmt ", 8);
+    put_le<4>(header, 16, static_cast<std::uint32_t>(fmt_bytes));
+    put_le<2>(header, 20, is_float ? wave_format_float : wave_format_pcm);
+    put_le<2>(header, 22, channels);
+    put_le<4>(header, 24, context.m_sample_rate);
+    put_le<4>(header, 28, context.m_sample_rate * channels * bytes);
+    put_le<2>(header, 32, channels * bytes);
+    put_le<2>(header, 34, bytes * 8);
+    std::memcpy(header.data() + 36, "data", 4);
+
+    writer.m_block.reserve(block_bytes);
+    if (!writer.m_file.write(reinterpret_cast<const char*>(header.data()), header.size()))
+        return std::nullopt;
+    return writer;
+}
+
+auto
+wav_writer::write(std::span<const std::byte> samples)
+-> bool
+{
+    m_data_bytes += samples.size();
+    while (!samples.empty() && !m_failed)
+    {
+        const std::size_t taken = std::min(samples.size(), block_bytes - m_block.size());
+        m_block.insert(m_block.end(), samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(taken));
+        samples = samples.subspan(taken);
+
+        if (m_block.size() == block_bytes)
+            flush_block();
+    }
+    return !m_failed;
+}
+
+auto
+wav_writer::flush_block()
+-> bool
+{
+    if (!m_block.empty() && !m_file.write(reinterpret_cast<const char*>(m_block.data()), static_cast<std::streamsize>(m_block.size())))
+        m_failed = true;
+    m_block.clear();
+    return !m_failed;
+}
+
+auto
+wav_writer::close()
+-> bool
+{
+    if (!m_file.is_open())
+        return !m_failed;
+
+    flush_block();
+
+    // RIFF sizes are 32-bit : saturated past 4 GiB
+    constexpr std::uint64_t max_size = std::numeric_limits<std::uint32_t>::max();
+    const auto data_size = static_cast<std::uint32_t>(std::min(m_data_bytes, max_size - 36));
+    const auto riff_size = static_cast<std::uint32_t>(data_size + 36 + (data_size & 1U));
+
+    std::array<std::byte, 44> sizes{};
+    put_le<4>(sizes, 4, riff_size);
+    put_le<4>(sizes, 40, data_size);
+
+    // Odd data sizes get their pad byte
+    if ((m_data_bytes & 1U) != 0)
+        m_file.put(0);
+
+    m_file.seekp(4);
+    m_file.write(reinterpret_cast<const char*>(sizes.data() + 4), 4);
+    m_file.seekp(40);
+    m_file.write(reinterpret_cast<const char*>(sizes.data() + 40), 4);
+    if (!m_file)
+        m_failed = true;
+
+    m_file.close();
+    return !m_failed;
+}
@@ -0,0 +1,44 @@
+#include <algorithm>
+
+#include "realtime.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+auto
+realtime::promote_current_thread(int priority)
+-> bool
+{
+#if defined(_WIN32)
+    (void)priority;
+    return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+#elif defined(__unix__) || defined(__APPLE__)
+    sched_param param{};
+    param.sched_priority = std::clamp(priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#else
+    (void)priority;
+    return false;
+#endif
+}
+
+auto
+realtime::pin_current_thread(unsigned core)
+-> bool
+{
+#if defined(_WIN32)
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << core) != 0;
+#elif defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core, &cpu_set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+    (void)core;
+    return false;
+#endif
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+
+#include "realtime.h"
+#include "work_pool.h"
+
+namespace
+{
+    constexpr std::uint64_t pack(std::uint64_t begin, std::uint64_t end) { return (begin << 32U) | end; }
+    constexpr std::uint64_t begin_of(std::uint64_t bounds) { return bounds >> 32U; }
+    constexpr std::uint64_t end_of(std::uint64_t bounds) { return bounds & 0xFFFF'FFFFU; }
+} // namespace
+
+work_pool::work_pool(std::size_t thread_count)
+    : m_ranges(std::max<std::size_t>(thread_count, 1)),
+      m_scheduling(m_ranges.size() - 1)
+{
+    m_workers.reserve(m_ranges.size() - 1);
+    for (std::size_t participant = 1; participant < m_ranges.size(); ++participant)
+        m_workers.emplace_back([this, participant] { worker_loop(participant); });
+}
+
+work_pool::~work_pool()
+{
+    m_stop.store(true, std::memory_order_relaxed);
+    m_generation.fetch_add(1, std::memory_order_release);
+    m_generation.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+auto
+work_pool::run(std::size_t count, task body, void* context)
+-> void
+{
+    if (count == 0)
+        return;
+
+    // Single participant or single index : no hand-off worth its wake-up cost.
+    if (m_workers.empty() || count == 1)
+    {
+        for (std::size_t index = 0; index < count; ++index)
+            body(context, index);
+        return;
+    }
+
+    m_task    = body;
+    m_context = context;
+
+    // One contiguous range per participant, the first ones one index larger.
+    const std::size_t participants = m_ranges.size();
+    for (std::size_t participant = 0, begin = 0; participant < participants; ++participant)
+    {
+        const std::size_t end = begin + (count / participants) + (participant < count % participants ? 1 : 0);
+        m_ranges[participant].m_bounds.store(pack(begin, end), std::memory_order_relaxed);
+        begin = end;
+    }
+
+    m_finished.store(0, std::memory_order_relaxed);
+    m_generation.fetch_add(1, std::memory_order_release);
+    m_generation.notify_all();
+
+    drain(0);
+
+    // Every worker acknowledges the generation : none can still read this task afterwards.
+    for (auto finished = m_finished.load(std::memory_order_acquire); finished != m_workers.size(); finished = m_finished.load(std::memory_order_acquire))
+        m_finished.wait(finished, std::memory_order_acquire);
+}
+
+auto
+work_pool::promote_workers(int priority, std::span<const unsigned> cores)
+-> void
+{
+    for (std::size_t worker = 0; worker < m_scheduling.size(); ++worker)
+    {
+        m_scheduling[worker].m_priority = priority;
+        m_scheduling[worker].m_core     = worker < cores.size() ? std::optional<unsigned>(cores[worker]) : std::nullopt;
+    }
+    ++m_scheduling_request; // Published to the workers by the next generation
+}
+
+auto
+work_pool::worker_loop(std::size_t participant)
+-> void
+{
+    std::uint64_t seen      = 0;
+    std::uint64_t scheduled = 0;
+    while (true)
+    {
+        m_generation.wait(seen, std::memory_order_acquire);
+        seen = m_generation.load(std::memory_order_acquire);
+        if (m_stop.load(std::memory_order_relaxed))
+            return;
+
+        if (scheduled != m_scheduling_request)
+        {
+            const auto& request = m_scheduling[participant - 1];
+            realtime::promote_current_thread(request.m_priority);
+            if (request.m_core)
+                realtime::pin_current_thread(*request.m_core);
+            scheduled = m_scheduling_request;
+        }
+
+        drain(participant);
+
+        if (m_finished.fetch_add(1, std::memory_order_acq_rel) + 1 == m_workers.size())
+            m_finished.notify_one();
+    }
+}
+
+auto
+work_pool::drain(std::size_t participant)
+-> void
+{
+    // Own range first, from its front.
+    auto& own = m_ranges[participant].m_bounds;
+    for (auto bounds = own.load(std::memory_order_acquire); begin_of(bounds) < end_of(bounds);)
+        if (own.compare_exchange_weak(bounds, pack(begin_of(bounds) + 1, end_of(bounds)), std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            m_task(m_context, begin_of(bounds));
+            bounds = own.load(std::memory_order_acquire);
+        }
+
+    // Then steal from the back of the others, starting with the next participant.
+    const std::size_t participants = m_ranges.size();
+    for (std::size_t offset = 1; offset < participants; ++offset)
+    {
+        auto& victim = m_ranges[(participant + offset) % participants].m_bounds;
+        for (auto bounds = victim.load(std::memory_order_acquire); begin_of(bounds) < end_of(bounds);)
+            if (victim.compare_exchange_weak(bounds, pack(begin_of(bounds), end_of(bounds) - 1), std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                m_task(m_context, end_of(bounds) - 1);
+                bounds = victim.load(std::memory_order_acquire);
+            }
+    }
+}
@@ -11,13 +11,77 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <limits>
 #include <optional>
+#include <utility>
 
 #include "channel.h"
+#include "channel_mix.h"
 #include "sample_rate.h"
 
+/**
+ * @brief Packed 24-bit little-endian PCM sample : 3 bytes, no padding (capture / playback hardware format).
+ *
+ */
+struct int24_packed
+{
+    std::array<uint8_t, 3> m_bytes{};
+
+    // Sign-extended value, in [-2^23, 2^23 - 1]
+    [[nodiscard]] constexpr int32_t value() const
+    {
+        const auto raw = static_cast<uint32_t>(m_bytes[0]) | (static_cast<uint32_t>(m_bytes[1]) << 8U) | (static_cast<uint32_t>(m_bytes[2]) << 16U);
+        return static_cast<int32_t>(raw << 8U) >> 8;
+    }
+
+    // Low 24 bits of a value
+    [[nodiscard]] static constexpr int24_packed from_value(int32_t val)
+    {
+        const auto raw = static_cast<uint32_t>(val);
+        return {{static_cast<uint8_t>(raw), static_cast<uint8_t>(raw >> 8U), static_cast<uint8_t>(raw >> 16U)}};
+    }
+
+    constexpr bool operator==(const int24_packed&) const = default;
+};
+static_assert(sizeof(int24_packed) == 3 && alignof(int24_packed) == 1, "int24_packed must map packed 24-bit buffers");
+
+/**
+ * @brief 24-bit sample in the low bits of a 32-bit word (24-in-32, sign-extended), full scale is 2^23 and not 2^31.
+ *
+ * The upper byte is ignored on input, so hardware buffers leaving it unset are read correctly.
+ *
+ */
+struct int24_in_32
+{
+    int32_t m_value = 0;
+
+    [[nodiscard]] constexpr int32_t value() const { return static_cast<int32_t>(static_cast<uint32_t>(m_value) << 8U) >> 8; }
+    [[nodiscard]] static constexpr int24_in_32 from_value(int32_t val) { return {val}; }
+
+    constexpr bool operator==(const int24_in_32&) const = default;
+};
+static_assert(sizeof(int24_in_32) == 4, "int24_in_32 must map 32-bit buffers");
+
 template <class InputType>
-concept audio_sample_type = std::integral<InputType> || std::floating_point<InputType>;
+concept int24_sample_type = std::same_as<InputType, int24_packed> || std::same_as<InputType, int24_in_32>;
+
+template <class InputType>
+concept audio_sample_type = std::integral<InputType> || std::floating_point<InputType> || int24_sample_type<InputType>;
+
+/**
+ * @brief Audio context known at compile time, usable as a template argument.
+ *
+ */
+struct audio_format
+{
+    sample_rate::value    m_sample_rate = sample_rate::SR44100;
+    channel_layout::value m_channel_num = channel_layout::Stereo;
+
+    constexpr bool operator==(const audio_format&) const = default;
+};
 
 struct audio_ctx
 {
@@ -25,6 +89,7 @@ struct audio_ctx
     channel_layout  m_channel_num = channel_layout::Stereo;
     
     audio_ctx(sample_rate s_rate, std::string_view channel) : m_sample_rate(s_rate), m_channel_num(channel) {}
+    constexpr audio_ctx(audio_format format) : m_sample_rate(format.m_sample_rate), m_channel_num(format.m_channel_num) {}
 
     // Comparaison
     bool operator==(const audio_ctx& rhs) const { return m_channel_num == rhs.m_channel_num && m_sample_rate == rhs.m_sample_rate; }
@@ -32,12 +97,12 @@ struct audio_ctx
 
     [[nodiscard]] auto 
     need_conversion(const audio_ctx& other) const
-    -> std::optional<channel_layout::MatrixType> 
+    -> std::optional<remix_function> 
     {
         
         // Convert from other(usually input) to me(usually expected)
         if(m_channel_num != other.m_channel_num)
-            return other.m_channel_num.matrix_to(m_channel_num);
+            return remix_for(other.m_channel_num, m_channel_num);
     
         return std::nullopt;
     }
@@ -48,9 +113,15 @@ struct audio_ctx
     {
         // Convert from other(usually input) to me(usually expected)
         return m_sample_rate != other.m_sample_rate ? 
-                std::make_optional(m_sample_rate / other.m_sample_rate): 
+                std::make_optional(static_cast<double>(m_sample_rate) / static_cast<double>(other.m_sample_rate)): 
                 std::nullopt;
     }
+
+    // Dense index of (sample rate, channel layout), for per-context lookup tables.
+    [[nodiscard]] constexpr std::size_t index() const { return (m_sample_rate.index() * channel_layout::count) + m_channel_num.index(); }
+
+    // Number of distinct audio contexts
+    static constexpr std::size_t count = sample_rate::count * channel_layout::count;
 };
 
 /**
@@ -79,6 +150,23 @@ make_audio_converters()
             [](AudioType val) { return val; },
             [](float val) { return static_cast<AudioType>(val); }
         };
+
+    else if constexpr (int24_sample_type<AudioType>)
+    {
+        // Same scaling as the signed integers, on 24 bits.
+        constexpr float   scale     = 8388608.0F;
+        constexpr int32_t max_value = 8388607;
+        constexpr float   max_float = 1.0F;
+        return std::pair
+        {
+            [](AudioType val) { return static_cast<float>(val.value()) / scale; },
+            [=](float val)
+            {
+                const float scaled = std::clamp(val, -max_float, max_float) * scale;
+                return AudioType::from_value(scaled >= scale ? max_value : static_cast<int32_t>(scaled));
+            }
+        };
+    }
     
     else if constexpr (std::is_integral_v<AudioType>)
     {
@@ -91,7 +179,12 @@ make_audio_converters()
             return std::pair
             {
                 [](AudioType val) { return static_cast<float>(val) / scale; },
-                [=](float val) { return static_cast<AudioType>(std::clamp(val, -max_float, max_float) * scale); }
+                [=](float val) 
+                { 
+                    // +1.0 scales to max() + 1, which the cast can not represent : saturate it.
+                    const float scaled = std::clamp(val, -max_float, max_float) * scale;
+                    return scaled >= scale ? Limits::max() : static_cast<AudioType>(scaled); 
+                }
             };
         }
         else // unsigned
@@ -10,13 +10,103 @@
  */
 #pragma once
 
-#include <numeric>
-#include <print>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <ranges>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 
 #include "audio_prop_def.h"
-#include "lockfree_queue.h"
+#include "audio_ring.h"
+#include "deferred_log.h"
+#include "drift_control.h"
+#include "mix_control.h"
+#include "queue_stats.h"
+#include "resampler.h"
+#include "sample_convert.h"
 #include "samplerate.h"
+#include "wait_point.h"
+
+/**
+ * @brief Sample layout inside an audio_queue.
+ * 
+ */
+enum class queue_storage : uint8_t
+{
+	interleaved, // Frames one after the other, like most audio APIs
+	planar		 // One ring plane per channel : mapping, mixing and planar I/O run as contiguous per channel loops
+};
+
+/**
+ * @brief Sample precision inside an audio_queue.
+ * 
+ */
+enum class queue_precision : uint8_t
+{
+	float32, // Float samples, with headroom above full scale
+	int16	 // Half the memory : samples are rounded to 16 bits and clipped to full scale when pushed
+};
+
+/**
+ * @brief What a push does with the frames the queue has no room for.
+ * 
+ * Whatever the policy, frames are never split : every channel of a frame is written, or none.
+ * 
+ */
+enum class overflow_policy : uint8_t
+{
+	drop_newest,	  // Write the frames that fit, drop the rest of the push
+	drop_push,		  // All or nothing : a push that does not fit entirely is dropped entirely
+	overwrite_oldest, // Drop the oldest frames to make room : lowest latency, for live monitoring
+	block			  // Wait for room up to a timeout, then drop the rest : for offline producers
+};
+
+/**
+ * @brief Dimensions of the ring of a queue : ring capacity (samples per plane), planes and stored sample size.
+ * 
+ */
+struct queue_ring_shape
+{
+	std::size_t m_capacity	   = 0;
+	std::size_t m_planes	   = 1;
+	std::size_t m_sample_bytes = sizeof(float);
+
+	bool operator==(const queue_ring_shape&) const = default;
+};
+
+/**
+ * @brief Frames of a queue lent in place (audio_queue::acquire_write(), acquire_read()) : at most two regions, as the ring wraps.
+ * 
+ * Interleaved storage : interleaved(r) holds the frames of region r, channels side by side.
+ * Planar storage : channel(r, c) holds channel c of the frames of region r.
+ * 
+ * @tparam Sample float (write) or const float (read)
+ */
+template <typename Sample>
+class ring_frames
+{
+public:
+
+	[[nodiscard]] std::size_t frames() const { return m_frames[0] + m_frames[1]; }
+	[[nodiscard]] std::size_t regions() const { return (m_frames[0] != 0 ? 1 : 0) + (m_frames[1] != 0 ? 1 : 0); }
+	[[nodiscard]] std::size_t region_frames(std::size_t region) const { return m_frames[region]; }
+
+	[[nodiscard]] std::span<Sample> interleaved(std::size_t region) const { return {m_regions[region], m_frames[region] * m_frame_samples}; }
+	[[nodiscard]] std::span<Sample> channel(std::size_t region, std::size_t channel) const { return {m_regions[region] + (channel * m_plane_stride), m_frames[region]}; }
+
+protected:
+
+	std::array<Sample*, 2>	   m_regions{};		  // First sample of each region, in the first plane
+	std::array<std::size_t, 2> m_frames{};
+	std::size_t				   m_frame_samples = 1; // Samples of a frame in a plane : channels (interleaved) or 1 (planar)
+	std::size_t				   m_plane_stride  = 0; // Samples from a plane to the next (planar)
+};
 
 template<audio_sample_type AudioType>
 struct audio_queue
@@ -26,7 +116,8 @@ struct audio_queue
      * 
      */
 	audio_queue()
-		: m_queue(static_cast<size_t>(m_expected_context.m_channel_num) * m_expected_context.m_sample_rate * default_latency_ms / 1000)
+		: m_control(m_expected_context.m_channel_num),
+		  m_queue(make_ring(default_latency_ms))
 	{}
 
 	/**
@@ -34,12 +125,61 @@ struct audio_queue
      *
      * @param user_expected_ctx User expected output audio context.
      * @param user_expected_lat_ms User expected queue capacity (in latency, ms)
+     * @param quality Resampling quality / cost tier of the inputs needing resampling
+     * @param storage Interleaved or planar samples inside the queue, both accept and give either layout
+     * @param precision Float samples, or 16-bit samples for half the memory
      */
-	audio_queue(audio_ctx user_expected_ctx, size_t user_expected_lat_ms = 200)
+	audio_queue(audio_ctx user_expected_ctx, size_t user_expected_lat_ms = 200, resample_quality quality = resample_quality::best,
+				queue_storage storage = queue_storage::interleaved, queue_precision precision = queue_precision::float32)
 		: m_expected_context(user_expected_ctx),
-		  m_queue(static_cast<size_t>(user_expected_ctx.m_channel_num) * user_expected_ctx.m_sample_rate * user_expected_lat_ms / 1000)
+		  m_quality(quality),
+		  m_storage(storage),
+		  m_precision(precision),
+		  m_control(user_expected_ctx.m_channel_num),
+		  m_queue(make_ring(user_expected_lat_ms))
 	{}
 
+	/**
+     * @brief Construct a queue over a ring sized elsewhere, e.g. in memory shared with another process (shared_audio_queue).
+     * 
+     * The ring keeps its capacity : set_latency() leaves it as is.
+     * 
+     * @param user_expected_ctx User expected output audio context.
+     * @param ring Ring of ring_shape() for this context, storage and precision, at any latency
+     * @param quality Resampling quality / cost tier of the inputs needing resampling
+     * @param storage Interleaved or planar samples inside the queue
+     * @param precision Float samples, or 16-bit samples
+     */
+	audio_queue(audio_ctx user_expected_ctx, std::unique_ptr<audio_ring> ring, resample_quality quality, queue_storage storage, queue_precision precision)
+		: m_expected_context(user_expected_ctx),
+		  m_quality(quality),
+		  m_storage(storage),
+		  m_precision(precision),
+		  m_control(user_expected_ctx.m_channel_num),
+		  m_queue(std::move(ring)),
+		  m_fixed_ring(true)
+	{
+		const auto shape = ring_shape(user_expected_ctx, 0, storage, precision);
+		if (!m_queue || m_queue->planes() != shape.m_planes || m_queue->sample_bytes() != shape.m_sample_bytes || m_queue->capacity() % slots_per_frame() != 0)
+			throw std::invalid_argument("audio_queue : ring of another storage or precision");
+	}
+
+	/**
+     * @brief Ring of a queue holding a latency at an expected context : a power of two number of frames (mask wrapping), at least the latency.
+     * 
+     */
+	[[nodiscard]]
+	static queue_ring_shape ring_shape(const audio_ctx& expected_ctx, std::size_t latency_ms, queue_storage storage, queue_precision precision)
+	{
+		const std::size_t frames   = std::bit_ceil(std::max<std::size_t>(static_cast<std::size_t>(expected_ctx.m_sample_rate) * latency_ms / 1000, 1));
+		const std::size_t channels = expected_ctx.m_channel_num;
+
+		// Whole frames : one plane of frames per channel, or interleaved samples.
+		return {.m_capacity		= storage == queue_storage::planar ? frames : frames * channels,
+				.m_planes		= storage == queue_storage::planar ? channels : 1,
+				.m_sample_bytes = precision == queue_precision::int16 ? sizeof(std::int16_t) : sizeof(float)};
+	}
+
 	/* Copy or move a queue is not allowed */
 	audio_queue(const audio_queue&)			   = delete;
 	audio_queue(audio_queue&&)				   = delete;
@@ -52,148 +192,1582 @@ struct audio_queue
      */
 	~audio_queue() = default;
 
+	/**
+     * @brief Allocate the push state of an input context ahead of time.
+     * 
+     * push_audio() does it on the first push of each input context, call this from a
+     * non real-time thread to keep the audio callback free of any heap allocation.
+     * 
+     * @param input_context Input audio context
+     * @return true The input context is ready
+     * @return false Creating the resampler failed
+     */
+	bool prepare_input(const audio_ctx& input_context)
+	{
+		return session_for(input_context) != nullptr;
+	}
+
 	/**
      * @brief Push a sequence of audio into the audio queue.
      * 
+     * When resampling is needed, the filter history is kept between pushes of the same input context,
+     * call flush_audio() at the end of the stream to get its last samples.
+     * Without resampling, input is converted and mapped straight into the queue in one pass. With resampling,
+     * input is processed by blocks of block_frame frames in preallocated buffers : once the input context
+     * is prepared, a push performs no heap allocation.
+     * 
      * @param input_context Input audio context
      * @param input_data Input audio data array
      * @param input_frame Input audio frame count
      * @return true Push operation succeeded
      * @return false Push operation failed
      */
-	bool push_audio(const audio_ctx& input_context, AudioType* input_data, std::size_t input_frame)
+	bool push_audio(const audio_ctx& input_context, const AudioType* input_data, std::size_t input_frame)
 	{
-		// Converte all sample into float format.
-		const uint8_t input_channels = input_context.m_channel_num;
+		auto* session = session_for(input_context);
+		if (!session)
+			return false;
+
+		// Thin front end : the stages of this (input, expected) pair were selected once, with the session.
+		return (this->*session->m_push)(*session, push_source{.m_interleaved = input_data}, input_frame);
+	}
 
-        // Get convert to float tool function.
-		auto [to_float, _]	  = make_audio_converters<AudioType>();
-		auto input_data_float = std::span{input_data, input_frame * input_channels} 
-                                    | std::views::transform(to_float) 
-                                    | std::ranges::to<std::vector<float>>();
+	/**
+     * @brief Push a sequence of planar audio (one array per channel) into the audio queue.
+     * 
+     * Same result as push_audio() on the interleaved frames, without interleaving them first :
+     * each channel is converted as one contiguous block, then mapped into the queue.
+     * 
+     * @param input_context Input audio context
+     * @param input_channels One array of input_frame samples per input channel
+     * @param input_frame Input audio frame count
+     * @return true Push operation succeeded
+     * @return false Push operation failed
+     */
+	bool push_audio(const audio_ctx& input_context, const AudioType* const* input_channels, std::size_t input_frame)
+	{
+		auto* session = session_for(input_context);
+		if (!session)
+			return false;
 
-		// Buffer for possible resample operation.
-		std::vector<float> temp;
-		// Buffer for possible channel mapping operation
-		std::vector<float> output_audio;
+		return (this->*session->m_push)(*session, push_source{.m_planes = input_channels}, input_frame);
+	}
 
-		if (auto ratio_opt = m_expected_context.need_resample(input_context))
+	/**
+     * @brief Push a sequence of audio whose context is known at compile time.
+     * 
+     * Same result as the runtime push_audio(), but the pipeline is instantiated for this exact pair :
+     * stages with nothing to do compile away (float stereo 48 KHz into float stereo 48 KHz is a plain
+     * copy into the ring, int16 mono into stereo one convert-and-duplicate loop...).
+     * 
+     * @tparam Input Input audio format
+     * @tparam Output Expected audio format of the queue, checked once per call
+     * @param input_data Input audio data array
+     * @param input_frame Input audio frame count
+     * @return true Push operation succeeded
+     * @return false Push operation failed
+     */
+	template <audio_format Input, audio_format Output>
+	bool push_audio(const AudioType* input_data, std::size_t input_frame)
+	{
+		if (m_expected_context != audio_ctx{Output})
 		{
-			const auto ratio				 = *ratio_opt;
-			const auto expected_output_frame = static_cast<size_t>(static_cast<double>(input_frame) * ratio) + 1;
+			log_deferred("push_audio : Output must match expected_context");
+			return false;
+		}
 
-			temp.resize(expected_output_frame * input_channels);
+		auto* session = session_for(audio_ctx{Input});
+		if (!session)
+			return false;
 
-			// Resample with libsamplerate.
-			int	  err_code	= 0;
-			auto* src_state = src_new(SRC_SINC_BEST_QUALITY, input_channels, &err_code);
-			if (src_state && (err_code == 0))
-			{
-				SRC_DATA src_data{};
-				src_data.end_of_input  = 0;
-				src_data.data_in	   = input_data_float.data();
-				src_data.data_out	   = temp.data();
-				src_data.input_frames  = static_cast<long>(input_frame);
-				src_data.output_frames = static_cast<long>(expected_output_frame);
-				src_data.src_ratio	   = ratio;
+		// Drift compensation resamples equal rates too : the runtime pipeline has the resampling stage.
+		if constexpr (Input.m_sample_rate == Output.m_sample_rate)
+			if (session->m_resampler)
+				return (this->*session->m_push)(*session, push_source{.m_interleaved = input_data}, input_frame);
 
-				err_code			   = src_process(src_state, &src_data);
+		return push_stages<Input.m_channel_num, Output.m_channel_num, Input.m_sample_rate != Output.m_sample_rate>(*session, push_source{.m_interleaved = input_data}, input_frame);
+	}
+
+	/**
+     * @brief End of an input stream : push the samples still held by its resampler, then reset it.
+     * 
+     * @param input_context Input audio context of the stream
+     * @return true Flush succeeded (or nothing to flush)
+     * @return false Flush failed
+     */
+	bool flush_audio(const audio_ctx& input_context)
+	{
+		auto& session = m_sessions[input_context.index()];
+		if (!session || !session->m_resampler)
+			return true;
 
-				if (err_code != 0) // Print error message(src_process failed).
-					std::println(stderr, "libsamplerate error : {}", src_strerror(err_code));
-				else // Resample succeeded, cut the buffer size base on generated frame.
-					temp.resize(static_cast<long>(src_data.output_frames_gen * input_channels));
+		const uint8_t input_channels  = input_context.m_channel_num;
+		const size_t  resampled_frame = session->m_resampled.size() / input_channels;
 
-				src_delete(src_state);
-			}
-			else // Print error message(src_new failed).
-				std::println(stderr, "libsamplerate error : {}", src_strerror(err_code));
+		ring_use use(*this, ring_side::producer);
+		if (!use)
+			return false;
 
-			if (err_code != 0)
+		bool succeeded = true;
+		while (true)
+		{
+			auto generated = session->m_resampler->flush(session->m_resampled.data(), resampled_frame);
+			if (!generated)
 				return false;
-		}
-		else // No need of resample
-			temp = std::move(input_data_float);
+			if (*generated == 0)
+				break;
 
-		if (auto matrix_opt = m_expected_context.need_conversion(input_context))
-		{
-			const size_t output_channel_number = m_expected_context.m_channel_num;
-			const size_t temp_frame			   = temp.size() / input_channels;
-			const auto&	 convert_matrix		   = *matrix_opt;
+			succeeded &= enqueue_mapped(use, session->m_remix, input_context.m_channel_num, session->m_resampled.data(), *generated);
+		}
+		return succeeded;
+	}
 
-			// Resize for channel mapping result
-			output_audio.resize(temp_frame * output_channel_number);
+	/**
+     * @brief Drop the resampler history of an input stream (e.g. after a seek).
+     * 
+     * @param input_context Input audio context of the stream
+     */
+	void reset_resampler(const audio_ctx& input_context)
+	{
+		if (auto& session = m_sessions[input_context.index()]; session && session->m_resampler)
+			session->m_resampler->reset();
+	}
 
-			for (size_t frame_idx = 0; frame_idx < temp_frame; frame_idx++)
-			{
-				float* in_frame	 = &temp[frame_idx * input_channels];
-				float* out_frame = &output_audio[frame_idx * output_channel_number];
+	/**
+     * @brief Pop a sequence of audio from the audio queue.
+     * 
+     * Mixing is done by blocks in a fixed size stack buffer, a pop performs no heap allocation.
+     * The popped samples are scaled by the gain and pan ramps of control() as they are added.
+     * 
+     * @param output_ctx Output buffer context(if it is not the same with the expected context, operation will fail)
+     * @param output_buffer Output buffer array
+     * @param frame_count Output buffer frame count
+     * @return true Pop operation succeeded
+     * @return false Pop operation failed
+     */
+	bool pop_audio(const audio_ctx& output_ctx, AudioType* output_buffer, std::size_t frame_count)
+	{
+		// Verify consistency between output and expectated context
+		if (output_ctx != m_expected_context)
+		{
+			log_deferred("pop_audio : output_ctx must match expected_context");
+			return false;
+		}
+		const auto timer = m_counters.time_pop();
+		const size_t channels = m_expected_context.m_channel_num;
 
-				for (const auto& row : convert_matrix)
-					out_frame[&row - convert_matrix.data()] = std::inner_product(row.begin(), row.end(), in_frame, 0.0F);
-			}
+		const ring_use use(*this, ring_side::consumer);
+		if (!use)
+		{
+			account_read(0, frame_count * channels, true);
+			return false;
 		}
 
-		// Push audio data into audio queue
-		size_t drops = 0;
-		for (const auto sample : output_audio.empty() ? temp : output_audio)
-			if (!m_queue.enqueue(sample))
-				drops++;
+		const auto gains = m_control.begin();
 
-		if (drops != 0)
+		// Dequeue, accumulate, clamp and convert in one pass over the ring regions.
+		if (m_storage == queue_storage::interleaved)
 		{
-			std::println(stderr, "push_audio: dropped {} samples (queue full?)\n", drops);
-			return false;
+			const size_t total_samples = frame_count * channels;
+			const size_t popped		   = ring_read(total_samples, [&](const float* region, size_t first, size_t size)
+			{ mix_popped(output_buffer + first, 1, region, 1, size, gains, all_channels, first / channels); }, channels);
+			m_control.end(popped / channels);
+			return account_read(popped, total_samples, true) == total_samples;
 		}
 
-		return true;
+		const size_t popped = ring_read_planes(frame_count, [&](const float* const* planes, size_t first, size_t size)
+		{
+			for (size_t channel = 0; channel < channels; ++channel)
+				mix_popped(output_buffer + (first * channels) + channel, channels, planes[channel], 1, size, gains, channel, first);
+		});
+		m_control.end(popped);
+		return account_read(popped * channels, frame_count * channels, true) == frame_count * channels;
 	}
 
 	/**
-     * @brief Pop a sequence of audio from the audio queue.
+     * @brief Pop a sequence of planar audio (one array per channel) from the audio queue, mixed like pop_audio().
      * 
      * @param output_ctx Output buffer context(if it is not the same with the expected context, operation will fail)
-     * @param output_buffer Output buffer array
+     * @param output_channels One array of frame_count samples per expected channel
      * @param frame_count Output buffer frame count
      * @return true Pop operation succeeded
      * @return false Pop operation failed
      */
-	bool pop_audio(const audio_ctx& output_ctx, AudioType* output_buffer, std::size_t frame_count)
+	bool pop_audio(const audio_ctx& output_ctx, AudioType* const* output_channels, std::size_t frame_count)
 	{
-		// Verify consistency between output and expectated context
 		if (output_ctx != m_expected_context)
 		{
-			std::println(stderr, "pop_audio : output_ctx must match expected_context");
+			log_deferred("pop_audio : output_ctx must match expected_context");
 			return false;
 		}
-		// Theoretical sample array size
-		const size_t	   total_samples = frame_count * m_expected_context.m_channel_num;
-		std::vector<float> output_as_float(total_samples);
+		const auto timer = m_counters.time_pop();
 
-		// Convert existing data to float
-		auto [to_float, from_float] = make_audio_converters<AudioType>();
-		std::ranges::transform(std::span{output_buffer, total_samples}, output_as_float.begin(), to_float);
+		const size_t channels = m_expected_context.m_channel_num;
 
-		// Try pop from queue
-		size_t popped = 0;
-		float  sample = NAN;
-		while (popped < total_samples && m_queue.dequeue(sample))
+		const ring_use use(*this, ring_side::consumer);
+		if (!use)
 		{
-			// Mixing mode : Add pop element to existing audio data.
-			output_as_float[popped] = std::clamp(output_as_float[popped] + sample, -1.0F, 1.0F);
-			++popped;
+			account_read(0, frame_count * channels, true);
+			return false;
 		}
 
-		// Convert to original type
-		std::ranges::transform(output_as_float, output_buffer, from_float);
+		const auto gains = m_control.begin();
+
+		// Planar storage : every channel is one contiguous loop. Interleaved storage : channel samples are strided.
+		if (m_storage == queue_storage::planar)
+		{
+			const size_t popped = ring_read_planes(frame_count, [&](const float* const* planes, size_t first, size_t size)
+			{
+				for (size_t channel = 0; channel < channels; ++channel)
+					mix_popped(output_channels[channel] + first, 1, planes[channel], 1, size, gains, channel, first);
+			});
+			m_control.end(popped);
+			return account_read(popped * channels, frame_count * channels, true) == frame_count * channels;
+		}
 
-		return popped == total_samples;
+		const size_t total_samples = frame_count * channels;
+		const size_t popped		   = ring_read(total_samples, [&](const float* region, size_t first, size_t size)
+		{
+			for (size_t channel = 0; channel < channels; ++channel)
+				mix_popped(output_channels[channel] + (first / channels), 1, region + channel, channels, size / channels, gains, channel, first / channels);
+		}, channels);
+		m_control.end(popped / channels);
+		return account_read(popped, total_samples, true) == total_samples;
 	}
 
-	private:
+	/**
+     * @brief Pop raw float samples at the expected context, no mixing nor conversion.
+     * 
+     * Used by audio_mixer, which accumulates every input in float before a single conversion.
+     * 
+     * @param output Destination buffer, filled with whole frames only
+     * @return std::size_t Samples popped, less than output.size() if the queue runs short
+     */
+	std::size_t pop_float(std::span<float> output)
+	{
+		const auto timer = m_counters.time_pop();
+		const auto copy	 = [](float* target, const float* source, std::size_t count) { std::memcpy(target, source, count * sizeof(float)); };
+
+		const ring_use use(*this, ring_side::consumer);
+		if (!use)
+			return account_read(0, output.size(), true);
+
+		if (m_storage == queue_storage::interleaved)
+			return account_read(ring_read(output.size(), [&](const float* region, std::size_t first, std::size_t size) { copy(&output[first], region, size); },
+										  m_expected_context.m_channel_num),
+								output.size(), true);
+
+		return account_read(read_interleaved(output.size(), copy, output.data()), output.size(), true);
+	}
+
+	/**
+     * @brief Pop float samples at the expected context straight into an accumulator : accumulator += gain * control() gains * samples.
+     * 
+     * The gain and pan ramps of control() are applied inside the accumulation loop, no extra pass over the samples.
+     * 
+     * @param accumulator Float samples to add to (whole frames)
+     * @param gain Linear gain of the popped samples, on top of control()
+     * @return std::size_t Samples popped, less than accumulator.size() if the queue runs short
+     */
+	std::size_t pop_add(std::span<float> accumulator, float gain = 1.0F)
+	{
+		const auto timer = m_counters.time_pop();
+
+		const ring_use use(*this, ring_side::consumer);
+		if (!use)
+			return account_read(0, accumulator.size(), true);
+
+		const std::size_t channels = m_expected_context.m_channel_num;
+		const auto		  gains	   = m_control.begin().scaled(gain);
+
+		std::size_t popped = 0;
+		if (m_storage == queue_storage::interleaved)
+			popped = ring_read(accumulator.size(), [&](const float* region, std::size_t first, std::size_t size)
+			{ gains.accumulate(&accumulator[first], region, first / channels, size / channels); }, channels);
+		else
+			popped = read_interleaved(accumulator.size(), [&](float* target, const float* source, std::size_t count)
+			{ gains.accumulate(target, source, static_cast<std::size_t>(target - accumulator.data()) / channels, count / channels); }, accumulator.data());
+
+		m_control.end(popped / channels);
+		return account_read(popped, accumulator.size(), true);
+	}
+
+	/**
+     * @brief Drop samples from the queue.
+     * 
+     * @param count Sample count, rounded down to whole frames
+     * @return std::size_t Samples dropped, less than count if the queue runs short
+     */
+	std::size_t discard(std::size_t count)
+	{
+		const ring_use use(*this, ring_side::consumer);
+		if (!use)
+			return account_read(0, count, false);
+
+		const std::size_t channels = m_expected_context.m_channel_num;
+		if (m_storage == queue_storage::interleaved)
+			return account_read(m_queue->discard(count, channels), count, false);
+
+		return account_read(m_queue->discard(count / channels) * channels, count, false);
+	}
+
+	/**
+     * @brief Expected (output) audio context of the queue.
+     * 
+     */
+	[[nodiscard]]
+	const audio_ctx& context() const { return m_expected_context; }
+
+	/**
+     * @brief Sample layout inside the queue.
+     * 
+     */
+	[[nodiscard]]
+	queue_storage storage() const { return m_storage; }
+
+	/**
+     * @brief Sample precision inside the queue.
+     * 
+     */
+	[[nodiscard]]
+	queue_precision precision() const { return m_precision; }
+
+	/**
+     * @brief Gain, pan and fades applied by pop_audio() and pop_add(), set lock-free from any thread.
+     * 
+     */
+	[[nodiscard]]
+	mix_control& control() { return m_control; }
+
+	/**
+     * @brief Queue capacity, in frames : a power of two, at least the requested latency.
+     * 
+     */
+	[[nodiscard]]
+	std::size_t capacity_frames() const
+	{
+		const ring_use use(*this, ring_side::consumer);
+		return use ? m_queue->capacity() / slots_per_frame() : 0;
+	}
+
+	/**
+     * @brief Memory held by the queue samples, in bytes.
+     * 
+     */
+	[[nodiscard]]
+	std::size_t footprint() const
+	{
+		const ring_use use(*this, ring_side::producer);
+		return use ? m_queue->footprint() : 0;
+	}
+
+	/**
+     * @brief Change the queue capacity (in latency, ms) at runtime, from a non real-time thread.
+     * 
+     * The new ring is allocated first, then swapped in once no push nor pop is running : it receives the
+     * frames of the old one, the oldest being dropped (counted as overwritten) if they do not fit.
+     * Pushes and pops racing the swap find the queue full or empty, like any overflow or underrun.
+     * A queue over a ring sized elsewhere (shared between processes) keeps its capacity.
+     * 
+     * @param latency_ms New capacity, in latency (ms)
+     */
+	void set_latency(std::size_t latency_ms)
+	{
+		if (m_fixed_ring)
+		{
+			log_deferred("set_latency : the ring of this queue has a fixed capacity");
+			return;
+		}
+
+		auto ring = make_ring(latency_ms);
+
+		const std::scoped_lock lock(m_resize_mutex);
+		m_resizing.store(true, std::memory_order_seq_cst);
+		for (const auto& users : m_ring_users)
+			while (users.m_count.load(std::memory_order_seq_cst) != 0)
+				std::this_thread::yield();
+
+		if (const std::size_t ready = m_queue->size(); ready > ring->capacity())
+			m_counters.overwritten(m_queue->discard(ready - ring->capacity()) / slots_per_frame());
+
+		if (m_precision == queue_precision::int16)
+			move_samples<std::int16_t>(*m_queue, *ring);
+		else
+			move_samples<float>(*m_queue, *ring);
+
+		m_queue = std::move(ring);
+		m_resizing.store(false, std::memory_order_release);
+
+		// Waiters for a level of the old ring check it against the new one
+		m_ready_wait.signal();
+		m_free_wait.signal();
+	}
+
+	/**
+     * @brief Select what pushes do when the queue is full (drop_newest by default), from any thread.
+     * 
+     * @param policy Overflow policy
+     * @param timeout Longest wait of a push, with overflow_policy::block
+     */
+	void set_overflow_policy(overflow_policy policy, std::chrono::milliseconds timeout = std::chrono::milliseconds{0})
+	{
+		m_overflow_timeout_ns.store(std::chrono::nanoseconds(timeout).count(), std::memory_order_relaxed);
+		m_overflow.store(policy, std::memory_order_relaxed);
+	}
+
+	/**
+     * @brief Current overflow policy.
+     * 
+     */
+	[[nodiscard]]
+	overflow_policy overflow() const { return m_overflow.load(std::memory_order_relaxed); }
+
+	/**
+     * @brief Hold the queue fill level at a target latency against producer / consumer clock drift.
+     * 
+     * Every input context prepared afterwards is resampled, equal rates included, with a ratio corrected
+     * by its fill level : call it before prepare_input() and the first push. The queue capacity then only
+     * needs a margin above the target, instead of absorbing hours of drift. The compensation corrects
+     * drift, not start up : the consumer is expected to start once the queue holds about the target.
+     * 
+     * @param settings Target latency (0 disables), largest correction and loop response time
+     */
+	void set_drift_compensation(const drift_compensation& settings) { m_drift = settings; }
+
+	/**
+     * @brief Frames that can be pushed without overflowing, at the expected context (a snapshot, may change concurrently).
+     * 
+     * With resampling, a push of n input frames enqueues about n x expected rate / input rate frames.
+     * 
+     */
+	[[nodiscard]]
+	std::size_t free_frames() const
+	{
+		const ring_use use(*this, ring_side::producer);
+		return use ? m_queue->free() / slots_per_frame() : 0;
+	}
+
+	/**
+     * @brief Frames ready to pop, at the expected context (a snapshot, may change concurrently).
+     * 
+     */
+	[[nodiscard]]
+	std::size_t ready_frames() const
+	{
+		const ring_use use(*this, ring_side::consumer);
+		return use ? m_queue->size() / slots_per_frame() : 0;
+	}
+
+	/**
+     * @brief Sleep until a number of frames is ready to pop, or a timeout : for consumers off the real-time path
+     * (encoders, file writers, network senders), instead of polling.
+     * 
+     * The waiter registers how many frames it needs : pushes wake it once they are there, not on every push.
+     * Without waiter, pushes and pops pay one fence and one load.
+     * 
+     * @param frames Frames to wait for, at the expected context (at most the capacity)
+     * @param timeout Longest wait
+     * @return true The frames are ready
+     */
+	bool wait_for_frames(std::size_t frames, std::chrono::nanoseconds timeout)
+	{
+		frames = std::min(frames, capacity_frames());
+		return m_ready_wait.wait(frames, timeout, [&] { return ready_frames() >= frames; });
+	}
+
+	/**
+     * @brief Sleep until a number of frames can be pushed, or a timeout, see wait_for_frames().
+     * 
+     * @param frames Frames to wait room for, at the expected context (at most the capacity)
+     * @param timeout Longest wait
+     * @return true The room is free
+     */
+	bool wait_for_space(std::size_t frames, std::chrono::nanoseconds timeout)
+	{
+		frames = std::min(frames, capacity_frames());
+		return m_free_wait.wait(frames, timeout, [&] { return free_frames() >= frames; });
+	}
+
+	/**
+     * @brief Wait point of the frames ready to pop (for wait services, see audio_wait_service).
+     * 
+     */
+	[[nodiscard]]
+	wait_point& ready_wait() { return m_ready_wait; }
+
+	/**
+     * @brief Wait point of the room free to push (for wait services, see audio_wait_service).
+     * 
+     */
+	[[nodiscard]]
+	wait_point& free_wait() { return m_free_wait; }
+
+	/**
+     * @brief Free ring memory lent by acquire_write() : write float frames of the expected context in place, then commit().
+     * 
+     * Holds the ring (set_latency() waits for it) and delays the pushes of other producers : commit quickly.
+     * Destroyed without commit(), it publishes nothing.
+     * 
+     */
+	class write_view : public ring_frames<float>
+	{
+	public:
+
+		write_view() = default;
+		write_view(write_view&& other) noexcept
+			: ring_frames<float>(other),
+			  m_owner(std::exchange(other.m_owner, nullptr)),
+			  m_claim(other.m_claim)
+		{}
+		write_view(const write_view&)			 = delete;
+		write_view& operator=(const write_view&) = delete;
+		write_view& operator=(write_view&&)		 = delete;
+
+		~write_view() { commit(0); }
+
+		/**
+         * @brief Publish the first frames written, then end the view. The rest is given back, or published as
+         * silence if another producer acquired room after this view.
+         * 
+         * @return std::size_t Frames published, silence included
+         */
+		std::size_t commit(std::size_t frames)
+		{
+			if (m_owner == nullptr)
+				return 0;
+			return std::exchange(m_owner, nullptr)->end_write_view(m_claim, frames);
+		}
+
+	private:
+
+		friend audio_queue;
+
+		audio_queue*	   m_owner = nullptr; // Null once committed
+		audio_ring::claim  m_claim;
+	};
+
+	/**
+     * @brief Ready ring memory lent by acquire_read() : use the float frames in place, then release() them.
+     * 
+     * Holds the ring (set_latency() waits for it) and delays the pops of other consumers : release quickly.
+     * Destroyed without release(), it leaves the frames ready.
+     * 
+     */
+	class read_view : public ring_frames<const float>
+	{
+	public:
+
+		read_view() = default;
+		read_view(read_view&& other) noexcept
+			: ring_frames<const float>(other),
+			  m_owner(std::exchange(other.m_owner, nullptr)),
+			  m_claim(other.m_claim)
+		{}
+		read_view(const read_view&)			   = delete;
+		read_view& operator=(const read_view&) = delete;
+		read_view& operator=(read_view&&)	   = delete;
+
+		~read_view() { release(0); }
+
+		/**
+         * @brief Free the first frames used, then end the view. The rest stays ready, or is dropped if another
+         * consumer acquired frames after this view.
+         * 
+         * @return std::size_t Frames freed, dropped included
+         */
+		std::size_t release(std::size_t frames)
+		{
+			if (m_owner == nullptr)
+				return 0;
+			return std::exchange(m_owner, nullptr)->end_read_view(m_claim, frames);
+		}
+
+	private:
+
+		friend audio_queue;
+
+		audio_queue*	  m_owner = nullptr; // Null once released
+		audio_ring::claim m_claim;
+	};
+
+	/**
+     * @brief Lend free ring memory to write up to a number of frames in place : a decoder or DSP renders straight into
+     * the queue, without the copy of push_audio().
+     * 
+     * Frames are stored as written : they must already be float samples of the expected context (no conversion,
+     * channel mapping nor resampling). Float precision queues only.
+     * 
+     * @param frames Frames wanted
+     * @return write_view The memory, of fewer frames if the queue has no room for all (none if full, or with int16 precision)
+     */
+	[[nodiscard]]
+	write_view acquire_write(std::size_t frames)
+	{
+		write_view view;
+		if (m_precision != queue_precision::float32)
+		{
+			log_deferred("acquire_write : in place access needs float32 precision");
+			return view;
+		}
+		if (!enter_ring(ring_side::producer))
+			return view;
+
+		view.m_claim = m_queue->begin_write(frames * slots_per_frame(), slots_per_frame());
+		if (view.m_claim.m_size == 0)
+		{
+			leave_ring(ring_side::producer);
+			return view;
+		}
+
+		lend(view, view.m_claim);
+		view.m_owner = this;
+		return view;
+	}
+
+	/**
+     * @brief Lend ready ring memory to use up to a number of frames in place, without the copy of pop_audio().
+     * 
+     * Frames are the stored float samples : gain and pan (control()) are not applied. Float precision queues only.
+     * 
+     * @param frames Frames wanted
+     * @return read_view The memory, of fewer frames if fewer are ready (none if empty, or with int16 precision)
+     */
+	[[nodiscard]]
+	read_view acquire_read(std::size_t frames)
+	{
+		read_view view;
+		if (m_precision != queue_precision::float32)
+		{
+			log_deferred("acquire_read : in place access needs float32 precision");
+			return view;
+		}
+		if (!enter_ring(ring_side::consumer))
+			return view;
+
+		view.m_claim = m_queue->begin_read(frames * slots_per_frame(), slots_per_frame());
+		if (view.m_claim.m_size == 0)
+		{
+			leave_ring(ring_side::consumer);
+			return view;
+		}
+
+		lend(view, view.m_claim);
+		view.m_owner = this;
+		return view;
+	}
+
+	/**
+     * @brief Snapshot of the queue counters, callable from any thread (e.g. a monitoring one) at any time.
+     * 
+     * Reading the counters never contends with the audio path : no lock, no write to shared state.
+     * 
+     */
+	[[nodiscard]]
+	queue_stats stats() const
+	{
+		// Outside the ring : a swappable ring may be freed meanwhile, its fill level comes from the counters.
+		return m_counters.snapshot(m_fixed_ring ? m_queue->size() / slots_per_frame() : m_counters.fill_frames());
+	}
+
+	private:
+
+	/**
+     * @brief Side of a ring access : producers and consumers count their accesses on their own cache lines.
+     * 
+     */
+	enum class ring_side : std::uint8_t
+	{
+		producer,
+		consumer
+	};
+
+	/**
+     * @brief Ring access of a push, pop or query : the ring is not swapped (set_latency()) while one is alive.
+     * 
+     * Fails instead of waiting while a swap is running : the real-time paths never block.
+     * 
+     */
+	class ring_use
+	{
+	public:
+
+		ring_use(const audio_queue& queue, ring_side side)
+			: m_owner(queue),
+			  m_side(side),
+			  m_active(queue.enter_ring(side))
+		{}
+
+		ring_use(const ring_use&)			 = delete;
+		ring_use& operator=(const ring_use&) = delete;
+
+		~ring_use() { leave(); }
+
+		explicit operator bool() const { return m_active; }
+
+		/**
+         * @brief Stop using the ring before a sleep : enter() again before the next access.
+         * 
+         */
+		void leave()
+		{
+			if (std::exchange(m_active, false))
+				m_owner.leave_ring(m_side);
+		}
+
+		/**
+         * @brief Use the ring again after leave().
+         * 
+         * @return false The ring is being swapped
+         */
+		bool enter()
+		{
+			m_active = m_owner.enter_ring(m_side);
+			return m_active;
+		}
+
+	private:
+
+		const audio_queue& m_owner;
+		ring_side		   m_side;
+		bool			   m_active = true;
+	};
+
+	/**
+     * @brief Per input context state of the push path : resampler history and scratch buffers.
+     * 
+     */
+	struct push_session;
+
+	/**
+     * @brief Input samples of a push : interleaved frames, or one array per channel.
+     * 
+     */
+	struct push_source
+	{
+		const AudioType*		m_interleaved = nullptr;
+		const AudioType* const* m_planes	  = nullptr; // Planar input if not null
+	};
+
+	// Push pipeline of one (input layout, expected layout, resampling) combination
+	using push_function = bool (audio_queue::*)(push_session& session, push_source input, std::size_t input_frame);
+
+	struct push_session
+	{
+		std::optional<resampler> m_resampler;		  // Engaged if the input context needs resampling
+		remix_function			 m_remix = nullptr; // Null if the input context needs no channel mapping
+		push_function			 m_push	 = nullptr; // Specialized stages of the input context
+
+		std::optional<drift_controller> m_drift;		   // Engaged with drift compensation
+		double							m_nominal_ratio = 1.0; // Expected rate / input rate
+
+		std::vector<float> m_input;		// One input block converted to float (resampling only)
+		std::vector<float> m_resampled; // Resampler output for one input block (resampling only)
+	};
+
+	/**
+     * @brief Push pipeline specialized for one (input layout, expected layout, resampling) combination.
+     * 
+     * Without resampling, conversion and channel mapping write straight into the ring : one pass over
+     * the input, no intermediate buffer, by blocks small enough to stay in L1.
+     * With resampling : convert, resample (input layout), then map straight into the ring.
+     * Planar input or storage goes through the per channel mapping (enqueue_rows).
+     * 
+     * @tparam In Input channel layout
+     * @tparam Out Expected channel layout
+     * @tparam Resample Input and expected sample rates differ
+     */
+	template <channel_layout::value In, channel_layout::value Out, bool Resample>
+	bool push_stages(push_session& session, push_source input, std::size_t input_frame)
+	{
+		const auto timer	 = m_counters.time_push();
+		bool	   succeeded = true;
+
+		const size_t needed = Resample ? session.m_resampler->max_output_frames(input_frame) : input_frame;
+		ring_use	 use(*this, ring_side::producer);
+		if (!use)
+		{
+			// Ring being swapped : dropped, without looking at its fill level
+			m_counters.pushed(0, needed * m_expected_context.m_channel_num);
+			return false;
+		}
+
+		// All or nothing : a push that would not fit is dropped before touching the ring (or the resampler history).
+		// The check and the writes are not one atomic step : producers of other input contexts can still cut it short.
+		if (overflow() == overflow_policy::drop_push && m_queue->free() / slots_per_frame() < needed)
+			return account_write(needed, 0);
+
+		if constexpr (!Resample)
+		{
+			constexpr size_t fused_block_frame = fused_block_sample / std::max<size_t>(In, Out);
+			for (size_t block_offset = 0; block_offset < input_frame; block_offset += fused_block_frame)
+			{
+				const size_t block_frames = std::min(fused_block_frame, input_frame - block_offset);
+				if (input.m_planes || m_storage == queue_storage::planar)
+				{
+					succeeded &= enqueue_rows<In, Out>(use, source_rows<In>(input, block_offset), input.m_planes ? 1 : In, block_frames);
+					continue;
+				}
+
+				const AudioType* block_input = input.m_interleaved + (block_offset * In);
+
+				// Regions are whole frames : the ring capacity and every write are multiples of Out.
+				succeeded &= enqueue_frames(use, block_frames, [&](size_t done, size_t frames)
+				{
+					return ring_write(
+							   frames * Out,
+							   [&](float* region, size_t first, size_t size) { convert_and_map<In, Out>(block_input + ((done + (first / Out)) * In), region, size / Out); },
+							   Out) / Out;
+				});
+			}
+		}
+		else
+		{
+			for (size_t block_offset = 0; block_offset < input_frame; block_offset += block_frame)
+			{
+				const size_t block_frames = std::min(block_frame, input_frame - block_offset);
+
+				// Only the new frames go through the filter, its history is kept by the session.
+				auto block = std::span{session.m_input}.first(block_frames * In);
+				if (input.m_planes)
+				{
+					const auto to_float = make_audio_converters<AudioType>().first;
+					for (size_t channel = 0; channel < In; ++channel)
+						for (size_t frame_idx = 0; frame_idx < block_frames; ++frame_idx)
+							block[(frame_idx * In) + channel] = to_float(input.m_planes[channel][block_offset + frame_idx]);
+				}
+				else
+					convert_to_float(std::span<const AudioType>{input.m_interleaved + (block_offset * In), block.size()}, block);
+
+				auto&		 state			 = *session.m_resampler;
+				const size_t resampled_frame = session.m_resampled.size() / In;
+
+				if (session.m_drift)
+					state.set_ratio(session.m_nominal_ratio * (1.0 + drift_correction(*session.m_drift, session.m_nominal_ratio, block_frames)));
+				size_t		 used_frame		 = 0;
+				while (used_frame < block_frames)
+				{
+					const auto resample_start = std::chrono::steady_clock::now();
+					auto	   result		  = state.process(&block[used_frame * In], block_frames - used_frame, session.m_resampled.data(), resampled_frame);
+					m_counters.resampled(std::chrono::steady_clock::now() - resample_start);
+					if (!result) // The rest of the push is lost : counted as dropped
+						return account_write(state.max_output_frames(input_frame - block_offset - used_frame), 0);
+
+					used_frame += result->frames_used;
+
+					const float* resampled = session.m_resampled.data();
+					if (m_storage == queue_storage::planar)
+					{
+						std::array<const float*, In> rows;
+						for (size_t channel = 0; channel < In; ++channel)
+							rows[channel] = resampled + channel;
+						succeeded &= enqueue_rows<In, Out>(use, rows, In, result->frames_generated);
+						continue;
+					}
+
+					succeeded &= enqueue_frames(use, result->frames_generated, [&](size_t done, size_t frames)
+					{
+						return ring_write(
+								   frames * Out,
+								   [&](float* region, size_t first, size_t size) { convert_and_map<In, Out>(resampled + ((done + (first / Out)) * In), region, size / Out); },
+								   Out) / Out;
+					});
+				}
+			}
+		}
+
+		return succeeded;
+	}
+
+	/**
+     * @brief Ratio correction of an input block, from the fill level seen before it.
+     * 
+     */
+	double drift_correction(drift_controller& drift, double nominal_ratio, std::size_t block_frames)
+	{
+		const auto	 expected_rate = static_cast<double>(m_expected_context.m_sample_rate);
+		const double fill_seconds  = static_cast<double>(m_queue->size() / slots_per_frame()) / expected_rate;
+		const double correction	   = drift.update(fill_seconds, static_cast<double>(block_frames) * nominal_ratio / expected_rate);
+		m_counters.corrected(correction);
+		return correction;
+	}
+
+	/**
+     * @brief Convert input frames to float and map them to the expected layout, in one pass.
+     * 
+     * @tparam In Input channel layout
+     * @tparam Out Expected channel layout
+     * @tparam SourceType Input sample type (float for resampled frames)
+     */
+	template <channel_layout::value In, channel_layout::value Out, audio_sample_type SourceType>
+	static void convert_and_map(const SourceType* input, float* output, std::size_t frames)
+	{
+		if constexpr (In == Out)
+			convert_to_float(std::span<const SourceType>{input, frames * In}, std::span{output, frames * Out});
+		else if constexpr (std::is_same_v<SourceType, float>)
+			detail::remix_kernel<In, Out>(input, output, frames);
+		else
+		{
+			// Converted by tiles of at most 8 KB kept in L1, then mapped : both passes stay vectorized.
+			constexpr std::size_t		   tile_frame = 256;
+			std::array<float, tile_frame * In> tile;
+			for (std::size_t frame_idx = 0; frame_idx < frames; frame_idx += tile_frame)
+			{
+				const std::size_t tile_frames = std::min(tile_frame, frames - frame_idx);
+				convert_to_float(std::span<const SourceType>{input + (frame_idx * In), tile_frames * In}, std::span{tile});
+				detail::remix_kernel<In, Out>(tile.data(), output + (frame_idx * Out), tile_frames);
+			}
+		}
+	}
+
+	/**
+     * @brief Per channel input rows of a push block : frame i of channel c at rows[c][i * stride].
+     * 
+     */
+	template <channel_layout::value In>
+	static std::array<const AudioType*, In> source_rows(push_source input, std::size_t first_frame)
+	{
+		std::array<const AudioType*, In> rows;
+		for (std::size_t channel = 0; channel < In; ++channel)
+			rows[channel] = input.m_planes ? input.m_planes[channel] + first_frame : input.m_interleaved + (first_frame * In) + channel;
+		return rows;
+	}
+
+	/**
+     * @brief Convert and map frames into the ring one channel at a time, when the input or the storage is planar.
+     * 
+     * Rows are converted by tiles kept in L1 (one contiguous conversion per planar row), then mapped
+     * by the per channel kernel : same sums, in the same order, as convert_and_map().
+     * 
+     * @tparam In Input channel layout
+     * @tparam Out Expected channel layout
+     * @tparam SourceType Input sample type (float for resampled frames)
+     * @param use Ring use of the push
+     * @param input One row per input channel
+     * @param input_stride Distance between two samples of a row : 1 for planar input, In for interleaved input
+     * @param frames Frame count
+     */
+	template <channel_layout::value In, channel_layout::value Out, audio_sample_type SourceType>
+	bool enqueue_rows(ring_use& use, const std::array<const SourceType*, In>& input, std::size_t input_stride, std::size_t frames)
+	{
+		const auto map = [&](float* const* output, std::size_t output_stride, std::size_t first, std::size_t count)
+		{
+			constexpr std::size_t			   tile_frame = 256;
+			std::array<float, tile_frame * In> tile;
+
+			for (std::size_t frame_idx = 0; frame_idx < count; frame_idx += tile_frame)
+			{
+				const std::size_t tile_frames = std::min(tile_frame, count - frame_idx);
+				const std::size_t source	  = (first + frame_idx) * input_stride;
+
+				std::array<const float*, In> rows;
+				if constexpr (std::is_same_v<SourceType, float>)
+					for (std::size_t channel = 0; channel < In; ++channel)
+						rows[channel] = input[channel] + source;
+				else if (input_stride == 1)
+					for (std::size_t channel = 0; channel < In; ++channel)
+					{
+						convert_to_float(std::span<const SourceType>{input[channel] + source, tile_frames}, std::span{tile}.subspan(channel * tile_frame, tile_frames));
+						rows[channel] = &tile[channel * tile_frame];
+					}
+				else
+				{
+					// Interleaved rows : converted as one block, still interleaved.
+					convert_to_float(std::span<const SourceType>{input[0] + source, tile_frames * In}, std::span{tile});
+					for (std::size_t channel = 0; channel < In; ++channel)
+						rows[channel] = &tile[channel];
+				}
+
+				std::array<float*, Out> targets;
+				for (std::size_t channel = 0; channel < Out; ++channel)
+					targets[channel] = output[channel] + (frame_idx * output_stride);
+
+				detail::remix_planes_kernel<In, Out>(rows.data(), input_stride, targets.data(), output_stride, tile_frames);
+			}
+		};
+
+		return enqueue_frames(use, frames, [&](std::size_t done, std::size_t count)
+		{
+			if (m_storage == queue_storage::planar)
+				return ring_write_planes(count, [&](float* const* planes, std::size_t first, std::size_t size) { map(planes, 1, done + first, size); });
+
+			return ring_write(count * Out, [&](float* region, std::size_t first, std::size_t size)
+			{
+				std::array<float*, Out> rows;
+				for (std::size_t channel = 0; channel < Out; ++channel)
+					rows[channel] = region + channel;
+				map(rows.data(), Out, done + (first / Out), size / Out);
+			}, Out) / Out;
+		});
+	}
+
+	/**
+     * @brief Mix popped samples into a (possibly strided) output : clamp(output + gains x popped), by blocks kept in L1.
+     * 
+     * Contiguous outputs are converted by the vectorized kernels, strided ones sample by sample (same values).
+     * 
+     * @param gains Gains of the pop
+     * @param channel Channel of the samples, all_channels for whole interleaved frames
+     * @param first_frame Position of the first sample in the pop, in frames
+     */
+	static void mix_popped(AudioType* output, std::size_t output_stride, const float* popped, std::size_t popped_stride, std::size_t count,
+						   const mix_gains& gains, std::size_t channel, std::size_t first_frame)
+	{
+		const auto [to_float, from_float] = make_audio_converters<AudioType>();
+		std::array<float, pop_block_sample> mixed;
+
+		// Interleaved : blocks of whole frames
+		const std::size_t frame_size = channel == all_channels ? gains.m_channels : 1;
+		const std::size_t block_size = mixed.size() / frame_size * frame_size;
+
+		for (std::size_t offset = 0; offset < count; offset += block_size)
+		{
+			const std::size_t block		  = std::min(block_size, count - offset);
+			AudioType*		  output_block = output + (offset * output_stride);
+			const float*	  popped_block = popped + (offset * popped_stride);
+
+			// Mixing mode : Add pop element to existing audio data.
+			// Samples left untouched keep their original value.
+			if (output_stride == 1)
+				convert_to_float(std::span<const AudioType>{output_block, block}, std::span{mixed}.first(block));
+			else
+				for (std::size_t i = 0; i < block; ++i)
+					mixed[i] = to_float(output_block[i * output_stride]);
+
+			if (channel == all_channels)
+				gains.accumulate(mixed.data(), popped_block, first_frame + (offset / frame_size), block / frame_size);
+			else
+				gains.accumulate_channel(mixed.data(), 1, popped_block, popped_stride, channel, first_frame + offset, block);
+
+			for (std::size_t i = 0; i < block; ++i)
+				mixed[i] = std::clamp(mixed[i], -1.0F, 1.0F);
+
+			// Convert to original type
+			if (output_stride == 1)
+				convert_from_float(std::span<const float>{mixed}.first(block), std::span{output_block, block});
+			else
+				for (std::size_t i = 0; i < block; ++i)
+					output_block[i * output_stride] = from_float(mixed[i]);
+		}
+	}
+
+	/**
+     * @brief Read up to count samples from planar storage as interleaved frames : apply(target, source, size) per channel run.
+     * 
+     * @return std::size_t Samples read (whole frames)
+     */
+	template <typename Apply>
+	std::size_t read_interleaved(std::size_t count, Apply&& apply, float* output)
+	{
+		const std::size_t channels = m_expected_context.m_channel_num;
+		return channels * ring_read_planes(count / channels, [&](const float* const* planes, std::size_t first, std::size_t size)
+		{
+			// Interleaved by small tiles, then applied to the contiguous output run.
+			constexpr std::size_t		   tile_frame = pop_block_sample / channel_layout::SevenPointOne;
+			std::array<float, pop_block_sample> tile;
+			for (std::size_t frame_idx = 0; frame_idx < size; frame_idx += tile_frame)
+			{
+				const std::size_t tile_frames = std::min(tile_frame, size - frame_idx);
+				for (std::size_t channel = 0; channel < channels; ++channel)
+					for (std::size_t i = 0; i < tile_frames; ++i)
+						tile[(i * channels) + channel] = planes[channel][frame_idx + i];
+				apply(output + ((first + frame_idx) * channels), tile.data(), tile_frames * channels);
+			}
+		});
+	}
+
+	/**
+     * @brief Map float frames at the expected rate (runtime mapping function, null if none) straight into the ring.
+     * 
+     */
+	bool enqueue_mapped(ring_use& use, remix_function remix, channel_layout input_layout, const float* input, std::size_t frames)
+	{
+		const std::size_t input_channels  = input_layout;
+		const std::size_t output_channels = m_expected_context.m_channel_num;
+
+		const auto remix_planes = remix_planes_for(input_layout, m_expected_context.m_channel_num);
+
+		return enqueue_frames(use, frames, [&](std::size_t done, std::size_t count)
+		{
+			if (m_storage == queue_storage::planar)
+				return ring_write_planes(count, [&](float* const* planes, std::size_t first, std::size_t size)
+				{
+					std::array<const float*, channel_layout::SevenPointOne> rows;
+					for (std::size_t channel = 0; channel < input_channels; ++channel)
+						rows[channel] = input + ((done + first) * input_channels) + channel;
+					remix_planes(rows.data(), input_channels, planes, 1, size);
+				});
+
+			return ring_write(count * output_channels, [&](float* region, std::size_t first, std::size_t size)
+			{
+				const float* source = input + ((done + (first / output_channels)) * input_channels);
+				if (remix)
+					remix(source, region, size / output_channels);
+				else
+					std::memcpy(region, source, size * sizeof(float));
+			}, output_channels) / output_channels;
+		});
+	}
+
+	/**
+     * @brief Write frames to the ring with write(done, count) -> frames written, applying the overflow policy to those not fitting.
+     * 
+     * write() only ever writes whole frames : a frame is never split between written and dropped channels.
+     * A push whose ring use was lost (see overflow_policy::block) drops its remaining frames without touching the ring.
+     * 
+     * @return false Frames were dropped
+     */
+	template <typename Write>
+	bool enqueue_frames(ring_use& use, std::size_t frames, Write&& write)
+	{
+		if (!use)
+		{
+			m_counters.pushed(0, frames * m_expected_context.m_channel_num);
+			return false;
+		}
+
+		std::size_t done = write(0, frames);
+
+		switch (overflow())
+		{
+			case overflow_policy::overwrite_oldest:
+				// Make room by dropping the oldest frames, a capacity at a time for pushes larger than the queue.
+				// Gives up if consumers keep the ring reserved (no progress) for a few attempts.
+				for (std::size_t stalled = 0; done < frames && stalled < overwrite_attempts;)
+				{
+					const std::size_t room = std::min(frames - done, m_queue->capacity() / slots_per_frame());
+					if (const std::size_t free = m_queue->free() / slots_per_frame(); free < room)
+						m_counters.overwritten(discard_frames(room - free));
+
+					const std::size_t written = write(done, frames - done);
+					done += written;
+					stalled = written == 0 ? stalled + 1 : 0;
+				}
+				break;
+
+			case overflow_policy::block:
+			{
+				// Sleep until a consumer frees any room : the frames written so far wake it first. Waiting for more room
+				// could deadlock with a consumer waiting for more frames than are left.
+				// The ring is left while sleeping : a set_latency() waits for every use to end, and pops fail meanwhile.
+				const auto deadline = std::chrono::steady_clock::now() + overflow_timeout();
+				while (done < frames)
+				{
+					notify_ready();
+					use.leave();
+					const bool room = m_free_wait.wait(1, deadline - std::chrono::steady_clock::now(), [&] { return free_frames() != 0; });
+					if (!use.enter())
+					{
+						// Ring swapped meanwhile : the push stops there
+						m_counters.pushed(done, (frames - done) * m_expected_context.m_channel_num);
+						log_deferred("push_audio : samples dropped (queue resized while blocked)", static_cast<std::int64_t>((frames - done) * m_expected_context.m_channel_num));
+						return false;
+					}
+					if (!room)
+						break;
+					done += write(done, frames - done);
+				}
+				break;
+			}
+
+			default:
+				break;
+		}
+
+		return account_write(frames, done);
+	}
+
+	/**
+     * @brief Fill the regions of a view over a claim of whole frames.
+     * 
+     */
+	template <typename View>
+	void lend(View& view, const audio_ring::claim& block) const
+	{
+		const std::size_t slots = slots_per_frame();
+		const std::size_t first = std::min(block.m_size, m_queue->contiguous(block.m_start));
+
+		view.m_regions		 = {m_queue->template plane_at<float>(0, block.m_start), m_queue->template plane_at<float>(0, block.m_start + first)};
+		view.m_frames		 = {first / slots, (block.m_size - first) / slots};
+		view.m_frame_samples = slots;
+		view.m_plane_stride	 = m_queue->capacity();
+	}
+
+	/**
+     * @brief commit() of a write view : publish, count and signal its frames, then leave the ring.
+     * 
+     */
+	std::size_t end_write_view(const audio_ring::claim& block, std::size_t frames)
+	{
+		const std::size_t published = m_queue->end_write(block, frames * slots_per_frame()) / slots_per_frame();
+		m_counters.pushed(published, 0);
+		m_counters.filled(m_queue->size() / slots_per_frame());
+		if (published != 0)
+			notify_ready();
+
+		leave_ring(ring_side::producer);
+		return published;
+	}
+
+	/**
+     * @brief release() of a read view : free, count and signal its frames, then leave the ring.
+     * 
+     */
+	std::size_t end_read_view(const audio_ring::claim& block, std::size_t frames)
+	{
+		const std::size_t channels = m_expected_context.m_channel_num;
+		const std::size_t freed	   = m_queue->end_read(block, frames * slots_per_frame()) / slots_per_frame();
+		account_read(freed * channels, freed * channels, false);
+
+		leave_ring(ring_side::consumer);
+		return freed;
+	}
+
+	/**
+     * @brief Register a ring access outliving a scope (a lent view), see ring_use.
+     * 
+     * @return false The ring is being swapped
+     */
+	bool enter_ring(ring_side side) const
+	{
+		// Pairs with set_latency() : either it sees this use, or this use sees the swap.
+		auto& users = m_ring_users[static_cast<std::size_t>(side)].m_count;
+		users.fetch_add(1, std::memory_order_seq_cst);
+		if (m_resizing.load(std::memory_order_seq_cst))
+		{
+			users.fetch_sub(1, std::memory_order_release);
+			return false;
+		}
+		return true;
+	}
+
+	/**
+     * @brief End a ring access registered by enter_ring().
+     * 
+     */
+	void leave_ring(ring_side side) const
+	{
+		m_ring_users[static_cast<std::size_t>(side)].m_count.fetch_sub(1, std::memory_order_release);
+	}
+
+	/**
+     * @brief write_with() on the ring in float whatever its precision : int16 storage is filled by tiles kept in L1, then narrowed.
+     * 
+     */
+	template <typename Fill>
+	std::size_t ring_write(std::size_t count, Fill&& fill, std::size_t granule = 1)
+	{
+		if (m_precision == queue_precision::float32)
+			return m_queue->write_with(count, fill, granule);
+
+		return m_queue->write_with<std::int16_t>(count, [&](std::int16_t* region, std::size_t first, std::size_t size)
+		{
+			std::array<float, precision_tile_sample> tile;
+			const std::size_t tile_size = precision_tile_sample / granule * granule; // Whole frames
+			for (std::size_t offset = 0; offset < size; offset += tile_size)
+			{
+				const std::size_t chunk = std::min(tile_size, size - offset);
+				fill(tile.data(), first + offset, chunk);
+				convert_from_float(std::span<const float>{tile.data(), chunk}, std::span{region + offset, chunk});
+			}
+		}, granule);
+	}
+
+	/**
+     * @brief write_planes_with() on the ring in float whatever its precision, see ring_write().
+     * 
+     */
+	template <typename Fill>
+	std::size_t ring_write_planes(std::size_t count, Fill&& fill)
+	{
+		if (m_precision == queue_precision::float32)
+			return m_queue->write_planes_with(count, fill);
+
+		return m_queue->write_planes_with<std::int16_t>(count, [&](std::int16_t* const* planes, std::size_t first, std::size_t size)
+		{
+			const std::size_t						   plane_count = m_queue->planes();
+			const std::size_t						   tile_frame  = precision_tile_sample / plane_count;
+			std::array<float, precision_tile_sample>   tile;
+			std::array<float*, audio_ring::max_planes> rows{};
+			for (std::size_t plane = 0; plane < plane_count; ++plane)
+				rows[plane] = &tile[plane * tile_frame];
+
+			for (std::size_t offset = 0; offset < size; offset += tile_frame)
+			{
+				const std::size_t chunk = std::min(tile_frame, size - offset);
+				fill(rows.data(), first + offset, chunk);
+				for (std::size_t plane = 0; plane < plane_count; ++plane)
+					convert_from_float(std::span<const float>{rows[plane], chunk}, std::span{planes[plane] + offset, chunk});
+			}
+		});
+	}
+
+	/**
+     * @brief read_with() on the ring in float whatever its precision : int16 storage is widened by tiles kept in L1.
+     * 
+     */
+	template <typename Consume>
+	std::size_t ring_read(std::size_t count, Consume&& consume, std::size_t granule = 1)
+	{
+		if (m_precision == queue_precision::float32)
+			return m_queue->read_with(count, consume, granule);
+
+		return m_queue->read_with<std::int16_t>(count, [&](const std::int16_t* region, std::size_t first, std::size_t size)
+		{
+			std::array<float, precision_tile_sample> tile;
+			const std::size_t tile_size = precision_tile_sample / granule * granule;
+			for (std::size_t offset = 0; offset < size; offset += tile_size)
+			{
+				const std::size_t chunk = std::min(tile_size, size - offset);
+				convert_to_float(std::span<const std::int16_t>{region + offset, chunk}, std::span{tile}.first(chunk));
+				consume(std::as_const(tile).data(), first + offset, chunk);
+			}
+		}, granule);
+	}
+
+	/**
+     * @brief read_planes_with() on the ring in float whatever its precision, see ring_read().
+     * 
+     */
+	template <typename Consume>
+	std::size_t ring_read_planes(std::size_t count, Consume&& consume)
+	{
+		if (m_precision == queue_precision::float32)
+			return m_queue->read_planes_with(count, consume);
+
+		return m_queue->read_planes_with<std::int16_t>(count, [&](const std::int16_t* const* planes, std::size_t first, std::size_t size)
+		{
+			const std::size_t								 plane_count = m_queue->planes();
+			const std::size_t								 tile_frame	 = precision_tile_sample / plane_count;
+			std::array<float, precision_tile_sample>		 tile;
+			std::array<const float*, audio_ring::max_planes> rows{};
+			for (std::size_t plane = 0; plane < plane_count; ++plane)
+				rows[plane] = &tile[plane * tile_frame];
+
+			for (std::size_t offset = 0; offset < size; offset += tile_frame)
+			{
+				const std::size_t chunk = std::min(tile_frame, size - offset);
+				for (std::size_t plane = 0; plane < plane_count; ++plane)
+					convert_to_float(std::span<const std::int16_t>{planes[plane] + offset, chunk}, std::span{&tile[plane * tile_frame], chunk});
+				consume(rows.data(), first + offset, chunk);
+			}
+		});
+	}
+
+	/**
+     * @brief Move every ready sample of a ring into another one, of the same layout and precision, with room for them.
+     * 
+     */
+	template <typename Sample>
+	static void move_samples(audio_ring& from, audio_ring& to)
+	{
+		from.read_planes_with<Sample>(from.size(), [&](const Sample* const* source, std::size_t, std::size_t size)
+		{
+			to.write_planes_with<Sample>(size, [&](Sample* const* target, std::size_t first, std::size_t count)
+			{
+				for (std::size_t plane = 0; plane < to.planes(); ++plane)
+					std::memcpy(target[plane], source[plane] + first, count * sizeof(Sample));
+			});
+		});
+	}
+
+	/**
+     * @brief Longest wait of a push, with overflow_policy::block.
+     * 
+     */
+	[[nodiscard]]
+	std::chrono::nanoseconds overflow_timeout() const { return std::chrono::nanoseconds(m_overflow_timeout_ns.load(std::memory_order_relaxed)); }
+
+	/**
+     * @brief Drop the oldest frames of the ring (overwrite_oldest).
+     * 
+     * @return std::size_t Frames dropped
+     */
+	std::size_t discard_frames(std::size_t frames)
+	{
+		return m_queue->discard(frames * slots_per_frame(), slots_per_frame()) / slots_per_frame();
+	}
+
+	/**
+     * @brief Count frames written to the ring, report (deferred) those it had no room for.
+     * 
+     * @return false Frames were dropped
+     */
+	bool account_write(std::size_t wanted, std::size_t written)
+	{
+		const std::size_t channels = m_expected_context.m_channel_num;
+		m_counters.pushed(written, (wanted - written) * channels);
+		m_counters.filled(m_queue->size() / slots_per_frame());
+		if (written != 0)
+			notify_ready();
+
+		if (wanted != written)
+		{
+			log_deferred("push_audio : samples dropped (queue full?)", static_cast<std::int64_t>((wanted - written) * channels));
+			return false;
+		}
+		return true;
+	}
+
+	/**
+     * @brief Count samples popped from the ring, and the underrun if it ran short.
+     * 
+     * @return std::size_t The popped sample count
+     */
+	std::size_t account_read(std::size_t popped, std::size_t wanted, bool count_underrun)
+	{
+		const std::size_t channels = m_expected_context.m_channel_num;
+		m_counters.popped(popped / channels, wanted / channels, count_underrun);
+		if (popped != 0)
+			notify_free();
+		return popped;
+	}
+
+	/**
+     * @brief Wake the consumers waiting for the frames now ready, if any waits (after frames are written, ring in use).
+     * 
+     */
+	void notify_ready()
+	{
+		m_ready_wait.notify([&] { return m_queue->size() / slots_per_frame(); });
+	}
+
+	/**
+     * @brief Wake the producers waiting for the room now free, if any waits (after frames are read, ring in use).
+     * 
+     */
+	void notify_free()
+	{
+		m_free_wait.notify([&] { return m_queue->free() / slots_per_frame(); });
+	}
+
+	/**
+     * @brief Specialized push pipeline of a (input layout, expected layout, resampling) combination.
+     * 
+     */
+	static push_function push_stages_for(channel_layout input, channel_layout output, bool resample)
+	{
+		static constexpr auto table = []<std::size_t... Index>(std::index_sequence<Index...>)
+		{
+			constexpr auto layout = [](std::size_t pair, bool origin)
+			{ return detail::all_layouts[origin ? (pair / channel_layout::count) : (pair % channel_layout::count)]; };
+
+			return std::array<push_function, sizeof...(Index)>{
+				&audio_queue::push_stages<layout(Index / 2, true), layout(Index / 2, false), (Index % 2) == 1>...};
+		}(std::make_index_sequence<channel_layout::count * channel_layout::count * 2>{});
+
+		return table[(detail::pair_index(input, output) * 2) + (resample ? 1 : 0)];
+	}
+
+	/**
+     * @brief Push state of an input context, created on its first use.
+     * 
+     * @param input_context Input audio context
+     * @return push_session* The state, nullptr if its resampler can not be created.
+     */
+	push_session* session_for(const audio_ctx& input_context)
+	{
+		auto& session = m_sessions[input_context.index()];
+		if (session)
+			return &*session;
+
+		const size_t input_channels = input_context.m_channel_num;
+
+		push_session created;
+
+		// With drift compensation every input is resampled, at a variable ratio.
+		const bool drift	 = m_drift.m_target_latency.count() > 0;
+		auto	   ratio_opt = m_expected_context.need_resample(input_context);
+		if (drift && !ratio_opt)
+			ratio_opt = 1.0;
+
+		if (ratio_opt)
+		{
+			try
+			{
+				created.m_resampler.emplace(static_cast<uint8_t>(input_channels), *ratio_opt, m_quality, drift);
+			}
+			catch (const std::runtime_error&)
+			{
+				log_deferred("push_audio : can not create the resampler");
+				return nullptr;
+			}
+			created.m_input.resize(block_frame * input_channels);
+			created.m_resampled.resize(created.m_resampler->max_output_frames(block_frame) * input_channels);
+			created.m_nominal_ratio = *ratio_opt;
+			if (drift)
+				created.m_drift.emplace(m_drift);
+		}
+
+		if (auto remix_opt = m_expected_context.need_conversion(input_context))
+			created.m_remix = *remix_opt;
+
+		created.m_push = push_stages_for(input_context.m_channel_num, m_expected_context.m_channel_num, created.m_resampler.has_value());
+
+		session.emplace(std::move(created));
+		return &*session;
+	}
+
+	/**
+     * @brief Ring slots of one frame : its samples (interleaved storage) or one per plane (planar storage).
+     * 
+     */
+	[[nodiscard]]
+	std::size_t slots_per_frame() const
+	{
+		return m_storage == queue_storage::planar ? 1 : static_cast<std::size_t>(m_expected_context.m_channel_num);
+	}
+
+	/**
+     * @brief Ring holding a latency at the expected context, see ring_shape().
+     * 
+     */
+	[[nodiscard]]
+	std::unique_ptr<audio_ring> make_ring(std::size_t latency_ms) const
+	{
+		const auto shape = ring_shape(m_expected_context, latency_ms, m_storage, m_precision);
+		return std::make_unique<audio_ring>(shape.m_capacity, shape.m_planes, shape.m_sample_bytes);
+	}
+
+	static constexpr auto	default_latency_ms = 200;
+	static constexpr size_t all_channels	   = static_cast<size_t>(-1); // Channel argument of mix_popped() for interleaved frames
+	static constexpr size_t block_frame		   = 1024; // Frames converted per push step
+	static constexpr size_t pop_block_sample   = 1024; // Samples mixed per pop step
+	static constexpr size_t fused_block_sample = 2048; // Samples converted and mapped per fused push step
+	static constexpr size_t overwrite_attempts = 4;	   // Stalled attempts before overwrite_oldest gives up
+	static constexpr size_t precision_tile_sample = 1024; // Samples narrowed / widened per step of the int16 storage
+
+	audio_ctx					m_expected_context;
+	resample_quality			m_quality	= resample_quality::best;
+	queue_storage				m_storage	= queue_storage::interleaved;
+	queue_precision				m_precision = queue_precision::float32;
+	mix_control					m_control;
+	std::unique_ptr<audio_ring> m_queue;
+	bool						m_fixed_ring = false; // Sized elsewhere : set_latency() keeps it
+	queue_counters				m_counters;
+
+	/**
+     * @brief Ring accesses running on one side, alone on its cache line.
+     * 
+     */
+	struct alignas(audio_ring::cache_line) ring_users
+	{
+		std::atomic<std::size_t> m_count{0};
+	};
+
+	// Ring swaps (set_latency()) wait for the running pushes and pops, new ones fail meanwhile
+	mutable std::array<ring_users, 2> m_ring_users; // By ring_side
+	alignas(audio_ring::cache_line) std::atomic<bool> m_resizing{false};
+	std::mutex										  m_resize_mutex;
+
+	drift_compensation m_drift; // Applied to the sessions created afterwards
+
+	// Consumers waiting for frames, producers waiting for room
+	wait_point m_ready_wait;
+	wait_point m_free_wait;
 
-	static constexpr auto  default_latency_ms = 200;
+	std::atomic<overflow_policy>			   m_overflow{overflow_policy::drop_newest};
+	std::atomic<std::chrono::nanoseconds::rep> m_overflow_timeout_ns{0};
 
-	audio_ctx			   m_expected_context;
-	lockfree::queue<float> m_queue;
-};
\ No newline at end of file
+	// One push state per input context (one producer per input context at a time)
+	std::array<std::optional<push_session>, audio_ctx::count> m_sessions;
+};
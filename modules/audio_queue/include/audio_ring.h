@@ -0,0 +1,496 @@
+/**
+ * @file audio_ring.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-10-22
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <thread>
+
+/**
+ * @brief Lock-free MPMC ring of float samples with bulk transfers.
+ *
+ * Producers and consumers move whole blocks : a block is reserved with one CAS,
+ * copied with at most two memcpy (ring wrap-around), then published with one atomic store.
+ * write_with() / read_with() hand the reserved regions to the caller instead, to produce or
+ * consume samples in place without an intermediate buffer.
+ * Publications happen in reservation order, so a block is visible only once every block
+ * reserved before it is complete.
+ *
+ * A ring can hold several planes (one per channel) sharing the same counters : a block is then the
+ * same range of every plane, and write_planes_with() / read_planes_with() hand one region per plane.
+ *
+ * Samples are float by default. A ring built with a smaller sample size (int16_t, to halve its memory)
+ * is accessed with the matching sample type : write_with<int16_t>()...
+ * Power of two capacities wrap with a mask instead of a division.
+ *
+ * A ring can also live in memory it does not own (a shared memory segment mapped by several processes) :
+ * its counters and samples are then placed in that memory, and every process maps the same ring.
+ *
+ */
+class audio_ring
+{
+public:
+
+	static constexpr std::size_t max_planes = 8;
+	static constexpr std::size_t cache_line = 64;
+
+	/**
+     * @brief Monotonic sample counters, each on its own cache line. Address free : usable across processes.
+     *
+     */
+	struct shared_state
+	{
+		alignas(cache_line) std::atomic<std::size_t> m_write_reserve{0}; // Claimed by producers
+		alignas(cache_line) std::atomic<std::size_t> m_write_commit{0};	 // Published to consumers
+		alignas(cache_line) std::atomic<std::size_t> m_read_reserve{0};	 // Claimed by consumers
+		alignas(cache_line) std::atomic<std::size_t> m_read_commit{0};	 // Released to producers
+	};
+	static_assert(std::atomic<std::size_t>::is_always_lock_free, "audio_ring counters must be lock-free to be shared between processes");
+
+	/**
+     * @brief Construct a ring.
+     *
+     * @param capacity Ring capacity, in samples per plane
+     * @param planes Number of planes, at most max_planes
+     * @param sample_bytes Size of one stored sample : sizeof(float), or the size of a narrower storage type
+     */
+	explicit audio_ring(std::size_t capacity, std::size_t planes = 1, std::size_t sample_bytes = sizeof(float))
+		: m_capacity(std::max<std::size_t>(capacity, 1)),
+		  m_mask(std::has_single_bit(m_capacity) ? m_capacity - 1 : 0),
+		  m_planes(std::max<std::size_t>(planes, 1)),
+		  m_sample_bytes(sample_bytes),
+		  m_owned_state(std::make_unique<shared_state>()),
+		  m_owned_buffer(std::make_unique<std::byte[]>(m_capacity * m_planes * m_sample_bytes)),
+		  m_state(m_owned_state.get()),
+		  m_buffer(m_owned_buffer.get())
+	{
+		if (m_planes > max_planes)
+			throw std::invalid_argument("audio_ring : too many planes");
+	}
+
+	/**
+     * @brief Construct a ring in external memory : counters first, then the samples.
+     *
+     * @param memory At least memory_bytes(), aligned on a cache line, outliving the ring
+     * @param capacity Ring capacity, in samples per plane
+     * @param planes Number of planes, at most max_planes
+     * @param sample_bytes Size of one stored sample
+     * @param initialize Create an empty ring, or attach to the ring already in memory (same parameters)
+     */
+	audio_ring(std::span<std::byte> memory, std::size_t capacity, std::size_t planes, std::size_t sample_bytes, bool initialize)
+		: m_capacity(std::max<std::size_t>(capacity, 1)),
+		  m_mask(std::has_single_bit(m_capacity) ? m_capacity - 1 : 0),
+		  m_planes(std::max<std::size_t>(planes, 1)),
+		  m_sample_bytes(sample_bytes)
+	{
+		if (m_planes > max_planes)
+			throw std::invalid_argument("audio_ring : too many planes");
+		if (memory.size() < memory_bytes(m_capacity, m_planes, m_sample_bytes) || reinterpret_cast<std::uintptr_t>(memory.data()) % cache_line != 0)
+			throw std::invalid_argument("audio_ring : external memory too small or misaligned");
+
+		m_state	 = initialize ? new (memory.data()) shared_state{} : std::launder(reinterpret_cast<shared_state*>(memory.data()));
+		m_buffer = memory.data() + sizeof(shared_state);
+	}
+
+	/**
+     * @brief Bytes of external memory holding a ring : counters and samples.
+     *
+     */
+	static constexpr std::size_t memory_bytes(std::size_t capacity, std::size_t planes, std::size_t sample_bytes)
+	{
+		return sizeof(shared_state) + (std::max<std::size_t>(capacity, 1) * std::max<std::size_t>(planes, 1) * sample_bytes);
+	}
+
+	/* A ring is shared by reference between producers and consumers */
+	audio_ring(const audio_ring&)			 = delete;
+	audio_ring(audio_ring&&)				 = delete;
+	audio_ring& operator=(const audio_ring&) = delete;
+	audio_ring& operator=(audio_ring&&)		 = delete;
+
+	~audio_ring() = default;
+
+	/**
+     * @brief Write a block of samples.
+     *
+     * @param data Samples to write
+     * @param count Sample count
+     * @return std::size_t Samples written, less than count if the ring is full
+     */
+	std::size_t write(const float* data, std::size_t count)
+	{
+		return write_with(count, [data](float* region, std::size_t first, std::size_t size)
+						  { std::memcpy(region, data + first, size * sizeof(float)); });
+	}
+
+	/**
+     * @brief Reserve up to count samples and let fill() produce them in place, then publish them.
+     *
+     * fill(float* region, std::size_t first, std::size_t size) is called once per contiguous region
+     * of the reservation (twice when it wraps around), first being the offset of the region in the block.
+     * With a granule (frame size) dividing the capacity and every write, regions are made of whole frames.
+     * write() / read() and the single region calls only see the first plane of a planar ring.
+     *
+     * @tparam Sample Stored sample type, of the ring sample size
+     * @param count Sample count wanted
+     * @param fill Producer of the samples
+     * @param granule A partial reservation is rounded down to a multiple of it
+     * @return std::size_t Samples reserved and published, less than count if the ring is full
+     */
+	template <typename Sample = float, typename Fill>
+	std::size_t write_with(std::size_t count, Fill&& fill, std::size_t granule = 1)
+	{
+		return reserve_write(count, granule, [&](std::size_t offset, std::size_t first, std::size_t size) { fill(samples<Sample>() + offset, first, size); });
+	}
+
+	/**
+     * @brief write_with() for every plane at once.
+     *
+     * fill(float* const* planes, std::size_t first, std::size_t size) is called once per contiguous region,
+     * planes[p] being the region in plane p. Counts are in samples per plane.
+     *
+     */
+	template <typename Sample = float, typename Fill>
+	std::size_t write_planes_with(std::size_t count, Fill&& fill, std::size_t granule = 1)
+	{
+		return reserve_write(count, granule, [&](std::size_t offset, std::size_t first, std::size_t size)
+		{
+			std::array<Sample*, max_planes> planes{};
+			for (std::size_t plane = 0; plane < m_planes; ++plane)
+				planes[plane] = samples<Sample>() + (plane * m_capacity) + offset;
+			fill(planes.data(), first, size);
+		});
+	}
+
+	/**
+     * @brief Read a block of samples.
+     *
+     * @param data Destination buffer
+     * @param count Sample count wanted
+     * @param granule A partial read is rounded down to a multiple of it
+     * @return std::size_t Samples read, less than count if the ring runs short
+     */
+	std::size_t read(float* data, std::size_t count, std::size_t granule = 1)
+	{
+		return read_with(count, [data](const float* region, std::size_t first, std::size_t size)
+						 { std::memcpy(data + first, region, size * sizeof(float)); }, granule);
+	}
+
+	/**
+     * @brief Reserve up to count samples and let consume() use them in place, then release them.
+     *
+     * consume(const float* region, std::size_t first, std::size_t size) is called once per contiguous
+     * region of the reservation, like write_with().
+     *
+     * @param count Sample count wanted
+     * @param consume Consumer of the samples
+     * @param granule A partial reservation is rounded down to a multiple of it
+     * @return std::size_t Samples consumed, less than count if the ring runs short
+     */
+	template <typename Sample = float, typename Consume>
+	std::size_t read_with(std::size_t count, Consume&& consume, std::size_t granule = 1)
+	{
+		return reserve_read(count, granule, [&](std::size_t offset, std::size_t first, std::size_t size) { consume(samples<Sample>() + offset, first, size); });
+	}
+
+	/**
+     * @brief read_with() for every plane at once, see write_planes_with().
+     *
+     */
+	template <typename Sample = float, typename Consume>
+	std::size_t read_planes_with(std::size_t count, Consume&& consume)
+	{
+		return reserve_read(count, 1, [&](std::size_t offset, std::size_t first, std::size_t size)
+		{
+			std::array<const Sample*, max_planes> planes{};
+			for (std::size_t plane = 0; plane < m_planes; ++plane)
+				planes[plane] = samples<Sample>() + (plane * m_capacity) + offset;
+			consume(planes.data(), first, size);
+		});
+	}
+
+	/**
+     * @brief Block of samples claimed by begin_write() or begin_read() : position (monotonic counter) and size per plane.
+     *
+     */
+	struct claim
+	{
+		std::size_t m_start = 0;
+		std::size_t m_size	= 0;
+	};
+
+	/**
+     * @brief Claim up to count samples of free room, to fill in place (plane_at()) before end_write() : write_with() in two steps.
+     *
+     * Blocks claimed after this one by other producers are published after it : keep the claim short.
+     *
+     * @param count Sample count wanted (per plane)
+     * @param granule A partial claim is rounded down to a multiple of it
+     * @return claim The block, of size 0 if the ring is full
+     */
+	claim begin_write(std::size_t count, std::size_t granule = 1)
+	{
+		std::size_t start	 = m_state->m_write_reserve.load(std::memory_order_relaxed);
+		std::size_t reserved = 0;
+		do
+		{
+			const std::size_t released = m_state->m_read_commit.load(std::memory_order_acquire);
+			if (start - released > m_capacity) // Stale start, the CAS below fails and reloads it
+				continue;
+
+			reserved = std::min(count, m_capacity - (start - released));
+			reserved -= reserved % granule;
+			if (reserved == 0)
+				return {};
+		} while (!m_state->m_write_reserve.compare_exchange_weak(start, start + reserved, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+		return {.m_start = start, .m_size = reserved};
+	}
+
+	/**
+     * @brief Publish the first used samples of a write claim.
+     *
+     * Waits for the blocks claimed before it to be published. The rest of the claim is then given back if no block was
+     * claimed after it, else it is published as silence (zeros).
+     *
+     * @return std::size_t Samples published
+     */
+	std::size_t end_write(const claim& block, std::size_t used)
+	{
+		return end_claim(m_state->m_write_reserve, m_state->m_write_commit, block, used, true);
+	}
+
+	/**
+     * @brief Claim up to count ready samples, to use in place (plane_at()) before end_read() : read_with() in two steps.
+     *
+     * @param count Sample count wanted (per plane)
+     * @param granule A partial claim is rounded down to a multiple of it
+     * @return claim The block, of size 0 if the ring is empty
+     */
+	claim begin_read(std::size_t count, std::size_t granule = 1)
+	{
+		std::size_t start	 = m_state->m_read_reserve.load(std::memory_order_relaxed);
+		std::size_t reserved = 0;
+		do
+		{
+			const std::size_t published = m_state->m_write_commit.load(std::memory_order_acquire);
+			reserved					= std::min(count, published - start);
+			reserved -= reserved % granule;
+			if (reserved == 0)
+				return {};
+		} while (!m_state->m_read_reserve.compare_exchange_weak(start, start + reserved, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+		return {.m_start = start, .m_size = reserved};
+	}
+
+	/**
+     * @brief Release the first used samples of a read claim to producers.
+     *
+     * Waits for the blocks claimed before it to be released. The rest of the claim then stays ready if no block was
+     * claimed after it, else it is dropped.
+     *
+     * @return std::size_t Samples released
+     */
+	std::size_t end_read(const claim& block, std::size_t used)
+	{
+		return end_claim(m_state->m_read_reserve, m_state->m_read_commit, block, used, false);
+	}
+
+	/**
+     * @brief Stored sample of a plane at a counter position, and the samples contiguous to it (contiguous()).
+     *
+     */
+	template <typename Sample>
+	[[nodiscard]] Sample* plane_at(std::size_t plane, std::size_t position) const { return samples<Sample>() + (plane * m_capacity) + wrap(position); }
+
+	/**
+     * @brief Samples from a counter position to the end of the buffer : a claim wraps after them.
+     *
+     */
+	[[nodiscard]] std::size_t contiguous(std::size_t position) const { return m_capacity - wrap(position); }
+
+	/**
+     * @brief Drop samples without reading them.
+     *
+     * @param count Sample count (per plane)
+     * @param granule A partial drop is rounded down to a multiple of it
+     * @return std::size_t Samples dropped, less than count if the ring runs short
+     */
+	std::size_t discard(std::size_t count, std::size_t granule = 1)
+	{
+		return reserve_read(count, granule, [](std::size_t, std::size_t, std::size_t) {});
+	}
+
+	/**
+     * @brief Samples ready to be read (a snapshot, may change concurrently).
+     *
+     */
+	[[nodiscard]]
+	std::size_t size() const
+	{
+		const std::size_t published = m_state->m_write_commit.load(std::memory_order_acquire);
+		const std::size_t reserved	= m_state->m_read_reserve.load(std::memory_order_acquire);
+		return published > reserved ? published - reserved : 0;
+	}
+
+	/**
+     * @brief Samples that can be written (a snapshot, may change concurrently).
+     *
+     */
+	[[nodiscard]]
+	std::size_t free() const
+	{
+		const std::size_t released = m_state->m_read_commit.load(std::memory_order_acquire);
+		const std::size_t reserved = m_state->m_write_reserve.load(std::memory_order_acquire);
+		return m_capacity - std::min(m_capacity, reserved - released);
+	}
+
+	[[nodiscard]] std::size_t capacity() const { return m_capacity; }
+	[[nodiscard]] std::size_t planes() const { return m_planes; }
+	[[nodiscard]] std::size_t sample_bytes() const { return m_sample_bytes; }
+
+	/**
+     * @brief Memory held by the samples, in bytes.
+     *
+     */
+	[[nodiscard]] std::size_t footprint() const { return m_capacity * m_planes * m_sample_bytes; }
+
+private:
+
+	/**
+     * @brief Reserve up to count samples for writing, visit(offset, first, size) each region, then publish.
+     *
+     */
+	template <typename Visit>
+	std::size_t reserve_write(std::size_t count, std::size_t granule, Visit&& visit)
+	{
+		const claim block = begin_write(count, granule);
+		if (block.m_size == 0)
+			return 0;
+
+		visit_claim(block, visit);
+		publish(m_state->m_write_commit, block.m_start, block.m_start + block.m_size);
+		return block.m_size;
+	}
+
+	/**
+     * @brief Reserve up to count samples for reading, visit(offset, first, size) each region, then release.
+     *
+     */
+	template <typename Visit>
+	std::size_t reserve_read(std::size_t count, std::size_t granule, Visit&& visit)
+	{
+		const claim block = begin_read(count, granule);
+		if (block.m_size == 0)
+			return 0;
+
+		visit_claim(block, visit);
+		publish(m_state->m_read_commit, block.m_start, block.m_start + block.m_size);
+		return block.m_size;
+	}
+
+	/**
+     * @brief visit(offset, first, size) each region of a claim : at most two, up to the end of the buffer, then from its beginning.
+     *
+     */
+	template <typename Visit>
+	void visit_claim(const claim& block, Visit&& visit) const
+	{
+		const std::size_t offset = wrap(block.m_start);
+		const std::size_t first	 = std::min(block.m_size, m_capacity - offset);
+		visit(offset, 0, first);
+		if (block.m_size != first)
+			visit(0, first, block.m_size - first);
+	}
+
+	/**
+     * @brief Publish (or release) the used part of a claim, in claim order. Once every earlier claim is published, the
+     * reservation counter gives the rest back if nothing was claimed after it, else the whole claim is published, its
+     * rest silenced (writes) or dropped (reads).
+     *
+     * The counter only moves back over the newest claim while it is the only one pending : never below a range another
+     * claim still has to publish.
+     *
+     */
+	std::size_t end_claim(std::atomic<std::size_t>& reserve, std::atomic<std::size_t>& commit, const claim& block, std::size_t used, bool silence_rest)
+	{
+		used = std::min(used, block.m_size);
+		wait_turn(commit, block.m_start);
+
+		std::size_t		  expected = block.m_start + block.m_size;
+		const std::size_t end	   = used == block.m_size || reserve.compare_exchange_strong(expected, block.m_start + used, std::memory_order_acq_rel)
+										 ? block.m_start + used
+										 : block.m_start + block.m_size;
+
+		if (silence_rest && end != block.m_start + used)
+			visit_claim({.m_start = block.m_start + used, .m_size = block.m_size - used}, [&](std::size_t offset, std::size_t, std::size_t size)
+			{
+				for (std::size_t plane = 0; plane < m_planes; ++plane)
+					std::memset(m_buffer + (((plane * m_capacity) + offset) * m_sample_bytes), 0, size * m_sample_bytes);
+			});
+
+		commit.store(end, std::memory_order_release);
+		return end - block.m_start;
+	}
+
+	/**
+     * @brief Position of a monotonic counter in the buffer.
+     *
+     */
+	[[nodiscard]] std::size_t wrap(std::size_t counter) const { return m_mask != 0 ? counter & m_mask : counter % m_capacity; }
+
+	/**
+     * @brief Buffer seen as stored samples of the given type.
+     *
+     */
+	template <typename Sample>
+	[[nodiscard]] Sample* samples() const { return reinterpret_cast<Sample*>(m_buffer); }
+
+	/**
+     * @brief Wait until every block reserved before ours is published, then publish ours.
+     *
+     */
+	static void publish(std::atomic<std::size_t>& commit, std::size_t start, std::size_t end)
+	{
+		wait_turn(commit, start);
+		commit.store(end, std::memory_order_release);
+	}
+
+	/**
+     * @brief Wait until every block reserved before a position is published.
+     *
+     */
+	static void wait_turn(const std::atomic<std::size_t>& commit, std::size_t start)
+	{
+		for (std::size_t spins = 0; commit.load(std::memory_order_acquire) != start; ++spins)
+			if (spins >= spin_before_yield)
+				std::this_thread::yield();
+	}
+
+	static constexpr std::size_t spin_before_yield = 64;
+
+	const std::size_t			  m_capacity; // Per plane
+	const std::size_t			  m_mask;	  // Capacity - 1 for power of two capacities, else 0
+	const std::size_t			  m_planes;
+	const std::size_t			  m_sample_bytes;
+	std::unique_ptr<shared_state> m_owned_state;  // Null in external memory
+	std::unique_ptr<std::byte[]>  m_owned_buffer; // Null in external memory
+	shared_state*				  m_state  = nullptr;
+	std::byte*					  m_buffer = nullptr; // Planes one after the other
+};
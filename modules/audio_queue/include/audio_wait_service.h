@@ -0,0 +1,149 @@
+/**
+ * @file audio_wait_service.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-11-28
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "audio_queue.h"
+#include "wait_point.h"
+
+/**
+ * @brief One thread resuming the coroutines waiting on many queues : co_await service.frames(queue, n, timeout).
+ *
+ * A suspended coroutine registers its level on the queue's wait point, with this service as listener :
+ * the push (or pop) reaching the level bumps and wakes one word, the service's, whatever the queue. run_once()
+ * then checks the pending waits, resumes those satisfied or timed out, and sleeps again until the next signal or
+ * deadline. Coroutines run on the thread calling run_once(), never on the real-time thread that pushed or popped.
+ *
+ * A queue is awaited through one service at a time (its wait points have one listener). The service detaches from
+ * a wait point when its last wait there resumes, and from all of them when destroyed. Every pending wait must be
+ * resumed before the service is destroyed.
+ *
+ */
+class audio_wait_service
+{
+public:
+
+	/**
+     * @brief Awaitable of a queue level : co_await yields true if the level was reached, false on timeout.
+     *
+     */
+	class awaiter
+	{
+	public:
+
+		bool await_ready()
+		{
+			m_satisfied = m_ready(m_queue, m_level);
+			return m_satisfied;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			m_handle = handle;
+			m_service->suspend(*this);
+		}
+
+		bool await_resume() const { return m_satisfied; }
+
+	private:
+
+		friend class audio_wait_service;
+
+		using ready_function = bool (*)(const void* queue, std::size_t level);
+
+		awaiter(audio_wait_service& service, const void* queue, ready_function ready, wait_point& point, std::size_t level, std::chrono::nanoseconds timeout)
+			: m_service(&service),
+			  m_queue(queue),
+			  m_ready(ready),
+			  m_point(&point),
+			  m_level(level),
+			  m_deadline(std::chrono::steady_clock::now() + timeout)
+		{}
+
+		audio_wait_service*					  m_service;
+		const void*							  m_queue; // audio_queue<AudioType>, checked by m_ready
+		ready_function						  m_ready;
+		wait_point*							  m_point;
+		std::size_t							  m_level;
+		std::chrono::steady_clock::time_point m_deadline;
+		std::coroutine_handle<>				  m_handle;
+		bool								  m_satisfied = false;
+	};
+
+	audio_wait_service() = default;
+
+	/* Pending waits point to the service */
+	audio_wait_service(const audio_wait_service&)			 = delete;
+	audio_wait_service& operator=(const audio_wait_service&) = delete;
+
+	~audio_wait_service();
+
+	/**
+     * @brief Wait for a number of frames ready to pop (at most the capacity).
+     *
+     */
+	template <audio_sample_type AudioType>
+	[[nodiscard]]
+	awaiter frames(audio_queue<AudioType>& queue, std::size_t frames, std::chrono::nanoseconds timeout)
+	{
+		return {*this, &queue, [](const void* target, std::size_t level) { return static_cast<const audio_queue<AudioType>*>(target)->ready_frames() >= level; },
+				queue.ready_wait(), std::min(frames, queue.capacity_frames()), timeout};
+	}
+
+	/**
+     * @brief Wait for room to push a number of frames (at most the capacity).
+     *
+     */
+	template <audio_sample_type AudioType>
+	[[nodiscard]]
+	awaiter space(audio_queue<AudioType>& queue, std::size_t frames, std::chrono::nanoseconds timeout)
+	{
+		return {*this, &queue, [](const void* target, std::size_t level) { return static_cast<const audio_queue<AudioType>*>(target)->free_frames() >= level; },
+				queue.free_wait(), std::min(frames, queue.capacity_frames()), timeout};
+	}
+
+	/**
+     * @brief Resume the waits satisfied or timed out, or sleep until one may be (a signal, a deadline) up to max_wait.
+     *
+     * @return std::size_t Coroutines resumed
+     */
+	std::size_t run_once(std::chrono::nanoseconds max_wait);
+
+	/**
+     * @brief Make a run_once() sleeping now return (e.g. to stop the serving thread).
+     *
+     */
+	void wake();
+
+	/**
+     * @brief Waits not resumed yet.
+     *
+     */
+	[[nodiscard]]
+	std::size_t pending() const;
+
+private:
+
+	void suspend(awaiter& wait);
+
+	std::atomic<std::uint32_t> m_signal{0}; // Bumped by the wait points of the awaited queues
+	mutable std::mutex		   m_lock;		// Guards m_pending (never taken by pushes nor pops)
+	std::vector<awaiter*>	   m_pending;	// In the frames of the suspended coroutines
+	std::vector<wait_point*>   m_points;	// Wait points signalling m_signal : those of the pending waits
+	std::vector<awaiter*>	   m_resumable; // Scratch of run_once()
+};
@@ -10,6 +10,7 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string_view>
 #include <vector>
@@ -66,7 +67,28 @@ struct channel_layout
 	constexpr operator value() const { return m_value; }
 
 	/**
-     * @brief Matrix for channel conversion
+     * @brief Dense index of the channel layout, for lookup tables.
+     * 
+     * @return std::size_t index in [0, count)
+     */
+	[[nodiscard]]
+	constexpr std::size_t index() const
+	{
+		switch (m_value)
+		{
+			case Mono:			return 0;
+			case Stereo:		return 1;
+			case FivePointOne:	return 2;
+			case SevenPointOne: return 3;
+		}
+		return 0;
+	}
+
+	// Number of supported channel layouts
+	static constexpr std::size_t count = 4;
+
+	/**
+     * @brief Matrix for channel conversion (copy of the precomputed one, see channel_mix.h)
      * 
      * @param input The input channel layout.
      * @return std::vector<std::vector<float>> The matrix to use 
@@ -0,0 +1,305 @@
+/**
+ * @file channel_mix.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-10-26
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <utility>
+
+#include "channel.h"
+
+/**
+ * @brief Flat, row-major (output x input) channel mapping matrix.
+ *
+ */
+struct channel_matrix
+{
+	static constexpr std::size_t max_channels = channel_layout::SevenPointOne;
+
+	std::size_t									   m_input	= 0;
+	std::size_t									   m_output = 0;
+	std::array<float, max_channels * max_channels> m_coef{};
+
+	[[nodiscard]] constexpr float  at(std::size_t out, std::size_t in) const { return m_coef[(out * m_input) + in]; }
+	[[nodiscard]] constexpr float& at(std::size_t out, std::size_t in) { return m_coef[(out * m_input) + in]; }
+};
+
+/**
+ * @brief Build the mapping matrix from one layout to another, at compile time.
+ *
+ * @param origin Input channel layout
+ * @param target Output channel layout
+ * @return channel_matrix The matrix, identity on the common channels for pairs without a dedicated mix
+ */
+constexpr channel_matrix
+make_channel_matrix(channel_layout origin, channel_layout target)
+{
+	using Value = channel_layout::value;
+
+	constexpr float coef_full_gain	   = 1.0F;
+	constexpr float coef_half_gain	   = 0.5F;
+	constexpr float coef_surround_gain = 0.707F;
+	constexpr float coef_centre_gain   = 0.45F;
+	constexpr float coef_mono_mix_gain = 0.325F;
+	constexpr float coef_mono_low_gain = 0.1F;
+
+	channel_matrix matrix{.m_input = origin, .m_output = target};
+
+	if		(origin == Value::Mono && target == Value::Stereo)
+	{
+		matrix.at(0, 0) = coef_full_gain;
+		matrix.at(1, 0) = coef_full_gain;
+	}
+	else if (origin == Value::Stereo && target == Value::Mono)
+	{
+		matrix.at(0, 0) = coef_half_gain;
+		matrix.at(0, 1) = coef_half_gain;
+	}
+	else if (origin == Value::Stereo && target == Value::FivePointOne)
+	{
+		matrix.at(0, 0) = coef_full_gain;
+		matrix.at(1, 1) = coef_full_gain;
+		matrix.at(2, 0) = coef_half_gain; // Center
+		matrix.at(2, 1) = coef_half_gain;
+	}
+	else if (origin == Value::FivePointOne && target == Value::Stereo)
+	{
+		matrix.at(0, 0) = coef_full_gain;
+		matrix.at(1, 1) = coef_full_gain;
+		matrix.at(0, 2) = coef_surround_gain;
+		matrix.at(1, 2) = coef_surround_gain;
+		matrix.at(0, 4) = coef_surround_gain;
+		matrix.at(1, 5) = coef_surround_gain;
+	}
+	else if (origin == Value::FivePointOne && target == Value::Mono)
+	{
+		matrix.at(0, 0) = coef_mono_mix_gain;
+		matrix.at(0, 1) = coef_mono_mix_gain;
+		matrix.at(0, 2) = coef_centre_gain;
+		matrix.at(0, 3) = coef_mono_low_gain;
+		matrix.at(0, 4) = coef_mono_mix_gain;
+		matrix.at(0, 5) = coef_mono_mix_gain;
+	}
+	else if (origin == Value::SevenPointOne && target == Value::Stereo)
+	{
+		matrix.at(0, 0) = coef_full_gain;
+		matrix.at(1, 1) = coef_full_gain;
+		matrix.at(0, 2) = coef_surround_gain;
+		matrix.at(1, 2) = coef_surround_gain;
+		matrix.at(0, 4) = coef_half_gain;
+		matrix.at(1, 5) = coef_half_gain;
+		matrix.at(0, 6) = coef_half_gain;
+		matrix.at(1, 7) = coef_half_gain;
+	}
+	else if (origin == Value::SevenPointOne && target == Value::FivePointOne)
+	{
+		matrix.at(0, 0) = coef_full_gain;
+		matrix.at(1, 1) = coef_full_gain;
+		matrix.at(2, 2) = coef_full_gain;
+		matrix.at(3, 3) = coef_full_gain;
+		matrix.at(4, 4) = coef_half_gain;
+		matrix.at(4, 6) = coef_half_gain;
+		matrix.at(5, 5) = coef_half_gain;
+		matrix.at(5, 7) = coef_half_gain;
+	}
+	else
+		for (std::size_t i = 0; i < std::min<std::size_t>(origin, target); ++i)
+			matrix.at(i, i) = coef_full_gain;
+
+	return matrix;
+}
+
+namespace detail
+{
+	constexpr std::array<channel_layout::value, channel_layout::count> all_layouts{
+		channel_layout::Mono, channel_layout::Stereo, channel_layout::FivePointOne, channel_layout::SevenPointOne};
+
+	constexpr std::size_t pair_index(channel_layout origin, channel_layout target)
+	{
+		return (origin.index() * channel_layout::count) + target.index();
+	}
+
+	/**
+     * @brief Non-zero taps of one output row, as input channel indices.
+     *
+     */
+	template <channel_layout::value In, channel_layout::value Out, std::size_t Row>
+	constexpr auto row_taps()
+	{
+		constexpr auto matrix = make_channel_matrix(In, Out);
+		constexpr auto count  = [&]
+		{
+			std::size_t n = 0;
+			for (std::size_t in = 0; in < In; ++in)
+				n += matrix.at(Row, in) != 0.0F;
+			return n;
+		}();
+
+		std::array<std::size_t, count> taps{};
+		for (std::size_t in = 0, n = 0; in < In; ++in)
+			if (matrix.at(Row, in) != 0.0F)
+				taps[n++] = in;
+		return taps;
+	}
+
+	/**
+     * @brief Output sample of one row : sum of its non-zero taps only, in input channel order.
+     *
+     */
+	template <channel_layout::value In, channel_layout::value Out, std::size_t Row, std::size_t... Tap>
+	inline float mix_row(const float* in_frame, std::index_sequence<Tap...> /*taps*/)
+	{
+		constexpr auto matrix = make_channel_matrix(In, Out);
+		constexpr auto taps	  = row_taps<In, Out, Row>();
+
+		if constexpr (sizeof...(Tap) == 0)
+			return 0.0F;
+		else
+			return (... + (matrix.at(Row, taps[Tap]) * in_frame[taps[Tap]]));
+	}
+
+	/**
+     * @brief Mapping kernel specialized for one (input, output) layout pair.
+     *
+     * Channel counts and coefficients are compile-time constants : the frame body is fully unrolled,
+     * zero taps vanish and unity taps become plain copies.
+     *
+     */
+	template <channel_layout::value In, channel_layout::value Out>
+	void remix_kernel(const float* input, float* output, std::size_t frames)
+	{
+		[&]<std::size_t... Row>(std::index_sequence<Row...>)
+		{
+			for (std::size_t frame_idx = 0; frame_idx < frames; ++frame_idx)
+			{
+				const float* in_frame  = input + (frame_idx * In);
+				float*		 out_frame = output + (frame_idx * Out);
+
+				((out_frame[Row] = mix_row<In, Out, Row>(in_frame, std::make_index_sequence<row_taps<In, Out, Row>().size()>{})), ...);
+			}
+		}(std::make_index_sequence<Out>{});
+	}
+
+	/**
+     * @brief Output sample of one row from per channel input rows, same sum and order as mix_row().
+     *
+     */
+	template <channel_layout::value In, channel_layout::value Out, std::size_t Row, std::size_t... Tap>
+	inline float mix_plane_row(const std::array<const float*, In>& input, std::size_t sample, std::index_sequence<Tap...> /*taps*/)
+	{
+		constexpr auto matrix = make_channel_matrix(In, Out);
+		constexpr auto taps	  = row_taps<In, Out, Row>();
+
+		if constexpr (sizeof...(Tap) == 0)
+			return 0.0F;
+		else
+			return (... + (matrix.at(Row, taps[Tap]) * input[taps[Tap]][sample]));
+	}
+
+	/**
+     * @brief Mapping kernel of remix_kernel(), one output channel at a time.
+     *
+     * Channel c of frame i is read at input[c][i * input_stride] and written at output[c][i * output_stride] :
+     * planar buffers have a stride of 1, interleaved ones a stride of their channel count (and one pointer
+     * per channel into the frame). Planar to planar, every row is a contiguous multiply-add loop.
+     *
+     */
+	template <channel_layout::value In, channel_layout::value Out>
+	void remix_planes_kernel(const float* const* input, std::size_t input_stride, float* const* output, std::size_t output_stride, std::size_t frames)
+	{
+		std::array<const float*, In> rows;
+		std::copy_n(input, rows.size(), rows.begin());
+
+		const auto map_row = [&]<std::size_t Row>(std::integral_constant<std::size_t, Row>)
+		{
+			constexpr auto taps = std::make_index_sequence<row_taps<In, Out, Row>().size()>{};
+			float*		   out	= output[Row];
+			if (input_stride == 1 && output_stride == 1)
+				for (std::size_t frame_idx = 0; frame_idx < frames; ++frame_idx)
+					out[frame_idx] = mix_plane_row<In, Out, Row>(rows, frame_idx, taps);
+			else
+				for (std::size_t frame_idx = 0; frame_idx < frames; ++frame_idx)
+					out[frame_idx * output_stride] = mix_plane_row<In, Out, Row>(rows, frame_idx * input_stride, taps);
+		};
+
+		[&]<std::size_t... Row>(std::index_sequence<Row...>)
+		{
+			(map_row(std::integral_constant<std::size_t, Row>{}), ...);
+		}(std::make_index_sequence<Out>{});
+	}
+} // namespace detail
+
+/**
+ * @brief Channel mapping function : interleaved input frames to interleaved output frames.
+ *
+ */
+using remix_function = void (*)(const float* input, float* output, std::size_t frames);
+
+/**
+ * @brief Channel mapping function on strided channel rows (planar or interleaved, see detail::remix_planes_kernel).
+ *
+ */
+using remix_planes_function = void (*)(const float* const* input, std::size_t input_stride, float* const* output, std::size_t output_stride, std::size_t frames);
+
+// Every layout pair's matrix, computed at compile time, indexed by (origin, target).
+inline constexpr auto channel_matrices = []
+{
+	std::array<channel_matrix, channel_layout::count * channel_layout::count> matrices{};
+	for (auto origin : detail::all_layouts)
+		for (auto target : detail::all_layouts)
+			matrices[detail::pair_index(origin, target)] = make_channel_matrix(origin, target);
+	return matrices;
+}();
+
+// Every layout pair's specialized kernel, indexed by (origin, target).
+inline constexpr auto remix_kernels = []<std::size_t... Pair>(std::index_sequence<Pair...>)
+{
+	return std::array<remix_function, sizeof...(Pair)>{
+		&detail::remix_kernel<detail::all_layouts[Pair / channel_layout::count], detail::all_layouts[Pair % channel_layout::count]>...};
+}(std::make_index_sequence<channel_layout::count * channel_layout::count>{});
+
+// Every layout pair's specialized per channel kernel, indexed by (origin, target).
+inline constexpr auto remix_planes_kernels = []<std::size_t... Pair>(std::index_sequence<Pair...>)
+{
+	return std::array<remix_planes_function, sizeof...(Pair)>{
+		&detail::remix_planes_kernel<detail::all_layouts[Pair / channel_layout::count], detail::all_layouts[Pair % channel_layout::count]>...};
+}(std::make_index_sequence<channel_layout::count * channel_layout::count>{});
+
+/**
+ * @brief Precomputed matrix from one layout to another.
+ *
+ */
+[[nodiscard]] constexpr const channel_matrix&
+channel_matrix_for(channel_layout origin, channel_layout target)
+{
+	return channel_matrices[detail::pair_index(origin, target)];
+}
+
+/**
+ * @brief Specialized mapping kernel from one layout to another.
+ *
+ */
+[[nodiscard]] constexpr remix_function
+remix_for(channel_layout origin, channel_layout target)
+{
+	return remix_kernels[detail::pair_index(origin, target)];
+}
+
+/**
+ * @brief Specialized per channel mapping kernel from one layout to another.
+ *
+ */
+[[nodiscard]] constexpr remix_planes_function
+remix_planes_for(channel_layout origin, channel_layout target)
+{
+	return remix_planes_kernels[detail::pair_index(origin, target)];
+}
@@ -0,0 +1,137 @@
+/**
+ * @file deferred_log.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-11-08
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * @brief One deferred report : a static message, an optional static detail and an optional value.
+ *
+ * Nothing is formatted nor copied on the reporting side, records only hold pointers to
+ * string literals (or strings living as long as the program, like src_strerror()'s).
+ *
+ */
+struct log_record
+{
+	const char*	 m_message	 = "";		// Static string
+	const char*	 m_detail	 = nullptr; // Static string, or nullptr
+	std::int64_t m_value	 = 0;
+	bool		 m_has_value = false;
+};
+
+/**
+ * @brief Process-wide, bounded, lock-free queue of reports from the real-time paths.
+ *
+ * post() never blocks, never allocates and does no I/O : it is safe on an audio thread.
+ * A non real-time thread formats and prints the records with flush() (or consumes them with drain()).
+ * When the queue is full, records are dropped and counted.
+ *
+ */
+class deferred_log
+{
+public:
+
+	static constexpr std::size_t capacity = 1024;
+
+	/**
+     * @brief The process-wide log.
+     *
+     */
+	static deferred_log& instance();
+
+	/**
+     * @brief Queue a record, from any thread.
+     *
+     * @return true The record was queued
+     * @return false The queue is full, the record is dropped
+     */
+	bool post(const log_record& record);
+
+	/**
+     * @brief Hand every queued record to consume(const log_record&), from a single non real-time thread.
+     *
+     * @return std::size_t Records consumed
+     */
+	template <typename Consume>
+	std::size_t drain(Consume&& consume)
+	{
+		std::size_t consumed = 0;
+		while (true)
+		{
+			auto&			  slot	   = m_slots[m_read % capacity];
+			const std::size_t sequence = slot.m_sequence.load(std::memory_order_acquire);
+			if (sequence != m_read + 1)
+				return consumed;
+
+			consume(static_cast<const log_record&>(slot.m_record));
+			slot.m_sequence.store(m_read + capacity, std::memory_order_release);
+			++m_read;
+			++consumed;
+		}
+	}
+
+	/**
+     * @brief Print every queued record (and the count of records lost since the last flush), from a non real-time thread.
+     *
+     * @return std::size_t Records printed
+     */
+	std::size_t flush(std::FILE* stream = stderr);
+
+	/**
+     * @brief Records dropped because the queue was full, in total.
+     *
+     */
+	[[nodiscard]] std::uint64_t lost() const { return m_lost.load(std::memory_order_relaxed); }
+
+private:
+
+	deferred_log();
+
+	// Bounded MPSC slots : a slot is free to write at position p when its sequence is p, ready to read when p + 1.
+	struct slot
+	{
+		std::atomic<std::size_t> m_sequence{0};
+		log_record				 m_record;
+	};
+
+	static constexpr std::size_t cache_line = 64;
+
+	std::array<slot, capacity> m_slots;
+
+	alignas(cache_line) std::atomic<std::size_t> m_write{0}; // Next position claimed by producers
+	alignas(cache_line) std::size_t m_read = 0;				 // Next position read (consumer only)
+	std::atomic<std::uint64_t> m_lost{0};
+	std::uint64_t			   m_lost_reported = 0; // Consumer only
+};
+
+/**
+ * @brief Post a record to the process-wide log.
+ *
+ */
+inline bool
+log_deferred(const char* message, const char* detail = nullptr)
+{
+	return deferred_log::instance().post({.m_message = message, .m_detail = detail});
+}
+
+/**
+ * @brief Post a record with a value to the process-wide log.
+ *
+ */
+inline bool
+log_deferred(const char* message, std::int64_t value)
+{
+	return deferred_log::instance().post({.m_message = message, .m_value = value, .m_has_value = true});
+}
@@ -0,0 +1,71 @@
+/**
+ * @file drift_control.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-11-12
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <chrono>
+
+/**
+ * @brief Clock drift compensation settings of an audio_queue.
+ *
+ * Producer and consumer clocks of the same nominal rate drift apart by a few ppm : the queue
+ * slowly fills up (drops) or empties (underruns). With a target latency, every input is resampled
+ * with a ratio finely adjusted to hold the queue fill level at that target.
+ *
+ */
+struct drift_compensation
+{
+	std::chrono::milliseconds m_target_latency{0};		// Fill level to hold, 0 disables the compensation
+	double					  m_max_correction_ppm = 1000.0; // Largest deviation from the nominal ratio
+	std::chrono::milliseconds m_response{10000};		// Time constant of the loop : slower rejects fill jitter better
+};
+
+/**
+ * @brief Proportional-integral loop turning a queue fill level into a resampling ratio correction.
+ *
+ * The fill level is smoothed first (consumers pop by periods : the fill level seen by a producer
+ * is a sawtooth), the integral term cancels a constant drift with no residual latency error.
+ * Gains are critically damped for the response time : the loop settles without overshoot.
+ *
+ */
+class drift_controller
+{
+public:
+
+	explicit drift_controller(const drift_compensation& settings);
+
+	/**
+     * @brief Feed the fill level seen before a push block, get the ratio correction to apply to it.
+     *
+     * @param fill_seconds Queue fill level, in seconds at the expected rate
+     * @param elapsed_seconds Duration of the input block
+     * @return double Relative ratio correction : resample at nominal ratio x (1 + correction)
+     */
+	double update(double fill_seconds, double elapsed_seconds);
+
+	/**
+     * @brief Last correction returned by update().
+     *
+     */
+	[[nodiscard]] double correction() const { return m_correction; }
+
+private:
+
+	double m_target;		 // Fill level to hold, in seconds
+	double m_max_correction; // Relative
+	double m_proportional;	 // Correction per second of fill error
+	double m_integral_gain;	 // Correction per second of fill error, per second
+	double m_smoothing;		 // Time constant of the fill level filter, in seconds
+
+	double m_fill		= 0.0; // Smoothed fill level, in seconds
+	double m_integral	= 0.0; // Integral term of the correction
+	double m_correction = 0.0;
+	bool   m_primed		= false; // Fill level filter initialized
+};
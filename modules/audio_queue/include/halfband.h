@@ -0,0 +1,95 @@
+/**
+ * @file halfband.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-11-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Polyphase halfband FIR for exact 2x upsampling or 2x decimation of interleaved float frames.
+ *
+ * Kaiser windowed sinc, cut at a quarter of the higher rate. Every other tap of a halfband filter
+ * is zero and its centre tap is 1/2 : per output sample, one phase costs a dot product over
+ * half the taps and the other phase is a plain (delayed) copy.
+ *
+ * Like a libsamplerate session, the filter history lives across process() calls.
+ *
+ */
+class halfband
+{
+public:
+
+	enum class direction : uint8_t
+	{
+		up,	 // Output rate = 2 x input rate
+		down // Output rate = input rate / 2
+	};
+
+	struct result
+	{
+		std::size_t frames_used		 = 0; // Input frames consumed
+		std::size_t frames_generated = 0; // Output frames written
+	};
+
+	/**
+     * @brief Design the filter and allocate its history.
+     *
+     * @param channels Number of interleaved channels
+     * @param dir Up or down sampling
+     * @param half_taps Non-zero taps of the filtering phase, rounded up to even (filter length is 2 x half_taps - 1)
+     * @param beta Kaiser window beta, stopband attenuation grows with it
+     */
+	halfband(uint8_t channels, direction dir, std::size_t half_taps, double beta);
+
+	/**
+     * @brief Resample a block of interleaved frames, stops when the input is consumed or the output is full.
+     *
+     */
+	result process(const float* input, std::size_t input_frames, float* output, std::size_t output_frames);
+
+	/**
+     * @brief Drain the delay line (end of stream), then reset. Same contract as resampler::flush().
+     *
+     */
+	std::size_t flush(float* output, std::size_t output_frames);
+
+	/**
+     * @brief Forget the filter history.
+     *
+     */
+	void reset();
+
+private:
+
+	/**
+     * @brief Push one input frame into the per channel delay lines.
+     *
+     */
+	void push_frame(const float* frame);
+
+	/**
+     * @brief Oldest to newest samples of a channel delay line, contiguous.
+     *
+     */
+	[[nodiscard]] const float* window(std::size_t channel) const { return &m_history[(channel * 2 * m_length) + m_position]; }
+
+	uint8_t		m_channels;
+	direction	m_direction;
+	std::vector<float> m_coef;		 // Non-zero taps of the filtering phase
+	std::size_t		   m_length;	 // Delay line length, in frames
+	std::vector<float> m_history;	 // Per channel delay line, stored twice in a row : any window is contiguous
+	std::size_t		   m_position = 0; // Oldest frame of the delay lines
+
+	bool		m_odd	  = false; // Down : next input frame is the odd one of a pair (no output)
+	bool		m_primed  = false; // Input received since the last reset
+	std::size_t m_draining = 0;	   // Zero frames still to feed while flushing
+};
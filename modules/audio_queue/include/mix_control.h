@@ -0,0 +1,205 @@
+/**
+ * @file mix_control.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-11-15
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "channel.h"
+#include "channel_mix.h"
+
+/**
+ * @brief Per sample gains of one pop : the gain and pan ramps, frozen when the pop starts.
+ *
+ * The coefficient of a sample is gain(frame) x pan(channel, frame), both linear ramps reaching their
+ * target after their frame count, then constant. Frames are counted from the start of the pop.
+ *
+ */
+struct mix_gains
+{
+	static constexpr std::size_t max_channels = channel_matrix::max_channels;
+
+	float		m_gain		  = 1.0F;
+	float		m_gain_step	  = 0.0F;
+	std::size_t m_gain_frames = 0; // Frames left in the gain ramp
+
+	std::array<float, max_channels> m_pan{};	  // Per channel pan gain
+	std::array<float, max_channels> m_pan_step{};
+	std::size_t						m_pan_frames = 0; // Frames left in the pan ramp
+
+	std::size_t						m_channels = 1;
+	std::array<float, max_channels> m_steady{};		// Per channel coefficient once both ramps are over
+	bool							m_uniform = true; // Every steady coefficient is the same
+
+	/**
+     * @brief Accumulate interleaved frames : target += coefficient x source.
+     *
+     * Ramping frames go sample by sample, steady ones in one flat loop when every channel has the same gain.
+     *
+     * @param target Interleaved float frames to add to
+     * @param source Interleaved float frames
+     * @param first_frame Position of the first frame in the pop
+     * @param frames Frame count
+     */
+	void accumulate(float* target, const float* source, std::size_t first_frame, std::size_t frames) const
+	{
+		const std::size_t ramping = ramp_frames(first_frame, frames);
+		for (std::size_t frame_idx = 0; frame_idx < ramping; ++frame_idx)
+		{
+			const std::size_t at   = first_frame + frame_idx;
+			const float		  gain = ramp(m_gain, m_gain_step, m_gain_frames, at);
+			for (std::size_t channel = 0; channel < m_channels; ++channel)
+			{
+				const std::size_t sample = (frame_idx * m_channels) + channel;
+				target[sample] += gain * ramp(m_pan[channel], m_pan_step[channel], m_pan_frames, at) * source[sample];
+			}
+		}
+
+		const std::size_t offset = ramping * m_channels;
+		const std::size_t count	 = (frames - ramping) * m_channels;
+		if (m_uniform)
+		{
+			const float coefficient = m_steady[0];
+			for (std::size_t i = 0; i < count; ++i)
+				target[offset + i] += coefficient * source[offset + i];
+		}
+		else
+			for (std::size_t i = 0; i < count; i += m_channels)
+				for (std::size_t channel = 0; channel < m_channels; ++channel)
+					target[offset + i + channel] += m_steady[channel] * source[offset + i + channel];
+	}
+
+	/**
+     * @brief Accumulate the samples of one channel : target[i x target_stride] += coefficient x source[i x source_stride].
+     *
+     */
+	void accumulate_channel(float* target, std::size_t target_stride, const float* source, std::size_t source_stride,
+							std::size_t channel, std::size_t first_frame, std::size_t frames) const
+	{
+		const std::size_t ramping = ramp_frames(first_frame, frames);
+		for (std::size_t frame_idx = 0; frame_idx < ramping; ++frame_idx)
+		{
+			const std::size_t at = first_frame + frame_idx;
+			target[frame_idx * target_stride] += ramp(m_gain, m_gain_step, m_gain_frames, at)
+											   * ramp(m_pan[channel], m_pan_step[channel], m_pan_frames, at)
+											   * source[frame_idx * source_stride];
+		}
+
+		const float coefficient = m_steady[channel];
+		for (std::size_t frame_idx = ramping; frame_idx < frames; ++frame_idx)
+			target[frame_idx * target_stride] += coefficient * source[frame_idx * source_stride];
+	}
+
+	/**
+     * @brief Same gains, times a constant.
+     *
+     */
+	[[nodiscard]] mix_gains scaled(float factor) const
+	{
+		mix_gains gains = *this;
+		gains.m_gain *= factor;
+		gains.m_gain_step *= factor;
+		for (auto& steady : gains.m_steady)
+			steady *= factor;
+		return gains;
+	}
+
+private:
+
+	[[nodiscard]] static float ramp(float start, float step, std::size_t frames, std::size_t at)
+	{
+		return start + (step * static_cast<float>(std::min(at, frames)));
+	}
+
+	/**
+     * @brief Frames of [first_frame, first_frame + frames) still inside a ramp.
+     *
+     */
+	[[nodiscard]] std::size_t ramp_frames(std::size_t first_frame, std::size_t frames) const
+	{
+		const std::size_t ramp_end = std::max(m_gain_frames, m_pan_frames);
+		return ramp_end > first_frame ? std::min(ramp_end - first_frame, frames) : 0;
+	}
+};
+
+/**
+ * @brief Gain, pan and fades of one mixed stream, set lock-free from control threads.
+ *
+ * Every change ramps linearly over a number of frames (a fade is a long ramp) : no click.
+ * The consumer freezes the ramps when a pop starts (begin()), applies them inside its accumulation
+ * loop, then moves them forward by the frames it popped (end()). One consumer at a time.
+ * Between two pops, the latest change wins : each ramp starts from the current value.
+ *
+ * Pan is constant power, unity at the centre : left and right channels of each pair (front, surround, back)
+ * get sqrt(2) cos / sin of (pan + 1) x pi / 4. Centre, LFE and mono channels are not panned.
+ *
+ */
+class mix_control
+{
+public:
+
+	static constexpr std::size_t default_ramp_frame = 256; // About 5 ms at 48 KHz
+
+	explicit mix_control(channel_layout layout);
+
+	/* Shared by reference between control threads and the consumer */
+	mix_control(const mix_control&)			   = delete;
+	mix_control& operator=(const mix_control&) = delete;
+
+	/**
+     * @brief Ramp the gain to a new value, from any thread.
+     *
+     * @param gain Linear gain
+     * @param ramp_frames Length of the ramp, in frames (0 : immediate)
+     */
+	void set_gain(float gain, std::size_t ramp_frames = default_ramp_frame) { m_gain_target.store(pack(gain, ramp_frames), std::memory_order_relaxed); }
+
+	/**
+     * @brief Ramp the pan to a new position, from any thread.
+     *
+     * @param pan -1 (left) to 1 (right), 0 at the centre
+     * @param ramp_frames Length of the ramp, in frames (0 : immediate)
+     */
+	void set_pan(float pan, std::size_t ramp_frames = default_ramp_frame) { m_pan_target.store(pack(std::clamp(pan, -1.0F, 1.0F), ramp_frames), std::memory_order_relaxed); }
+
+	[[nodiscard]] float gain() const { return unpack(m_gain_target.load(std::memory_order_relaxed)); }
+	[[nodiscard]] float pan() const { return unpack(m_pan_target.load(std::memory_order_relaxed)); }
+
+	/**
+     * @brief Consumer : pick up the latest targets and freeze the ramps of a pop.
+     *
+     */
+	[[nodiscard]] mix_gains begin();
+
+	/**
+     * @brief Consumer : move the ramps forward by the frames popped.
+     *
+     */
+	void end(std::size_t frames);
+
+private:
+
+	// Target value and ramp length in one atomic : a ramp never starts with the length of another change.
+	[[nodiscard]] static std::uint64_t pack(float value, std::size_t ramp_frames);
+	[[nodiscard]] static float		   unpack(std::uint64_t packed);
+
+	std::atomic<std::uint64_t> m_gain_target;
+	std::atomic<std::uint64_t> m_pan_target;
+
+	// Consumer side
+	channel_layout				m_layout;
+	std::uint64_t				m_gain_seen;
+	std::uint64_t				m_pan_seen;
+	mix_gains					m_state; // Ramps at the current position
+};
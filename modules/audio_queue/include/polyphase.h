@@ -0,0 +1,145 @@
+/**
+ * @file polyphase.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-11-24
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "resampler.h"
+
+/**
+ * @brief Polyphase coefficient table of a fixed rational ratio : output rate / input rate = up / down.
+ *
+ * Kaiser windowed sinc cut below the lower Nyquist frequency, one phase of taps per output position
+ * between two input frames. Linear and zero-order hold tiers are exact 2 and 1 tap tables.
+ * Each phase sums to 1 (unity gain at DC).
+ *
+ * Tables are immutable : shared() hands out one table per (input rate, output rate, quality),
+ * for as long as someone uses it.
+ *
+ */
+class polyphase_filter
+{
+public:
+
+	/**
+     * @brief Design a table.
+     *
+     * @param input_rate Input sample rate
+     * @param output_rate Output sample rate
+     * @param quality Filter length and stopband tier
+     */
+	polyphase_filter(std::uint32_t input_rate, std::uint32_t output_rate, resample_quality quality);
+
+	/**
+     * @brief The table of a (rates, quality) key, designed on first use and shared while alive.
+     *
+     */
+	static std::shared_ptr<const polyphase_filter> shared(std::uint32_t input_rate, std::uint32_t output_rate, resample_quality quality);
+
+	[[nodiscard]] std::size_t up() const { return m_up; }
+	[[nodiscard]] std::size_t down() const { return m_down; }
+	[[nodiscard]] std::size_t taps() const { return m_taps; }
+
+	/**
+     * @brief Taps of a phase, oldest input frame first.
+     *
+     */
+	[[nodiscard]] const float* phase(std::size_t index) const { return &m_coefficients[index * m_taps]; }
+
+private:
+
+	std::size_t		   m_up;
+	std::size_t		   m_down;
+	std::size_t		   m_taps;
+	std::vector<float> m_coefficients; // up x taps, phase major
+};
+
+/**
+ * @brief Resampler of many streams at once, lanes side by side (structure of arrays).
+ *
+ * A lane is one channel of one stream. Frames are rows of lanes : input(frame)[lane], output(frame)[lane].
+ * Every lane shares the filter table and the position between input frames, so each tap is one multiply-add
+ * over a row of contiguous lanes : the kernel vectorizes across streams, and one table serves all of them.
+ *
+ * Per block, callers write input_frames_for(output_frames) input rows, process() each lane range
+ * (ranges are independent, they can run on several threads), then advance() once.
+ *
+ */
+class batch_resampler
+{
+public:
+
+	static constexpr std::size_t lane_tile = 16; // Lanes per tile of the kernels (detail::fir_lanes)
+
+	/**
+     * @brief Allocate the rows of a batch.
+     *
+     * @param filter Shared coefficient table
+     * @param lanes Lane capacity (rounded up to lane_tile)
+     * @param max_output_frames Largest block of a process() call
+     */
+	batch_resampler(std::shared_ptr<const polyphase_filter> filter, std::size_t lanes, std::size_t max_output_frames);
+
+	/**
+     * @brief Input frames consumed by the next block : the same for every lane.
+     *
+     */
+	[[nodiscard]] std::size_t input_frames_for(std::size_t output_frames) const;
+
+	/**
+     * @brief Row of lanes of an input frame of the next block, to fill before process().
+     *
+     */
+	[[nodiscard]] float* input(std::size_t frame) { return &m_history[(m_filter->taps() + frame) * m_lanes]; }
+
+	/**
+     * @brief Row of lanes of an output frame of the last block.
+     *
+     */
+	[[nodiscard]] const float* output(std::size_t frame) const { return &m_output[frame * m_lanes]; }
+
+	/**
+     * @brief Resample the lanes of [first_lane, first_lane + lane_count) over a block, and keep their history.
+     *
+     * @param output_frames Block length, at most max_output_frames
+     * @param first_lane First lane, a multiple of lane_tile
+     * @param lane_count Lane count (a partial last tile is computed whole)
+     */
+	void process(std::size_t output_frames, std::size_t first_lane, std::size_t lane_count);
+
+	/**
+     * @brief Move the shared position past a block, once every lane range is processed.
+     *
+     */
+	void advance(std::size_t output_frames);
+
+	/**
+     * @brief Silence the history of a lane (a new stream).
+     *
+     */
+	void clear_lane(std::size_t lane);
+
+	[[nodiscard]] std::size_t lanes() const { return m_lanes; }
+	[[nodiscard]] std::size_t max_output_frames() const { return m_max_output_frames; }
+	[[nodiscard]] const polyphase_filter& filter() const { return *m_filter; }
+
+private:
+
+	std::shared_ptr<const polyphase_filter> m_filter;
+	std::size_t								m_lanes;
+	std::size_t								m_max_output_frames;
+	std::size_t								m_phase = 0;   // Position of the next output frame after the last input row, in 1 / up frames
+	std::vector<float>						m_history;	   // taps rows of history, then the input rows of the block
+	std::vector<float>						m_output;	   // Output rows of the block
+};
@@ -0,0 +1,231 @@
+/**
+ * @file queue_stats.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-11-08
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Call durations by power of two buckets : bucket b counts durations in [2^(b-1), 2^b) ns (bucket 0 : 0 ns).
+ *
+ */
+struct latency_histogram
+{
+	static constexpr std::size_t bucket_count = 32; // Up to ~2 s, longer calls fall in the last bucket
+
+	std::array<std::uint64_t, bucket_count> m_buckets{};
+
+	[[nodiscard]] std::uint64_t count() const
+	{
+		std::uint64_t total = 0;
+		for (const auto bucket : m_buckets)
+			total += bucket;
+		return total;
+	}
+
+	/**
+     * @brief Upper bound of the bucket holding the given quantile (0.5 for the median, 0.99...).
+     *
+     */
+	[[nodiscard]] std::chrono::nanoseconds quantile(double fraction) const
+	{
+		const std::uint64_t total = count();
+		if (total == 0)
+			return std::chrono::nanoseconds(0);
+
+		const auto	  rank = std::clamp<std::uint64_t>(static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(total))), 1, total);
+		std::uint64_t seen = 0;
+		std::size_t	  bucket = 0;
+		for (; bucket < bucket_count - 1; ++bucket)
+		{
+			seen += m_buckets[bucket];
+			if (seen >= rank)
+				break;
+		}
+		return std::chrono::nanoseconds(std::uint64_t{1} << bucket);
+	}
+};
+
+/**
+ * @brief Snapshot of an audio_queue's counters. Frames are counted at the expected context.
+ *
+ */
+struct queue_stats
+{
+	std::uint64_t			 m_frames_pushed	  = 0; // Frames enqueued (after resampling and mapping)
+	std::uint64_t			 m_frames_popped	  = 0; // Frames dequeued, discarded ones included
+	std::uint64_t			 m_samples_dropped	  = 0; // Samples the queue had no room for
+	std::uint64_t			 m_frames_overwritten = 0; // Oldest frames dropped to make room (overflow_policy::overwrite_oldest)
+	std::uint64_t			 m_underruns		  = 0; // Pops that found fewer frames than wanted
+	std::uint64_t			 m_frames_short		  = 0; // Frames missing over those pops
+	std::size_t				 m_fill_frames		  = 0; // Frames ready to pop, when the snapshot was taken
+	std::size_t				 m_high_water		  = 0; // Highest fill level seen after a push, in frames
+	std::chrono::nanoseconds m_resample_time{0};	   // Time spent in the resampler
+	double					 m_drift_ppm = 0.0;		   // Last drift compensation ratio correction, in ppm
+	latency_histogram		 m_push_latency;		   // Durations of the push_audio() calls
+	latency_histogram		 m_pop_latency;			   // Durations of the pop_audio() / pop_float() / pop_add() calls
+};
+
+/**
+ * @brief Live counters behind queue_stats : relaxed atomics only, producer and consumer sides on their own cache lines.
+ *
+ * Updating a counter is one uncontended atomic add on the audio path. A snapshot may mix values
+ * from calls in flight, each counter is exact on its own.
+ *
+ */
+class queue_counters
+{
+public:
+
+	/**
+     * @brief Measures one call and adds it to a histogram when it goes out of scope.
+     *
+     */
+	class scoped_latency
+	{
+	public:
+
+		explicit scoped_latency(std::array<std::atomic<std::uint64_t>, latency_histogram::bucket_count>& buckets)
+			: m_buckets(buckets),
+			  m_start(std::chrono::steady_clock::now())
+		{}
+
+		scoped_latency(const scoped_latency&)			 = delete;
+		scoped_latency& operator=(const scoped_latency&) = delete;
+
+		~scoped_latency()
+		{
+			const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+			record(m_buckets, static_cast<std::uint64_t>(elapsed));
+		}
+
+	private:
+
+		std::array<std::atomic<std::uint64_t>, latency_histogram::bucket_count>& m_buckets;
+		std::chrono::steady_clock::time_point									 m_start;
+	};
+
+	[[nodiscard]] scoped_latency time_push() { return scoped_latency(m_producer.m_latency); }
+	[[nodiscard]] scoped_latency time_pop() { return scoped_latency(m_consumer.m_latency); }
+
+	void pushed(std::size_t frames, std::size_t dropped_samples)
+	{
+		m_producer.m_frames.fetch_add(frames, std::memory_order_relaxed);
+		if (dropped_samples != 0)
+			m_producer.m_dropped.fetch_add(dropped_samples, std::memory_order_relaxed);
+	}
+
+	void filled(std::size_t fill_frames)
+	{
+		auto high = m_producer.m_high_water.load(std::memory_order_relaxed);
+		while (fill_frames > high && !m_producer.m_high_water.compare_exchange_weak(high, fill_frames, std::memory_order_relaxed)) {}
+	}
+
+	void overwritten(std::size_t frames)
+	{
+		m_producer.m_overwritten.fetch_add(frames, std::memory_order_relaxed);
+	}
+
+	void resampled(std::chrono::nanoseconds elapsed)
+	{
+		m_producer.m_resample_ns.fetch_add(static_cast<std::uint64_t>(elapsed.count()), std::memory_order_relaxed);
+	}
+
+	void corrected(double correction)
+	{
+		m_producer.m_drift_ppm.store(correction * 1e6, std::memory_order_relaxed);
+	}
+
+	void popped(std::size_t frames, std::size_t wanted_frames, bool count_underrun)
+	{
+		m_consumer.m_frames.fetch_add(frames, std::memory_order_relaxed);
+		if (count_underrun && frames < wanted_frames)
+		{
+			m_consumer.m_underruns.fetch_add(1, std::memory_order_relaxed);
+			m_consumer.m_short.fetch_add(wanted_frames - frames, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+     * @brief Frames in the queue by the counters : pushed, minus popped and overwritten. Exact once the calls in
+     * flight are done, 0 when a pop is counted before its push.
+     *
+     */
+	[[nodiscard]] std::size_t fill_frames() const
+	{
+		const std::uint64_t out = m_consumer.m_frames.load(std::memory_order_relaxed) + m_producer.m_overwritten.load(std::memory_order_relaxed);
+		const std::uint64_t in	= m_producer.m_frames.load(std::memory_order_relaxed);
+		return in > out ? static_cast<std::size_t>(in - out) : 0;
+	}
+
+	/**
+     * @brief Copy every counter (the fill level is the caller's).
+     *
+     */
+	[[nodiscard]] queue_stats snapshot(std::size_t fill_frames) const
+	{
+		queue_stats stats;
+		stats.m_frames_pushed	   = m_producer.m_frames.load(std::memory_order_relaxed);
+		stats.m_frames_popped	   = m_consumer.m_frames.load(std::memory_order_relaxed);
+		stats.m_samples_dropped	   = m_producer.m_dropped.load(std::memory_order_relaxed);
+		stats.m_frames_overwritten = m_producer.m_overwritten.load(std::memory_order_relaxed);
+		stats.m_underruns		   = m_consumer.m_underruns.load(std::memory_order_relaxed);
+		stats.m_frames_short	   = m_consumer.m_short.load(std::memory_order_relaxed);
+		stats.m_fill_frames		   = fill_frames;
+		stats.m_high_water		   = m_producer.m_high_water.load(std::memory_order_relaxed);
+		stats.m_resample_time	   = std::chrono::nanoseconds(m_producer.m_resample_ns.load(std::memory_order_relaxed));
+		stats.m_drift_ppm		   = m_producer.m_drift_ppm.load(std::memory_order_relaxed);
+		for (std::size_t bucket = 0; bucket < latency_histogram::bucket_count; ++bucket)
+		{
+			stats.m_push_latency.m_buckets[bucket] = m_producer.m_latency[bucket].load(std::memory_order_relaxed);
+			stats.m_pop_latency.m_buckets[bucket]  = m_consumer.m_latency[bucket].load(std::memory_order_relaxed);
+		}
+		return stats;
+	}
+
+private:
+
+	static void record(std::array<std::atomic<std::uint64_t>, latency_histogram::bucket_count>& buckets, std::uint64_t nanoseconds)
+	{
+		const auto bucket = std::min<std::size_t>(std::bit_width(nanoseconds), latency_histogram::bucket_count - 1);
+		buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	static constexpr std::size_t cache_line = 64;
+
+	struct alignas(cache_line) producer_side
+	{
+		std::atomic<std::uint64_t>											m_frames{0};
+		std::atomic<std::uint64_t>											m_dropped{0};
+		std::atomic<std::uint64_t>											m_overwritten{0};
+		std::atomic<std::size_t>											m_high_water{0};
+		std::atomic<std::uint64_t>											m_resample_ns{0};
+		std::atomic<double>													m_drift_ppm{0.0};
+		std::array<std::atomic<std::uint64_t>, latency_histogram::bucket_count> m_latency{};
+	};
+
+	struct alignas(cache_line) consumer_side
+	{
+		std::atomic<std::uint64_t>											m_frames{0};
+		std::atomic<std::uint64_t>											m_underruns{0};
+		std::atomic<std::uint64_t>											m_short{0};
+		std::array<std::atomic<std::uint64_t>, latency_histogram::bucket_count> m_latency{};
+	};
+
+	producer_side m_producer;
+	consumer_side m_consumer;
+};
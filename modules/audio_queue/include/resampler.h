@@ -0,0 +1,135 @@
+/**
+ * @file resampler.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-10-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "halfband.h"
+#include "samplerate.h"
+
+/**
+ * @brief Resampling quality / cost tier.
+ *
+ * The sinc tiers map to libsamplerate's sinc converters, except for exact 2x ratios
+ * (48 KHz <-> 96 KHz...) which use a built-in polyphase halfband filter of matching quality.
+ *
+ */
+enum class resample_quality : uint8_t
+{
+	best,			 // SRC_SINC_BEST_QUALITY, program output
+	medium,			 // SRC_SINC_MEDIUM_QUALITY
+	fastest,		 // SRC_SINC_FASTEST
+	zero_order_hold, // SRC_ZERO_ORDER_HOLD, monitoring
+	linear			 // SRC_LINEAR, voice
+};
+
+/**
+ * @brief Persistent libsamplerate session for one interleaved float stream.
+ *
+ * The converter state (and so the filter history) lives across calls to process(),
+ * a stream cut into blocks is resampled exactly like the same stream in one piece.
+ * Exact 2x ratios at a sinc tier run on a halfband filter instead of libsamplerate.
+ *
+ */
+class resampler
+{
+public:
+
+	/**
+     * @brief Result of one process() call.
+     *
+     */
+	struct result
+	{
+		std::size_t frames_used		 = 0; // Input frames consumed
+		std::size_t frames_generated = 0; // Output frames written
+	};
+
+	/**
+     * @brief Create a resampler session.
+     *
+     * @param channels Number of interleaved channels
+     * @param ratio Output sample rate / input sample rate
+     * @param quality Quality / cost tier
+     * @param variable_ratio The ratio will be adjusted with set_ratio() : always use libsamplerate, never the fixed halfband
+     *
+     * @throw std::runtime_error if libsamplerate fails to create its state.
+     */
+	resampler(uint8_t channels, double ratio, resample_quality quality = resample_quality::best, bool variable_ratio = false);
+
+	/* A session owns its libsamplerate state : move only */
+	resampler(const resampler&)			   = delete;
+	resampler& operator=(const resampler&) = delete;
+	resampler(resampler&& other) noexcept;
+	resampler& operator=(resampler&& other) noexcept;
+
+	~resampler();
+
+	/**
+     * @brief Resample a block of interleaved frames.
+     *
+     * Stops when either the input is consumed or the output is full,
+     * the caller loops on the unused input if frames_used < input_frames.
+     *
+     * @param input Interleaved input frames
+     * @param input_frames Input frame count
+     * @param output Interleaved output buffer
+     * @param output_frames Output buffer capacity, in frames
+     * @return std::optional<result> Frames used and generated, std::nullopt on libsamplerate error
+     */
+	[[nodiscard]]
+	std::optional<result> process(const float* input, std::size_t input_frames, float* output, std::size_t output_frames);
+
+	/**
+     * @brief Drain the samples still held by the filter (end of stream), then reset the session.
+     *
+     * Call repeatedly until it returns 0 if the output buffer may be too small for the whole tail.
+     *
+     * @param output Interleaved output buffer
+     * @param output_frames Output buffer capacity, in frames
+     * @return std::optional<std::size_t> Frames generated, std::nullopt on libsamplerate error
+     */
+	[[nodiscard]]
+	std::optional<std::size_t> flush(float* output, std::size_t output_frames);
+
+	/**
+     * @brief Forget the filter history, next process() starts a new stream.
+     *
+     */
+	void reset();
+
+	/**
+     * @brief Output frames expected for a given input block, used to size buffers.
+     *
+     */
+	[[nodiscard]]
+	std::size_t max_output_frames(std::size_t input_frames) const;
+
+	/**
+     * @brief Change the ratio of the next process() calls (variable ratio sessions only).
+     *
+     * libsamplerate glides from the previous ratio to the new one over the next block : no step, no click.
+     *
+     */
+	void set_ratio(double ratio) { m_ratio = ratio; }
+
+	[[nodiscard]] uint8_t channels() const { return m_channels; }
+	[[nodiscard]] double  ratio() const { return m_ratio; }
+
+private:
+
+	SRC_STATE*				m_state = nullptr; // Null when the halfband fast path is used
+	std::optional<halfband> m_halfband;
+	uint8_t					m_channels = 0;
+	double					m_ratio	   = 1.0;
+};
@@ -0,0 +1,164 @@
+/**
+ * @file sample_convert.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-10-24
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+
+#include "audio_prop_def.h"
+
+/**
+ * @brief Vectorized kernels for the common integer formats.
+ *
+ * The best available instruction set (AVX2, SSE2, NEON) is selected once at runtime,
+ * with a scalar fallback. Every kernel gives the exact same result as make_audio_converters.
+ * The 24-bit kernels unpack (or pack) and convert in the same pass, without an intermediate int32 buffer.
+ *
+ */
+namespace detail
+{
+	void int16_to_float(const int16_t* input, float* output, std::size_t count);
+	void int32_to_float(const int32_t* input, float* output, std::size_t count);
+	void uint8_to_float(const uint8_t* input, float* output, std::size_t count);
+	void int24_packed_to_float(const int24_packed* input, float* output, std::size_t count);
+	void int24_in_32_to_float(const int24_in_32* input, float* output, std::size_t count);
+
+	void float_to_int16(const float* input, int16_t* output, std::size_t count);
+	void float_to_int32(const float* input, int32_t* output, std::size_t count);
+	void float_to_uint8(const float* input, uint8_t* output, std::size_t count);
+	void float_to_int24_packed(const float* input, int24_packed* output, std::size_t count);
+	void float_to_int24_in_32(const float* input, int24_in_32* output, std::size_t count);
+
+	void soft_limit(float* samples, std::size_t count, float knee);
+	void fir_lanes(const float* coefficients, std::size_t taps, const float* window, std::size_t stride, float* output, std::size_t lanes);
+	void add_tpdf_dither(float* samples, std::size_t count, float lsb, bool toward_zero, std::uint32_t& state);
+} // namespace detail
+
+/**
+ * @brief Convert a block of samples to normalized float, same result as make_audio_converters' to_float.
+ *
+ * @tparam AudioType The underlying audio sample type
+ * @param input Samples to convert
+ * @param output Destination, at least input.size() floats
+ */
+template <audio_sample_type AudioType>
+void convert_to_float(std::span<const AudioType> input, std::span<float> output)
+{
+	if constexpr (std::is_same_v<AudioType, int16_t>)
+		detail::int16_to_float(input.data(), output.data(), input.size());
+	else if constexpr (std::is_same_v<AudioType, int32_t>)
+		detail::int32_to_float(input.data(), output.data(), input.size());
+	else if constexpr (std::is_same_v<AudioType, uint8_t>)
+		detail::uint8_to_float(input.data(), output.data(), input.size());
+	else if constexpr (std::is_same_v<AudioType, int24_packed>)
+		detail::int24_packed_to_float(input.data(), output.data(), input.size());
+	else if constexpr (std::is_same_v<AudioType, int24_in_32>)
+		detail::int24_in_32_to_float(input.data(), output.data(), input.size());
+	else if constexpr (std::is_same_v<AudioType, float>)
+		std::ranges::copy(input, output.begin());
+	else
+		std::ranges::transform(input, output.begin(), make_audio_converters<AudioType>().first);
+}
+
+/**
+ * @brief Convert a block of normalized float to samples, same result as make_audio_converters' from_float.
+ *
+ * @tparam AudioType The underlying audio sample type
+ * @param input Float samples to convert
+ * @param output Destination, at least input.size() samples
+ */
+template <audio_sample_type AudioType>
+void convert_from_float(std::span<const float> input, std::span<AudioType> output)
+{
+	if constexpr (std::is_same_v<AudioType, int16_t>)
+		detail::float_to_int16(input.data(), output.data(), input.size());
+	else if constexpr (std::is_same_v<AudioType, int32_t>)
+		detail::float_to_int32(input.data(), output.data(), input.size());
+	else if constexpr (std::is_same_v<AudioType, uint8_t>)
+		detail::float_to_uint8(input.data(), output.data(), input.size());
+	else if constexpr (std::is_same_v<AudioType, int24_packed>)
+		detail::float_to_int24_packed(input.data(), output.data(), input.size());
+	else if constexpr (std::is_same_v<AudioType, int24_in_32>)
+		detail::float_to_int24_in_32(input.data(), output.data(), input.size());
+	else if constexpr (std::is_same_v<AudioType, float>)
+		std::ranges::copy(input, output.begin());
+	else
+		std::ranges::transform(input, output.begin(), make_audio_converters<AudioType>().second);
+}
+
+/**
+ * @brief Soft-knee limiter, in place : samples below the knee are untouched, louder ones bend smoothly towards full scale.
+ *
+ * Above the knee, |y| = knee + r x e / (r + e), with r = 1 - knee and e = |x| - knee : the curve leaves
+ * the identity with the same slope and never reaches 1. No hard clipping, whatever the sum.
+ * Vectorized like the converters.
+ *
+ * @param samples Float samples (sum of the mix, any level)
+ * @param knee Level where the curve starts to bend, in [0, 1)
+ */
+inline void soft_limit(std::span<float> samples, float knee)
+{
+	// A knee of 1 would leave no room for the curve
+	detail::soft_limit(samples.data(), samples.size(), std::clamp(knee, 0.0F, 0.999F));
+}
+
+/**
+ * @brief One step (LSB) of an integer sample type, in normalized float. 0 when dither is pointless : float types,
+ * and int32 whose LSB is below the float resolution.
+ *
+ */
+template <audio_sample_type AudioType>
+constexpr float dither_lsb()
+{
+	if constexpr (std::is_same_v<AudioType, int16_t>)
+		return 1.0F / 32768.0F;
+	else if constexpr (std::is_same_v<AudioType, uint8_t>)
+		return 1.0F / 127.5F;
+	else if constexpr (std::is_same_v<AudioType, int24_packed> || std::is_same_v<AudioType, int24_in_32>)
+		return 1.0F / 8388608.0F;
+	else
+		return 0.0F;
+}
+
+/**
+ * @brief Triangular (TPDF) dither, 1 LSB of the output type, added to float samples before an integer conversion.
+ *
+ * The quantization error no longer follows the signal : quiet passages and fade tails get a flat noise floor
+ * instead of distortion. One generator per output stream, not shared between threads.
+ *
+ * The signed conversions truncate toward zero : dithered samples also move half a step away from zero,
+ * which turns the truncation into a rounding to nearest (no 2 LSB dead zone around silence).
+ *
+ */
+class tpdf_dither
+{
+public:
+
+	explicit tpdf_dither(std::uint32_t seed = 0x9E3779B9U)
+		: m_state(seed != 0 ? seed : 1U)
+	{}
+
+	/**
+     * @brief Add the dither of AudioType to samples about to be converted to it, nothing for types without dither.
+     *
+     */
+	template <audio_sample_type AudioType>
+	void apply(std::span<float> samples)
+	{
+		if constexpr (dither_lsb<AudioType>() != 0.0F)
+			detail::add_tpdf_dither(samples.data(), samples.size(), dither_lsb<AudioType>(), !std::is_same_v<AudioType, uint8_t>, m_state);
+	}
+
+private:
+
+	std::uint32_t m_state; // xorshift32 generator
+};
@@ -10,6 +10,7 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string_view>
 
@@ -64,6 +65,29 @@ struct sample_rate
      */
 	constexpr operator value() const { return m_value; }
 
+	/**
+     * @brief Dense index of the sample rate, for lookup tables.
+     * 
+     * @return std::size_t index in [0, count)
+     */
+	[[nodiscard]]
+	constexpr std::size_t index() const
+	{
+		switch (m_value)
+		{
+			case SR44100:  return 0;
+			case SR48000:  return 1;
+			case SR88200:  return 2;
+			case SR96000:  return 3;
+			case SR176400: return 4;
+			case SR192000: return 5;
+		}
+		return 0;
+	}
+
+	// Number of supported sample rates
+	static constexpr std::size_t count = 6;
+
 private:
 
 	value m_value = SR44100;
@@ -0,0 +1,488 @@
+/**
+ * @file shared_audio_queue.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-11-26
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "audio_queue.h"
+
+/**
+ * @brief Named shared memory segment (POSIX shm_open), mapped read / write.
+ *
+ * The name is global to the machine until remove() : processes open the segment by name, and each mapping
+ * stays valid after the name is removed. Not available on Windows (create() and open() fail).
+ *
+ */
+class shared_memory
+{
+public:
+
+	/**
+     * @brief Create and map a new segment, filled with zeros.
+     *
+     * @param name Segment name, "/name" (the leading slash is added if missing)
+     * @param size Segment size, in bytes
+     * @return std::optional<shared_memory> The mapping, std::nullopt if the name exists or the segment can not be created
+     */
+	static std::optional<shared_memory> create(std::string_view name, std::size_t size);
+
+	/**
+     * @brief Map an existing segment, whole.
+     *
+     * @return std::optional<shared_memory> The mapping, std::nullopt if there is no such segment
+     */
+	static std::optional<shared_memory> open(std::string_view name);
+
+	/**
+     * @brief Remove a segment name. Mappings stay valid until unmapped.
+     *
+     * @return true The name was removed
+     */
+	static bool remove(std::string_view name);
+
+	shared_memory(shared_memory&& other) noexcept;
+	shared_memory& operator=(shared_memory&& other) noexcept;
+	shared_memory(const shared_memory&)			   = delete;
+	shared_memory& operator=(const shared_memory&) = delete;
+	~shared_memory();
+
+	[[nodiscard]] std::span<std::byte> bytes() const { return {m_data, m_size}; }
+
+private:
+
+	shared_memory() = default;
+	void unmap();
+
+	std::byte*	m_data = nullptr; // Page aligned
+	std::size_t m_size = 0;
+};
+
+namespace detail
+{
+	/**
+     * @brief Id of the calling process.
+     *
+     */
+	std::int64_t current_process();
+
+	/**
+     * @brief Whether a process exists (it may belong to another user). Sees the processes of the caller's pid namespace only.
+     *
+     */
+	bool process_alive(std::int64_t process);
+} // namespace detail
+
+/**
+ * @brief Side of a shared_audio_queue : the producer pushes, the consumer pops.
+ *
+ */
+enum class shared_queue_role : uint8_t
+{
+	producer,
+	consumer
+};
+
+/**
+ * @brief State of the other side of a shared_audio_queue.
+ *
+ */
+enum class shared_queue_peer : uint8_t
+{
+	absent,	  // Never attached
+	attached, // Its process is alive
+	detached, // Closed its queue
+	lost	  // Its process died without closing
+};
+
+/**
+ * @brief Start of a shared_audio_queue segment : format of the queue, its two endpoints and wake-up words.
+ *
+ * Then comes the ring (audio_ring counters and samples) at m_ring_offset. Every field shared after creation
+ * is a lock-free atomic, valid at any address : each process maps the segment where it likes.
+ *
+ */
+struct shared_queue_header
+{
+	static constexpr std::uint32_t magic_value	 = 0x51534D41; // "AMSQ"
+	static constexpr std::uint32_t version_value = 1;
+
+	struct endpoint
+	{
+		std::atomic<std::int64_t>	m_process{0};	// Process attached
+		std::atomic<std::uint32_t>	m_state{0};		// shared_queue_peer : absent, attached or detached
+		std::atomic<std::int64_t>	m_heartbeat{0}; // steady_clock of its last push or pop, in ns (one clock for the whole machine)
+	};
+
+	std::atomic<std::uint32_t> m_magic{0}; // Written last by the creator : the fields below are set
+	std::uint32_t			   m_version = version_value;
+	audio_format			   m_format;
+	queue_storage			   m_storage   = queue_storage::interleaved;
+	queue_precision			   m_precision = queue_precision::float32;
+	std::uint64_t			   m_capacity  = 0; // Ring shape
+	std::uint64_t			   m_planes	   = 1;
+	std::uint64_t			   m_sample_bytes = sizeof(float);
+	std::uint64_t			   m_ring_offset  = 0; // Bytes from the segment start, cache line aligned
+
+	std::array<endpoint, 2> m_endpoints; // By shared_queue_role
+
+	// Wake-up words (futexes) : bumped after a push / pop, waiters counted so a signal without sleeper stays a plain atomic add.
+	alignas(audio_ring::cache_line) std::atomic<std::uint32_t> m_data_signal{0};
+	std::atomic<std::uint32_t>								   m_data_waiters{0};
+	alignas(audio_ring::cache_line) std::atomic<std::uint32_t> m_space_signal{0};
+	std::atomic<std::uint32_t>								   m_space_waiters{0};
+};
+static_assert(std::atomic<std::int64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+			  "shared_queue_header atomics must be lock-free to be shared between processes");
+
+/**
+ * @brief audio_queue whose ring lives in a named shared memory segment : a producer process pushes, a consumer process pops.
+ *
+ * Each process holds its own audio_queue over the same ring : the producer converts, maps and resamples into
+ * shared memory, the consumer pops (and mixes) straight from it. Nothing is copied between processes and the
+ * data path makes no system call : the ring is the same lock-free ring as in one process.
+ *
+ * Both sides share the queue format, set by the creator (either side). The creator owns the name : it is
+ * removed when the creator closes, the other side keeps its mapping.
+ *
+ * Liveness : each side records its process and the time of its last push or pop. peer() tells a side
+ * closed its queue from a side that died (its process is gone), peer_idle() detects a hung one.
+ *
+ * Wake-up : wait_for_frames() and wait_for_space() sleep (process-shared futex on Linux) instead of spinning. Pushes and pops
+ * through this class signal the other side, with a system call only if it is asleep.
+ *
+ * @tparam AudioType Sample type pushed or popped by this side (the other side may use another one)
+ */
+template <audio_sample_type AudioType>
+class shared_audio_queue
+{
+public:
+
+	/**
+     * @brief Create the segment of a queue, and attach to it.
+     *
+     * A segment of the same name left by processes that are all gone is replaced.
+     *
+     * @param name Segment name
+     * @param role Side of this process
+     * @param ctx Expected audio context of the queue
+     * @param latency_ms Queue capacity (in latency, ms), fixed for the life of the segment
+     * @param quality Resampling quality of this side's pushes
+     * @param storage Interleaved or planar samples inside the queue
+     * @param precision Float samples, or 16-bit samples
+     * @return std::unique_ptr<shared_audio_queue> The queue, nullptr if the name is in use or the segment can not be created
+     */
+	static std::unique_ptr<shared_audio_queue> create(std::string_view name, shared_queue_role role, audio_ctx ctx, std::size_t latency_ms = 200,
+													  resample_quality quality = resample_quality::best, queue_storage storage = queue_storage::interleaved,
+													  queue_precision precision = queue_precision::float32)
+	{
+		const auto		  shape		  = audio_queue<AudioType>::ring_shape(ctx, latency_ms, storage, precision);
+		const std::size_t ring_offset = (sizeof(shared_queue_header) + audio_ring::cache_line - 1) / audio_ring::cache_line * audio_ring::cache_line;
+		const std::size_t size		  = ring_offset + audio_ring::memory_bytes(shape.m_capacity, shape.m_planes, shape.m_sample_bytes);
+
+		auto memory = shared_memory::create(name, size);
+		if (!memory && abandoned(name) && shared_memory::remove(name))
+			memory = shared_memory::create(name, size);
+		if (!memory)
+			return nullptr;
+
+		auto* header		   = new (memory->bytes().data()) shared_queue_header{};
+		header->m_format	   = audio_format{ctx.m_sample_rate, ctx.m_channel_num};
+		header->m_storage	   = storage;
+		header->m_precision	   = precision;
+		header->m_capacity	   = shape.m_capacity;
+		header->m_planes	   = shape.m_planes;
+		header->m_sample_bytes = shape.m_sample_bytes;
+		header->m_ring_offset  = ring_offset;
+
+		auto ring = std::make_unique<audio_ring>(memory->bytes().subspan(ring_offset), shape.m_capacity, shape.m_planes, shape.m_sample_bytes, true);
+		header->m_magic.store(shared_queue_header::magic_value, std::memory_order_release);
+
+		return std::unique_ptr<shared_audio_queue>(new shared_audio_queue(std::string(name), std::move(*memory), std::move(ring), role, true, quality));
+	}
+
+	/**
+     * @brief Attach to the segment of a queue created by another process (or another object).
+     *
+     * @param name Segment name
+     * @param role Side of this process
+     * @param quality Resampling quality of this side's pushes
+     * @return std::unique_ptr<shared_audio_queue> The queue, nullptr if there is no such queue (or not ready yet),
+     * or if a live process already holds this side
+     */
+	static std::unique_ptr<shared_audio_queue> open(std::string_view name, shared_queue_role role, resample_quality quality = resample_quality::best)
+	{
+		auto memory = shared_memory::open(name);
+		if (!memory)
+			return nullptr;
+
+		const auto* header = valid_header(memory->bytes());
+		if (header == nullptr)
+			return nullptr;
+
+		const auto& side = header->m_endpoints[std::to_underlying(role)];
+		if (side.m_state.load(std::memory_order_acquire) == std::to_underlying(shared_queue_peer::attached) &&
+			detail::process_alive(side.m_process.load(std::memory_order_relaxed)) && side.m_process.load(std::memory_order_relaxed) != detail::current_process())
+			return nullptr;
+
+		auto ring = std::make_unique<audio_ring>(memory->bytes().subspan(header->m_ring_offset), header->m_capacity, header->m_planes, header->m_sample_bytes, false);
+		return std::unique_ptr<shared_audio_queue>(new shared_audio_queue(std::string(name), std::move(*memory), std::move(ring), role, false, quality));
+	}
+
+	/* The queue is used in place by the audio threads of this process */
+	shared_audio_queue(const shared_audio_queue&)			 = delete;
+	shared_audio_queue& operator=(const shared_audio_queue&) = delete;
+
+	/**
+     * @brief Detach : the peer sees this side detached (and is woken if it waits). The creator removes the name.
+     *
+     */
+	~shared_audio_queue()
+	{
+		own().m_state.store(std::to_underlying(shared_queue_peer::detached), std::memory_order_release);
+		m_header->m_data_signal.fetch_add(1, std::memory_order_seq_cst);
+		m_header->m_space_signal.fetch_add(1, std::memory_order_seq_cst);
+		detail::wake_word(m_header->m_data_signal, true);
+		detail::wake_word(m_header->m_space_signal, true);
+
+		if (m_creator)
+			shared_memory::remove(m_name);
+	}
+
+	/**
+     * @brief The queue of this side : pushes and pops of every kind, stats, gain and pan (of this process).
+     *
+     * Pushes and pops made on it directly do not wake the peer : follow them with signal_data() or signal_space().
+     *
+     */
+	[[nodiscard]]
+	audio_queue<AudioType>& queue() { return *m_queue; }
+
+	/**
+     * @brief audio_queue::push_audio(), then signal_data().
+     *
+     */
+	template <typename... Args>
+	bool push_audio(Args&&... args)
+	{
+		const bool pushed = m_queue->push_audio(std::forward<Args>(args)...);
+		signal_data();
+		return pushed;
+	}
+
+	/**
+     * @brief audio_queue::pop_audio(), then signal_space().
+     *
+     */
+	template <typename... Args>
+	bool pop_audio(Args&&... args)
+	{
+		const bool popped = m_queue->pop_audio(std::forward<Args>(args)...);
+		signal_space();
+		return popped;
+	}
+
+	/**
+     * @brief audio_queue::pop_add(), then signal_space().
+     *
+     */
+	std::size_t pop_add(std::span<float> accumulator, float gain = 1.0F)
+	{
+		const std::size_t popped = m_queue->pop_add(accumulator, gain);
+		signal_space();
+		return popped;
+	}
+
+	/**
+     * @brief Frames were pushed : record the activity of this side, wake the consumer if it sleeps.
+     *
+     */
+	void signal_data() { signal(m_header->m_data_signal, m_header->m_data_waiters); }
+
+	/**
+     * @brief Frames were popped : record the activity of this side, wake the producer if it sleeps.
+     *
+     */
+	void signal_space() { signal(m_header->m_space_signal, m_header->m_space_waiters); }
+
+	/**
+     * @brief Sleep until at least a number of frames is ready to pop, the producer is gone, or a timeout.
+     *
+     * @return true The frames are ready
+     */
+	bool wait_for_frames(std::size_t frames, std::chrono::nanoseconds timeout)
+	{
+		return wait(m_header->m_data_signal, m_header->m_data_waiters, timeout, [&] { return m_queue->ready_frames() >= frames; });
+	}
+
+	/**
+     * @brief Sleep until a number of frames can be pushed, the consumer is gone, or a timeout.
+     *
+     * @return true The room is free
+     */
+	bool wait_for_space(std::size_t frames, std::chrono::nanoseconds timeout)
+	{
+		return wait(m_header->m_space_signal, m_header->m_space_waiters, timeout, [&] { return m_queue->free_frames() >= frames; });
+	}
+
+	/**
+     * @brief State of the other side. Checks its process : call it from a control thread, not per period.
+     *
+     */
+	[[nodiscard]]
+	shared_queue_peer peer() const
+	{
+		const auto& other = peer_endpoint();
+		const auto	state = static_cast<shared_queue_peer>(other.m_state.load(std::memory_order_acquire));
+		if (state == shared_queue_peer::attached && !detail::process_alive(other.m_process.load(std::memory_order_relaxed)))
+			return shared_queue_peer::lost;
+		return state;
+	}
+
+	/**
+     * @brief Time since the last push or pop of the other side (through this class), or since it attached.
+     *
+     */
+	[[nodiscard]]
+	std::chrono::nanoseconds peer_idle() const
+	{
+		return std::chrono::nanoseconds(now() - peer_endpoint().m_heartbeat.load(std::memory_order_relaxed));
+	}
+
+	[[nodiscard]] shared_queue_role role() const { return m_role; }
+	[[nodiscard]] const std::string& name() const { return m_name; }
+
+private:
+
+	shared_audio_queue(std::string name, shared_memory memory, std::unique_ptr<audio_ring> ring, shared_queue_role role, bool creator, resample_quality quality)
+		: m_name(std::move(name)),
+		  m_memory(std::move(memory)),
+		  m_header(std::launder(reinterpret_cast<shared_queue_header*>(m_memory.bytes().data()))),
+		  m_role(role),
+		  m_creator(creator),
+		  m_queue(std::make_unique<audio_queue<AudioType>>(audio_ctx{m_header->m_format}, std::move(ring), quality, m_header->m_storage, m_header->m_precision))
+	{
+		own().m_process.store(detail::current_process(), std::memory_order_relaxed);
+		own().m_heartbeat.store(now(), std::memory_order_relaxed);
+		own().m_state.store(std::to_underlying(shared_queue_peer::attached), std::memory_order_release);
+	}
+
+	/**
+     * @brief Header of a segment, nullptr if it is not a queue of this version (or its creator is not done yet).
+     *
+     */
+	static const shared_queue_header* valid_header(std::span<std::byte> bytes)
+	{
+		if (bytes.size() < sizeof(shared_queue_header))
+			return nullptr;
+
+		const auto* header = std::launder(reinterpret_cast<const shared_queue_header*>(bytes.data()));
+		if (header->m_magic.load(std::memory_order_acquire) != shared_queue_header::magic_value || header->m_version != shared_queue_header::version_value ||
+			bytes.size() < header->m_ring_offset + audio_ring::memory_bytes(header->m_capacity, header->m_planes, header->m_sample_bytes))
+			return nullptr;
+		return header;
+	}
+
+	/**
+     * @brief Whether the segment of a name is a queue no live process is attached to (left by crashed processes).
+     *
+     */
+	static bool abandoned(std::string_view name)
+	{
+		const auto memory = shared_memory::open(name);
+		if (!memory)
+			return false;
+
+		const auto* header = valid_header(memory->bytes());
+		if (header == nullptr)
+			return false; // Not a queue, or being created
+		return std::ranges::none_of(header->m_endpoints, [](const auto& side)
+		{
+			return side.m_state.load(std::memory_order_acquire) == std::to_underlying(shared_queue_peer::attached) &&
+				   detail::process_alive(side.m_process.load(std::memory_order_relaxed));
+		});
+	}
+
+	static std::int64_t now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+	[[nodiscard]] shared_queue_header::endpoint& own() { return m_header->m_endpoints[std::to_underlying(m_role)]; }
+	[[nodiscard]] const shared_queue_header::endpoint& peer_endpoint() const { return m_header->m_endpoints[1U - std::to_underlying(m_role)]; }
+
+	/**
+     * @brief Bump a wake-up word, and wake its sleepers if there are any (the only system call, only then).
+     *
+     */
+	void signal(std::atomic<std::uint32_t>& word, const std::atomic<std::uint32_t>& waiters)
+	{
+		own().m_heartbeat.store(now(), std::memory_order_relaxed);
+
+		// Sequentially consistent with wait() : either the waiter sees the new word value, or this sees the waiter.
+		word.fetch_add(1, std::memory_order_seq_cst);
+		if (waiters.load(std::memory_order_seq_cst) != 0)
+			detail::wake_word(word, true);
+	}
+
+	/**
+     * @brief Sleep on a wake-up word until a condition holds, the peer is gone, or a timeout.
+     *
+     */
+	template <typename Ready>
+	bool wait(const std::atomic<std::uint32_t>& word, std::atomic<std::uint32_t>& waiters, std::chrono::nanoseconds timeout, Ready&& ready)
+	{
+		using clock = std::chrono::steady_clock;
+		const auto deadline = clock::now() + timeout;
+
+		waiters.fetch_add(1, std::memory_order_seq_cst);
+		bool satisfied = false;
+		while (true)
+		{
+			// The word is read before the condition : a signal in between changes it, and the futex does not sleep.
+			const std::uint32_t seen = word.load(std::memory_order_seq_cst);
+			if ((satisfied = ready()))
+				break;
+
+			const auto state = static_cast<shared_queue_peer>(peer_endpoint().m_state.load(std::memory_order_acquire));
+			const auto left	 = deadline - clock::now();
+			if (state == shared_queue_peer::detached || left <= clock::duration::zero())
+				break;
+
+			// A dead peer never signals : sleep in slices to notice it.
+			detail::wait_on_word(word, seen, std::min<std::chrono::nanoseconds>(left, peer_check_interval), true);
+			if (state == shared_queue_peer::attached && !detail::process_alive(peer_endpoint().m_process.load(std::memory_order_relaxed)))
+			{
+				satisfied = ready();
+				break;
+			}
+		}
+		waiters.fetch_sub(1, std::memory_order_seq_cst);
+		return satisfied;
+	}
+
+	static constexpr std::chrono::milliseconds peer_check_interval{100}; // Longest sleep of a wait between two peer liveness checks
+
+	std::string						 m_name;
+	shared_memory					 m_memory;
+	shared_queue_header*			 m_header; // In m_memory
+	shared_queue_role				 m_role;
+	bool							 m_creator; // Removes the name on close
+	std::unique_ptr<audio_queue<AudioType>> m_queue; // Over the ring in m_memory
+};
@@ -0,0 +1,140 @@
+/**
+ * @file wait_point.h
+ * @author  HUANG He (he.hu4ng@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-11-28
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace detail
+{
+	/**
+     * @brief Sleep while a 32-bit word holds a value, up to a timeout (may return early).
+     *
+     * A futex on Linux (process-shared for a word in shared memory), WaitOnAddress on Windows (one process only),
+     * a short sleep elsewhere. std::atomic::wait has no timeout.
+     *
+     */
+	void wait_on_word(const std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::nanoseconds timeout, bool process_shared = false);
+
+	/**
+     * @brief Wake every thread sleeping in wait_on_word() on a word.
+     *
+     */
+	void wake_word(const std::atomic<std::uint32_t>& word, bool process_shared = false);
+} // namespace detail
+
+/**
+ * @brief Where threads wait for a level of a queue (frames ready, frames free), and where its writers signal it.
+ *
+ * Waiters register the level they need. A writer signals only when a waiter exists and the level reached meets
+ * the lowest registered one : a waiter for a period is woken once, not on every push. Without waiter, notify()
+ * is one fence and one relaxed load, fine on a real-time thread. Waiters sleep on a 32-bit epoch word.
+ *
+ * A listener word (a wait service sleeping for many queues) is bumped and woken along with the epoch.
+ *
+ */
+class wait_point
+{
+public:
+
+	/**
+     * @brief After a write : wake the waiters if the level now meets theirs.
+     *
+     * @param level std::size_t() Level reached, only evaluated if someone waits
+     */
+	template <typename Level>
+	void notify(Level&& level)
+	{
+		// Pairs with enter() : either the waiter sees the write before sleeping, or this sees the waiter.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const std::uint64_t waiters = m_waiters.load(std::memory_order_relaxed);
+		if (waiters != 0 && level() >= (waiters & level_mask))
+			signal();
+	}
+
+	/**
+     * @brief Wake every waiter, whatever its level (the levels changed meaning, e.g. a new capacity).
+     *
+     */
+	void signal();
+
+	/**
+     * @brief Sleep until ready() holds, or a timeout.
+     *
+     * @param level Level ready() waits for, writers signal from it on
+     * @param ready bool() The condition, checked after each wake-up
+     * @return true The condition holds
+     */
+	template <typename Ready>
+	bool wait(std::size_t level, std::chrono::nanoseconds timeout, Ready&& ready)
+	{
+		if (ready())
+			return true;
+
+		using clock			= std::chrono::steady_clock;
+		const auto deadline = clock::now() + timeout;
+
+		enter(level);
+		bool satisfied = false;
+		while (true)
+		{
+			// The epoch is read before the condition : a signal in between changes it, and the sleep returns at once.
+			const std::uint32_t seen = m_epoch.load(std::memory_order_acquire);
+			if ((satisfied = ready()))
+				break;
+
+			const auto left = deadline - clock::now();
+			if (left <= clock::duration::zero())
+				break;
+			detail::wait_on_word(m_epoch, seen, left);
+		}
+		leave();
+		return satisfied;
+	}
+
+	/**
+     * @brief Register a waiter of a level, before checking its condition a last time and sleeping.
+     *
+     */
+	void enter(std::size_t level);
+
+	/**
+     * @brief Unregister a waiter. The lowest level stays until the last waiter leaves : at worst an extra wake-up.
+     *
+     */
+	void leave();
+
+	/**
+     * @brief Word bumped and woken by signal(), besides the epoch. One listener at a time.
+     *
+     */
+	void listen(std::atomic<std::uint32_t>* word) { m_listener.store(word, std::memory_order_seq_cst); }
+
+	/**
+     * @brief Stop signalling a listener word, if still installed : once this returns, no signal() touches it.
+     *
+     */
+	void unlisten(std::atomic<std::uint32_t>* word);
+
+private:
+
+	// Waiter count in the high bits, lowest waited level in the low bits
+	static constexpr unsigned		   count_shift = 48;
+	static constexpr std::uint64_t	   level_mask  = (std::uint64_t{1} << count_shift) - 1;
+
+	std::atomic<std::uint64_t>				   m_waiters{0};
+	std::atomic<std::uint32_t>				   m_epoch{0};
+	std::atomic<std::atomic<std::uint32_t>*> m_listener{nullptr};
+	std::atomic<std::uint32_t>				   m_signalling{0}; // signal() calls that may hold the listener
+};
@@ -0,0 +1,92 @@
+#include <algorithm>
+
+#include "audio_wait_service.h"
+
+audio_wait_service::~audio_wait_service()
+{
+    // No signal() of a queue still alive touches m_signal afterwards.
+    for (wait_point* point : m_points)
+        point->unlisten(&m_signal);
+}
+
+auto
+audio_wait_service::suspend(awaiter& wait)
+-> void
+{
+    {
+        // Listener and level first : a push from now on signals this service, the next run_once() sees the earlier ones.
+        // Under the lock : run_once() detaches a point only when no pending wait uses it.
+        const std::scoped_lock lock(m_lock);
+        wait.m_point->listen(&m_signal);
+        wait.m_point->enter(wait.m_level);
+        if (std::ranges::find(m_points, wait.m_point) == m_points.end())
+            m_points.push_back(wait.m_point);
+        m_pending.push_back(&wait);
+    }
+    wake();
+}
+
+auto
+audio_wait_service::run_once(const std::chrono::nanoseconds max_wait)
+-> std::size_t
+{
+    using clock = std::chrono::steady_clock;
+
+    // The word is read before the conditions : a signal in between changes it, and the sleep returns at once.
+    const std::uint32_t seen    = m_signal.load(std::memory_order_acquire);
+    const auto          now     = clock::now();
+    auto                nearest = now + max_wait;
+
+    m_resumable.clear();
+    {
+        const std::scoped_lock lock(m_lock);
+        std::erase_if(m_pending, [&](awaiter* wait)
+        {
+            wait->m_satisfied = wait->m_ready(wait->m_queue, wait->m_level);
+            if (wait->m_satisfied || wait->m_deadline <= now)
+            {
+                m_resumable.push_back(wait);
+                return true;
+            }
+            nearest = std::min(nearest, wait->m_deadline);
+            return false;
+        });
+
+        // Points left without a pending wait stop signalling this service : it may be destroyed before their queue.
+        for (const awaiter* resumable : m_resumable)
+        {
+            wait_point* point = resumable->m_point;
+            if (std::ranges::none_of(m_pending, [&](const awaiter* wait) { return wait->m_point == point; }) && std::erase(m_points, point) != 0)
+                point->unlisten(&m_signal);
+        }
+    }
+
+    // Outside the lock : resumed coroutines may wait again.
+    const std::size_t resumed = m_resumable.size();
+    for (std::size_t index = 0; index < resumed; ++index)
+    {
+        awaiter* wait = m_resumable[index];
+        wait->m_point->leave();
+        wait->m_handle.resume();
+    }
+
+    if (resumed == 0)
+        detail::wait_on_word(m_signal, seen, nearest - clock::now());
+    return resumed;
+}
+
+auto
+audio_wait_service::wake()
+-> void
+{
+    m_signal.fetch_add(1, std::memory_order_release);
+    detail::wake_word(m_signal);
+}
+
+auto
+audio_wait_service::pending() const
+-> std::size_t
+{
+    const std::scoped_lock lock(m_lock);
+    return m_pending.size();
+}
@@ -0,0 +1,72 @@
+#include <print>
+
+#include "deferred_log.h"
+
+deferred_log::deferred_log()
+{
+    for (std::size_t position = 0; position < capacity; ++position)
+        m_slots[position].m_sequence.store(position, std::memory_order_relaxed);
+}
+
+auto
+deferred_log::instance()
+-> deferred_log&
+{
+    static deferred_log log;
+    return log;
+}
+
+auto
+deferred_log::post(const log_record& record)
+-> bool
+{
+    std::size_t position = m_write.load(std::memory_order_relaxed);
+    while (true)
+    {
+        auto&             slot     = m_slots[position % capacity];
+        const std::size_t sequence = slot.m_sequence.load(std::memory_order_acquire);
+
+        if (sequence == position)
+        {
+            // Free slot : claim the position, the loser of a race retries with the position it reloads.
+            if (m_write.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                slot.m_record = record;
+                slot.m_sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (sequence < position)
+        {
+            // Not read yet since the last lap : full.
+            m_lost.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+            position = m_write.load(std::memory_order_relaxed);
+    }
+}
+
+auto
+deferred_log::flush(std::FILE* stream)
+-> std::size_t
+{
+    const std::size_t printed = drain([stream](const log_record& record)
+    {
+        if (record.m_detail && record.m_has_value)
+            std::println(stream, "{} : {} ({})", record.m_message, record.m_detail, record.m_value);
+        else if (record.m_detail)
+            std::println(stream, "{} : {}", record.m_message, record.m_detail);
+        else if (record.m_has_value)
+            std::println(stream, "{} ({})", record.m_message, record.m_value);
+        else
+            std::println(stream, "{}", record.m_message);
+    });
+
+    if (const std::uint64_t lost = m_lost.load(std::memory_order_relaxed); lost != m_lost_reported)
+    {
+        std::println(stream, "deferred_log : {} records lost (queue full)", lost - m_lost_reported);
+        m_lost_reported = lost;
+    }
+    return printed;
+}
@@ -0,0 +1,33 @@
+#include <algorithm>
+
+#include "drift_control.h"
+
+drift_controller::drift_controller(const drift_compensation& settings)
+    : m_target(std::chrono::duration<double>(settings.m_target_latency).count()),
+      m_max_correction(settings.m_max_correction_ppm * 1e-6),
+      // Error dynamics e'' + kp e' + ki e = 0 : critically damped with ki = kp^2 / 4.
+      m_proportional(1.0 / std::max(std::chrono::duration<double>(settings.m_response).count(), 1e-3)),
+      m_integral_gain(m_proportional * m_proportional / 4.0),
+      // Well inside the loop time constant : little phase lag.
+      m_smoothing(1.0 / (8.0 * m_proportional))
+{}
+
+double
+drift_controller::update(const double fill_seconds, const double elapsed_seconds)
+{
+    if (!m_primed)
+    {
+        m_fill   = fill_seconds;
+        m_primed = true;
+    }
+    else
+        m_fill += std::min(1.0, elapsed_seconds / m_smoothing) * (fill_seconds - m_fill);
+
+    // Fuller than the target : the producer runs fast, generate fewer frames.
+    const double error = m_fill - m_target;
+
+    // Anti-windup : the integral alone never asks for more than the largest correction.
+    m_integral   = std::clamp(m_integral + (m_integral_gain * error * elapsed_seconds), -m_max_correction, m_max_correction);
+    m_correction = std::clamp(-((m_proportional * error) + m_integral), -m_max_correction, m_max_correction);
+    return m_correction;
+}
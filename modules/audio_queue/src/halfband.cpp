@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <numeric>
+
+#include "halfband.h"
+
+namespace
+{
+    // Modified Bessel function of the first kind, order 0 (power series).
+    double bessel_i0(const double x)
+    {
+        double sum  = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 64 && term > sum * 1e-12; ++k)
+        {
+            const double half = x / (2.0 * k);
+            term *= half * half;
+            sum += term;
+        }
+        return sum;
+    }
+} // namespace
+
+halfband::halfband(const uint8_t channels, const direction dir, const std::size_t half_taps, const double beta)
+    : m_channels(channels),
+      m_direction(dir),
+      m_coef(std::max<std::size_t>((half_taps + 1) / 2 * 2, 2)), // Even : the centre tap falls in the other phase
+      // Up : one delay line input frame per non-zero tap. Down : the whole filter length.
+      m_length(dir == direction::up ? m_coef.size() : (2 * m_coef.size()) - 1),
+      m_history(static_cast<std::size_t>(channels) * 2 * m_length, 0.0F)
+{
+    // Prototype of length 2 x half_taps - 1 at the higher rate, centred on half_taps - 1.
+    // Non-zero taps sit at odd distances from the centre, the centre tap itself is exactly 1/2.
+    const auto   length = static_cast<double>((2 * m_coef.size()) - 1);
+    const double centre = (length - 1.0) / 2.0;
+    const double norm   = bessel_i0(beta);
+
+    for (std::size_t tap = 0; tap < m_coef.size(); ++tap)
+    {
+        const double offset = (2.0 * static_cast<double>(tap)) - centre; // Odd offset
+        const double ratio  = offset / (centre + 1.0);
+        const double window = bessel_i0(beta * std::sqrt(std::max(0.0, 1.0 - (ratio * ratio)))) / norm;
+        const double sinc   = std::sin(std::numbers::pi * offset / 2.0) / (std::numbers::pi * offset);
+        m_coef[tap]         = static_cast<float>(sinc * window);
+    }
+
+    // Unity gain at DC : the filtering phase sums to 1/2, like the centre tap.
+    const float sum = std::accumulate(m_coef.begin(), m_coef.end(), 0.0F);
+    const float scale = (dir == direction::up ? 1.0F : 0.5F) / sum;
+    for (auto& coef : m_coef)
+        coef *= scale;
+}
+
+auto
+halfband::process(const float* input, const std::size_t input_frames, float* output, const std::size_t output_frames)
+-> result
+{
+    result done;
+    const std::size_t half = m_coef.size();
+
+    while (done.frames_used < input_frames)
+    {
+        const float* frame = input + (done.frames_used * m_channels);
+
+        if (m_direction == direction::up)
+        {
+            // One input frame gives two output frames : filtered phase, then the delayed centre tap.
+            if (output_frames - done.frames_generated < 2)
+                break;
+
+            push_frame(frame);
+            float* even = output + (done.frames_generated * m_channels);
+            float* odd  = even + m_channels;
+            for (std::size_t channel = 0; channel < m_channels; ++channel)
+            {
+                const float* line = window(channel);
+                even[channel]     = std::inner_product(line, line + half, m_coef.data(), 0.0F);
+                odd[channel]      = line[half / 2];
+            }
+            done.frames_generated += 2;
+        }
+        else
+        {
+            // Two input frames give one output frame, produced on the even one.
+            if (!m_odd && done.frames_generated == output_frames)
+                break;
+
+            push_frame(frame);
+            if (!m_odd)
+            {
+                float* out = output + (done.frames_generated * m_channels);
+                for (std::size_t channel = 0; channel < m_channels; ++channel)
+                {
+                    const float* line = window(channel);
+                    float        sum  = 0.5F * line[half - 1];
+                    for (std::size_t tap = 0; tap < half; ++tap)
+                        sum += m_coef[tap] * line[2 * tap];
+                    out[channel] = sum;
+                }
+                ++done.frames_generated;
+            }
+            m_odd = !m_odd;
+        }
+
+        m_primed = true;
+        ++done.frames_used;
+    }
+
+    return done;
+}
+
+auto
+halfband::flush(float* output, const std::size_t output_frames)
+-> std::size_t
+{
+    if (!m_primed)
+        return 0;
+
+    // Feed the zero frames pushing the group delay (half_taps - 1 samples at the higher rate) out, by small blocks.
+    if (m_draining == 0)
+        m_draining = m_direction == direction::up ? m_coef.size() / 2 : m_coef.size();
+
+    constexpr std::size_t zero_block = 16;
+    static constexpr std::array<float, zero_block * 8> zeros{};
+
+    std::size_t generated = 0;
+    while (m_draining != 0 && generated < output_frames)
+    {
+        const std::size_t fed = std::min({m_draining, zero_block, zeros.size() / std::max<std::size_t>(m_channels, 1)});
+        const auto		  step = process(zeros.data(), fed, output + (generated * m_channels), output_frames - generated);
+        if (step.frames_used == 0)
+            break;
+
+        m_draining -= step.frames_used;
+        generated += step.frames_generated;
+    }
+
+    // Tail fully drained : start a new stream.
+    if (m_draining == 0)
+        reset();
+
+    return generated;
+}
+
+auto
+halfband::reset()
+-> void
+{
+    std::ranges::fill(m_history, 0.0F);
+    m_position = 0;
+    m_odd      = false;
+    m_primed   = false;
+    m_draining = 0;
+}
+
+auto
+halfband::push_frame(const float* frame)
+-> void
+{
+    // Overwrite the oldest frame in both copies, the window then starts one frame later.
+    for (std::size_t channel = 0; channel < m_channels; ++channel)
+    {
+        float* line                 = &m_history[channel * 2 * m_length];
+        line[m_position]            = frame[channel];
+        line[m_position + m_length] = frame[channel];
+    }
+    m_position = (m_position + 1) % m_length;
+}
@@ -0,0 +1,129 @@
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+#include "mix_control.h"
+
+namespace
+{
+    // Side of a channel for panning : -1 left, 1 right, 0 not panned (mono, centre, LFE).
+    int pan_side(const channel_layout layout, const std::size_t channel)
+    {
+        if (layout == channel_layout::Mono)
+            return 0;
+
+        switch (channel)
+        {
+        case 0: case 4: case 6: return -1; // L, Ls, Lb
+        case 1: case 5: case 7: return 1;  // R, Rs, Rb
+        default:                return 0;  // C, LFE
+        }
+    }
+
+    // Constant power pan law, unity at the centre.
+    float pan_gain(const int side, const float pan)
+    {
+        if (side == 0)
+            return 1.0F;
+
+        const double angle = (static_cast<double>(pan) + 1.0) * std::numbers::pi / 4.0;
+        return static_cast<float>(std::numbers::sqrt2 * (side < 0 ? std::cos(angle) : std::sin(angle)));
+    }
+} // namespace
+
+mix_control::mix_control(const channel_layout layout)
+    : m_gain_target(pack(1.0F, 0)),
+      m_pan_target(pack(0.0F, 0)),
+      m_layout(layout),
+      m_gain_seen(m_gain_target.load(std::memory_order_relaxed)),
+      m_pan_seen(m_pan_target.load(std::memory_order_relaxed))
+{
+    m_state.m_channels = layout;
+    m_state.m_pan.fill(1.0F);
+    m_state.m_steady.fill(1.0F);
+}
+
+auto
+mix_control::pack(const float value, const std::size_t ramp_frames)
+-> std::uint64_t
+{
+    const auto frames = static_cast<std::uint32_t>(std::min<std::size_t>(ramp_frames, std::numeric_limits<std::uint32_t>::max()));
+    return (static_cast<std::uint64_t>(frames) << 32U) | std::bit_cast<std::uint32_t>(value);
+}
+
+auto
+mix_control::unpack(const std::uint64_t packed)
+-> float
+{
+    return std::bit_cast<float>(static_cast<std::uint32_t>(packed));
+}
+
+auto
+mix_control::begin()
+-> mix_gains
+{
+    auto& state = m_state;
+
+    // New gain target : ramp from where the gain is now.
+    if (const auto target = m_gain_target.load(std::memory_order_relaxed); target != m_gain_seen)
+    {
+        m_gain_seen           = target;
+        const auto frames     = static_cast<std::size_t>(target >> 32U);
+        const float goal      = unpack(target);
+        state.m_gain_step     = frames != 0 ? (goal - state.m_gain) / static_cast<float>(frames) : 0.0F;
+        state.m_gain_frames   = frames;
+        if (frames == 0)
+            state.m_gain = goal;
+    }
+
+    if (const auto target = m_pan_target.load(std::memory_order_relaxed); target != m_pan_seen)
+    {
+        m_pan_seen        = target;
+        const auto frames = static_cast<std::size_t>(target >> 32U);
+        for (std::size_t channel = 0; channel < state.m_channels; ++channel)
+        {
+            const float goal          = pan_gain(pan_side(m_layout, channel), unpack(target));
+            state.m_pan_step[channel] = frames != 0 ? (goal - state.m_pan[channel]) / static_cast<float>(frames) : 0.0F;
+            if (frames == 0)
+                state.m_pan[channel] = goal;
+        }
+        state.m_pan_frames = frames;
+    }
+
+    // Coefficients once both ramps are over : exactly their targets.
+    const float gain = state.m_gain + (state.m_gain_step * static_cast<float>(state.m_gain_frames));
+    for (std::size_t channel = 0; channel < state.m_channels; ++channel)
+        state.m_steady[channel] = gain * (state.m_pan[channel] + (state.m_pan_step[channel] * static_cast<float>(state.m_pan_frames)));
+
+    state.m_uniform = std::all_of(state.m_steady.begin(), state.m_steady.begin() + static_cast<std::ptrdiff_t>(state.m_channels),
+                                  [&](float steady) { return steady == state.m_steady[0]; });
+    return state;
+}
+
+void
+mix_control::end(const std::size_t frames)
+{
+    auto& state = m_state;
+
+    const std::size_t gain_moved = std::min(frames, state.m_gain_frames);
+    state.m_gain += state.m_gain_step * static_cast<float>(gain_moved);
+    state.m_gain_frames -= gain_moved;
+    if (state.m_gain_frames == 0)
+    {
+        state.m_gain      = unpack(m_gain_seen); // No rounding drift once the ramp is over
+        state.m_gain_step = 0.0F;
+    }
+
+    const std::size_t pan_moved = std::min(frames, state.m_pan_frames);
+    for (std::size_t channel = 0; channel < state.m_channels; ++channel)
+    {
+        state.m_pan[channel] += state.m_pan_step[channel] * static_cast<float>(pan_moved);
+        if (state.m_pan_frames == pan_moved)
+        {
+            state.m_pan[channel]      = pan_gain(pan_side(m_layout, channel), unpack(m_pan_seen));
+            state.m_pan_step[channel] = 0.0F;
+        }
+    }
+    state.m_pan_frames -= pan_moved;
+}
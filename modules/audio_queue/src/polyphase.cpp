@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <numbers>
+#include <numeric>
+#include <tuple>
+#include <utility>
+
+#include "polyphase.h"
+#include "sample_convert.h"
+
+namespace
+{
+    /**
+     * @brief Windowed sinc design of a quality tier : taps per phase (when upsampling), Kaiser beta and cutoff.
+     *
+     */
+    struct sinc_design
+    {
+        std::size_t taps;
+        double      beta;
+        double      rolloff; // Cutoff, relative to the lower Nyquist frequency
+    };
+
+    sinc_design design_for(const resample_quality quality)
+    {
+        switch (quality)
+        {
+        case resample_quality::medium:  return {.taps = 32, .beta = 8.0, .rolloff = 0.92};
+        case resample_quality::fastest: return {.taps = 16, .beta = 6.0, .rolloff = 0.85};
+        default:                        return {.taps = 64, .beta = 10.0, .rolloff = 0.95};
+        }
+    }
+
+    // Modified Bessel function of the first kind, order 0 (power series).
+    double bessel_i0(const double x)
+    {
+        double sum  = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 64 && term > sum * 1e-12; ++k)
+        {
+            const double half = x / (2.0 * k);
+            term *= half * half;
+            sum += term;
+        }
+        return sum;
+    }
+
+    double sinc(const double x)
+    {
+        return x == 0.0 ? 1.0 : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+    }
+} // namespace
+
+polyphase_filter::polyphase_filter(const std::uint32_t input_rate, const std::uint32_t output_rate, const resample_quality quality)
+    : m_up(output_rate / std::gcd(input_rate, output_rate)),
+      m_down(input_rate / std::gcd(input_rate, output_rate)),
+      m_taps(1)
+{
+    // Tap q of a phase p reads the input frame at distance taps - q + p / up before the output position :
+    // every phase of the prototype is sampled at offsets (distance - delay).
+    const auto distance = [&](std::size_t phase, std::size_t tap) { return static_cast<double>(m_taps - tap) + (static_cast<double>(phase) / static_cast<double>(m_up)); };
+
+    std::function<double(double)> prototype;
+    double                        delay = 0.0;
+
+    switch (quality)
+    {
+    case resample_quality::zero_order_hold:
+        prototype = [](double) { return 1.0; };
+        break;
+
+    case resample_quality::linear:
+        m_taps    = 2;
+        delay     = 2.0;
+        prototype = [](double offset) { return std::max(0.0, 1.0 - std::abs(offset)); };
+        break;
+
+    default:
+    {
+        // Downsampling widens the filter in input frames, to keep its length at the output rate.
+        const auto   design = design_for(quality);
+        const double ratio  = std::min(1.0, static_cast<double>(m_up) / static_cast<double>(m_down));
+        m_taps              = ((static_cast<std::size_t>(std::ceil(static_cast<double>(design.taps) / ratio)) + 1) / 2) * 2;
+
+        const double cutoff = design.rolloff * ratio;
+        const double width  = (static_cast<double>(m_taps) / 2.0) + 0.5;
+        const double norm   = bessel_i0(design.beta);
+        delay               = width;
+        prototype           = [=](double offset)
+        {
+            const double x = offset / width;
+            return cutoff * sinc(cutoff * offset) * bessel_i0(design.beta * std::sqrt(std::max(0.0, 1.0 - (x * x)))) / norm;
+        };
+        break;
+    }
+    }
+
+    m_coefficients.resize(m_up * m_taps);
+    for (std::size_t phase = 0; phase < m_up; ++phase)
+    {
+        float* taps = &m_coefficients[phase * m_taps];
+        double sum  = 0.0;
+        for (std::size_t tap = 0; tap < m_taps; ++tap)
+        {
+            const double value = prototype(distance(phase, tap) - delay);
+            taps[tap]          = static_cast<float>(value);
+            sum += value;
+        }
+
+        for (std::size_t tap = 0; tap < m_taps; ++tap)
+            taps[tap] = static_cast<float>(static_cast<double>(taps[tap]) / sum);
+    }
+}
+
+auto
+polyphase_filter::shared(const std::uint32_t input_rate, const std::uint32_t output_rate, const resample_quality quality)
+-> std::shared_ptr<const polyphase_filter>
+{
+    using key = std::tuple<std::uint32_t, std::uint32_t, resample_quality>;
+
+    static std::mutex                                              registry_lock;
+    static std::map<key, std::weak_ptr<const polyphase_filter>> registry;
+
+    const std::scoped_lock lock(registry_lock);
+    auto&                  entry = registry[key{input_rate, output_rate, quality}];
+    if (auto filter = entry.lock())
+        return filter;
+
+    auto filter = std::make_shared<const polyphase_filter>(input_rate, output_rate, quality);
+    entry       = filter;
+    return filter;
+}
+
+batch_resampler::batch_resampler(std::shared_ptr<const polyphase_filter> filter, const std::size_t lanes, const std::size_t max_output_frames)
+    : m_filter(std::move(filter)),
+      m_lanes(std::max<std::size_t>((lanes + lane_tile - 1) / lane_tile, 1) * lane_tile),
+      m_max_output_frames(max_output_frames),
+      m_history((m_filter->taps() + ((m_filter->up() - 1 + (max_output_frames * m_filter->down())) / m_filter->up())) * m_lanes, 0.0F),
+      m_output(max_output_frames * m_lanes, 0.0F)
+{}
+
+auto
+batch_resampler::input_frames_for(const std::size_t output_frames) const
+-> std::size_t
+{
+    return (m_phase + (output_frames * m_filter->down())) / m_filter->up();
+}
+
+auto
+batch_resampler::process(const std::size_t output_frames, const std::size_t first_lane, const std::size_t lane_count)
+-> void
+{
+    const std::size_t up    = m_filter->up();
+    const std::size_t down  = m_filter->down();
+    const std::size_t taps  = m_filter->taps();
+    const std::size_t width = std::min(((lane_count + lane_tile - 1) / lane_tile) * lane_tile, m_lanes - first_lane); // Whole tiles
+
+    // Rows [end - taps, end) of the block are the window of an output frame, end being the first input frame after it.
+    for (std::size_t frame = 0; frame < output_frames; ++frame)
+    {
+        const std::size_t position = m_phase + (frame * down);
+        detail::fir_lanes(m_filter->phase(position % up), taps, &m_history[((position / up) * m_lanes) + first_lane], m_lanes,
+                          &m_output[(frame * m_lanes) + first_lane], width);
+    }
+
+    // The last taps input rows become the history of the next block (rows move down : forward copy is safe).
+    const std::size_t consumed = input_frames_for(output_frames);
+    if (consumed == 0)
+        return;
+
+    for (std::size_t row = 0; row < taps; ++row)
+        std::memmove(&m_history[(row * m_lanes) + first_lane], &m_history[((row + consumed) * m_lanes) + first_lane], width * sizeof(float));
+}
+
+auto
+batch_resampler::advance(const std::size_t output_frames)
+-> void
+{
+    m_phase = (m_phase + (output_frames * m_filter->down())) % m_filter->up();
+}
+
+auto
+batch_resampler::clear_lane(const std::size_t lane)
+-> void
+{
+    for (std::size_t row = 0; row < m_filter->taps(); ++row)
+        m_history[(row * m_lanes) + lane] = 0.0F;
+}
@@ -0,0 +1,170 @@
+#include <cmath>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+#include "deferred_log.h"
+#include "resampler.h"
+
+namespace
+{
+    /**
+     * @brief Halfband design of a sinc tier : non-zero taps of the filtering phase and Kaiser beta.
+     *
+     */
+    struct halfband_design
+    {
+        std::size_t half_taps;
+        double      beta;
+    };
+
+    std::optional<halfband_design> halfband_for(const resample_quality quality)
+    {
+        switch (quality)
+        {
+        case resample_quality::best:    return halfband_design{.half_taps = 64, .beta = 12.0};
+        case resample_quality::medium:  return halfband_design{.half_taps = 32, .beta = 9.0};
+        case resample_quality::fastest: return halfband_design{.half_taps = 12, .beta = 6.0};
+        default:                        return std::nullopt; // Cheaper converters are cheaper than any filter
+        }
+    }
+
+    int converter_for(const resample_quality quality)
+    {
+        switch (quality)
+        {
+        case resample_quality::medium:          return SRC_SINC_MEDIUM_QUALITY;
+        case resample_quality::fastest:         return SRC_SINC_FASTEST;
+        case resample_quality::zero_order_hold: return SRC_ZERO_ORDER_HOLD;
+        case resample_quality::linear:          return SRC_LINEAR;
+        default:                                return SRC_SINC_BEST_QUALITY;
+        }
+    }
+} // namespace
+
+resampler::resampler(const uint8_t channels, const double ratio, const resample_quality quality, const bool variable_ratio)
+    : m_channels(channels), m_ratio(ratio)
+{
+    // Exact 2x ratios : polyphase halfband fast path.
+    if (const auto design = halfband_for(quality); design && !variable_ratio && (ratio == 2.0 || ratio == 0.5))
+    {
+        m_halfband.emplace(channels, ratio == 2.0 ? halfband::direction::up : halfband::direction::down, design->half_taps, design->beta);
+        return;
+    }
+
+    int err_code = 0;
+    m_state = src_new(converter_for(quality), channels, &err_code);
+    if (!m_state || err_code != 0)
+        throw std::runtime_error(std::format("libsamplerate error : {}", src_strerror(err_code)));
+}
+
+resampler::resampler(resampler&& other) noexcept
+    : m_state(std::exchange(other.m_state, nullptr)),
+      m_halfband(std::move(other.m_halfband)),
+      m_channels(other.m_channels),
+      m_ratio(other.m_ratio)
+{}
+
+auto
+resampler::operator=(resampler&& other) noexcept
+-> resampler&
+{
+    if (this != &other)
+    {
+        if (m_state)
+            src_delete(m_state);
+
+        m_state    = std::exchange(other.m_state, nullptr);
+        m_halfband = std::move(other.m_halfband);
+        m_channels = other.m_channels;
+        m_ratio    = other.m_ratio;
+    }
+    return *this;
+}
+
+resampler::~resampler()
+{
+    if (m_state)
+        src_delete(m_state);
+}
+
+auto
+resampler::process(const float* input, const std::size_t input_frames, float* output, const std::size_t output_frames)
+-> std::optional<result>
+{
+    if (m_halfband)
+    {
+        const auto done = m_halfband->process(input, input_frames, output, output_frames);
+        return result{.frames_used = done.frames_used, .frames_generated = done.frames_generated};
+    }
+
+    SRC_DATA src_data{};
+    src_data.end_of_input  = 0;
+    src_data.data_in       = input;
+    src_data.data_out      = output;
+    src_data.input_frames  = static_cast<long>(input_frames);
+    src_data.output_frames = static_cast<long>(output_frames);
+    src_data.src_ratio     = m_ratio;
+
+    if (const int err_code = src_process(m_state, &src_data); err_code != 0)
+    {
+        log_deferred("libsamplerate error", src_strerror(err_code));
+        return std::nullopt;
+    }
+
+    return result
+    {
+        .frames_used      = static_cast<std::size_t>(src_data.input_frames_used),
+        .frames_generated = static_cast<std::size_t>(src_data.output_frames_gen)
+    };
+}
+
+auto
+resampler::flush(float* output, const std::size_t output_frames)
+-> std::optional<std::size_t>
+{
+    if (m_halfband)
+        return m_halfband->flush(output, output_frames);
+
+    // libsamplerate wants a valid pointer even for an empty input block.
+    constexpr float no_input = 0.0F;
+
+    SRC_DATA src_data{};
+    src_data.end_of_input  = 1;
+    src_data.data_in       = &no_input;
+    src_data.data_out      = output;
+    src_data.input_frames  = 0;
+    src_data.output_frames = static_cast<long>(output_frames);
+    src_data.src_ratio     = m_ratio;
+
+    if (const int err_code = src_process(m_state, &src_data); err_code != 0)
+    {
+        log_deferred("libsamplerate error", src_strerror(err_code));
+        reset();
+        return std::nullopt;
+    }
+
+    const auto generated = static_cast<std::size_t>(src_data.output_frames_gen);
+
+    // Tail fully drained : the state must be reset before accepting a new stream.
+    if (generated < output_frames)
+        reset();
+
+    return generated;
+}
+
+void
+resampler::reset()
+{
+    if (m_halfband)
+        m_halfband->reset();
+    else
+        src_reset(m_state);
+}
+
+auto
+resampler::max_output_frames(const std::size_t input_frames) const
+-> std::size_t
+{
+    return static_cast<std::size_t>(std::ceil(static_cast<double>(input_frames) * m_ratio)) + 1;
+}
@@ -0,0 +1,790 @@
+#include <array>
+#include <cmath>
+
+#include "sample_convert.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+    #define AUDIO_CONVERT_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define AUDIO_CONVERT_AVX2_TARGET
+    #else
+        #define AUDIO_CONVERT_AVX2_TARGET __attribute__((target("avx2")))
+    #endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    #define AUDIO_CONVERT_NEON 1
+    #include <arm_neon.h>
+#endif
+
+namespace
+{
+    /*
+     * Constants shared with make_audio_converters. Scaling by a power of two is exact,
+     * so the signed kernels multiply by the reciprocal and still match the division
+     * of the scalar converters bit for bit. The uint8 half range is not a power of two :
+     * its kernels keep the division.
+     */
+    constexpr float int16_scale     = 32768.0F;
+    constexpr float int32_scale     = 2147483648.0F;
+    constexpr float int24_scale     = 8388608.0F;
+    constexpr int32_t int24_max     = 8388607;
+    constexpr float uint8_half      = 127.5F;
+    constexpr float uint8_offset    = 128.0F;
+    constexpr float max_float       = 1.0F;
+
+    // ----------------- Scalar : reference and tails -----------------
+
+    template <audio_sample_type AudioType>
+    void to_float_scalar(const AudioType* input, float* output, std::size_t count)
+    {
+        auto [to_float, _] = make_audio_converters<AudioType>();
+        for (std::size_t i = 0; i < count; ++i)
+            output[i] = to_float(input[i]);
+    }
+
+    template <audio_sample_type AudioType>
+    void from_float_scalar(const float* input, AudioType* output, std::size_t count)
+    {
+        auto [_, from_float] = make_audio_converters<AudioType>();
+        for (std::size_t i = 0; i < count; ++i)
+            output[i] = from_float(input[i]);
+    }
+
+    /*
+     * Soft knee, branch free : |y| = min(|x|, knee) + r * e / (r + e), e = max(|x| - knee, 0), r = 1 - knee.
+     * Below the knee e is 0 and y is x exactly. The vector kernels run the same operations in the same order.
+     */
+    void soft_limit_scalar(float* samples, std::size_t count, float knee)
+    {
+        const float range = max_float - knee;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const float magnitude = std::fabs(samples[i]);
+            const float excess    = std::max(magnitude - knee, 0.0F);
+            samples[i]            = std::copysign(std::min(magnitude, knee) + ((range * excess) / (range + excess)), samples[i]);
+        }
+    }
+
+    /*
+     * FIR across lanes : output[lane] = sum over taps of coefficients[tap] x window[tap x stride + lane].
+     * Every kernel adds the taps in order with a separate multiply and add (no FMA) : lanes match bit for bit
+     * whatever the instruction set.
+     */
+    constexpr std::size_t fir_tile = 16;
+
+    void fir_lanes_scalar(const float* coefficients, std::size_t taps, const float* window, std::size_t stride, float* output, std::size_t lanes)
+    {
+        std::size_t lane = 0;
+        for (; lane + fir_tile <= lanes; lane += fir_tile)
+        {
+            std::array<float, fir_tile> sum{};
+            for (std::size_t tap = 0; tap < taps; ++tap)
+                for (std::size_t i = 0; i < fir_tile; ++i)
+                    sum[i] += coefficients[tap] * window[(tap * stride) + lane + i];
+            std::copy(sum.begin(), sum.end(), output + lane);
+        }
+
+        for (; lane < lanes; ++lane)
+        {
+            float sum = 0.0F;
+            for (std::size_t tap = 0; tap < taps; ++tap)
+                sum += coefficients[tap] * window[(tap * stride) + lane];
+            output[lane] = sum;
+        }
+    }
+
+#if defined(AUDIO_CONVERT_X86)
+
+    // ----------------- SSE2 (x86-64 baseline) -----------------
+
+    // max(lo, v) then min(hi, v) keeps NaN like std::clamp does.
+    inline __m128 clamp_sse2(__m128 val)
+    {
+        return _mm_min_ps(_mm_set1_ps(max_float), _mm_max_ps(_mm_set1_ps(-max_float), val));
+    }
+
+    void int16_to_float_sse2(const int16_t* input, float* output, std::size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(1.0F / int16_scale);
+        std::size_t  i     = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            const __m128i low     = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+            const __m128i high    = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+            _mm_storeu_ps(output + i,     _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+            _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+        }
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    void float_to_int16_sse2(const float* input, int16_t* output, std::size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(int16_scale);
+        std::size_t  i     = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i low  = _mm_cvttps_epi32(_mm_mul_ps(clamp_sse2(_mm_loadu_ps(input + i)), scale));
+            const __m128i high = _mm_cvttps_epi32(_mm_mul_ps(clamp_sse2(_mm_loadu_ps(input + i + 4)), scale));
+
+            // The saturating pack turns +1.0 (32768) into 32767, like the scalar converter.
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(low, high));
+        }
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+    void int32_to_float_sse2(const int32_t* input, float* output, std::size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(1.0F / int32_scale);
+        std::size_t  i     = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(samples), scale));
+        }
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    void float_to_int32_sse2(const float* input, int32_t* output, std::size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(int32_scale);
+        std::size_t  i     = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 scaled = _mm_mul_ps(clamp_sse2(_mm_loadu_ps(input + i)), scale);
+
+            // +1.0 converts to 0x80000000 : flip it to 0x7FFFFFFF, like the scalar converter saturates.
+            const __m128i samples = _mm_xor_si128(_mm_cvttps_epi32(scaled), _mm_castps_si128(_mm_cmpge_ps(scaled, scale)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), samples);
+        }
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+    void uint8_to_float_sse2(const uint8_t* input, float* output, std::size_t count)
+    {
+        const __m128  half   = _mm_set1_ps(uint8_half);
+        const __m128  offset = _mm_set1_ps(uint8_offset);
+        const __m128i zero   = _mm_setzero_si128();
+        std::size_t   i      = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i bytes = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input + i)), zero);
+            const __m128  low   = _mm_cvtepi32_ps(_mm_unpacklo_epi16(bytes, zero));
+            const __m128  high  = _mm_cvtepi32_ps(_mm_unpackhi_epi16(bytes, zero));
+            _mm_storeu_ps(output + i,     _mm_div_ps(_mm_sub_ps(low, offset), half));
+            _mm_storeu_ps(output + i + 4, _mm_div_ps(_mm_sub_ps(high, offset), half));
+        }
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    void float_to_uint8_sse2(const float* input, uint8_t* output, std::size_t count)
+    {
+        const __m128 half   = _mm_set1_ps(uint8_half);
+        const __m128 offset = _mm_set1_ps(uint8_offset);
+        std::size_t  i      = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i low  = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamp_sse2(_mm_loadu_ps(input + i)), half), offset));
+            const __m128i high = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamp_sse2(_mm_loadu_ps(input + i + 4)), half), offset));
+            const __m128i words = _mm_packs_epi32(low, high);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(words, words));
+        }
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+    // Clamped, scaled and truncated to 24 bits : +1.0 (2^23) saturates to 2^23 - 1. SSE2 has no min_epi32, select instead.
+    inline __m128i float_to_int24_sse2(__m128 val)
+    {
+        const __m128  scale  = _mm_set1_ps(int24_scale);
+        const __m128  scaled = _mm_mul_ps(clamp_sse2(val), scale);
+        const __m128i over   = _mm_castps_si128(_mm_cmpge_ps(scaled, scale));
+        return _mm_or_si128(_mm_andnot_si128(over, _mm_cvttps_epi32(scaled)), _mm_and_si128(over, _mm_set1_epi32(int24_max)));
+    }
+
+    void int24_in_32_to_float_sse2(const int24_in_32* input, float* output, std::size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(1.0F / int24_scale);
+        std::size_t  i     = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            // Sign-extend the low 24 bits, the upper byte is ignored.
+            const __m128i words   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            const __m128i samples = _mm_srai_epi32(_mm_slli_epi32(words, 8), 8);
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(samples), scale));
+        }
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    void float_to_int24_in_32_sse2(const float* input, int24_in_32* output, std::size_t count)
+    {
+        std::size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), float_to_int24_sse2(_mm_loadu_ps(input + i)));
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+    // No byte shuffle before SSSE3 : packed samples are assembled one by one, then converted 4 at a time.
+    void int24_packed_to_float_sse2(const int24_packed* input, float* output, std::size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(1.0F / int24_scale);
+        std::size_t  i     = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128i samples = _mm_setr_epi32(input[i].value(), input[i + 1].value(), input[i + 2].value(), input[i + 3].value());
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(samples), scale));
+        }
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    void float_to_int24_packed_sse2(const float* input, int24_packed* output, std::size_t count)
+    {
+        alignas(16) std::array<int32_t, 4> samples{};
+        std::size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm_store_si128(reinterpret_cast<__m128i*>(samples.data()), float_to_int24_sse2(_mm_loadu_ps(input + i)));
+            for (std::size_t k = 0; k < samples.size(); ++k)
+                output[i + k] = int24_packed::from_value(samples[k]);
+        }
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+    void soft_limit_sse2(float* samples, std::size_t count, float knee)
+    {
+        const __m128 sign_bit  = _mm_set1_ps(-0.0F);
+        const __m128 threshold = _mm_set1_ps(knee);
+        const __m128 range     = _mm_set1_ps(max_float - knee);
+        std::size_t  i         = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 val       = _mm_loadu_ps(samples + i);
+            const __m128 magnitude = _mm_andnot_ps(sign_bit, val);
+            const __m128 excess    = _mm_max_ps(_mm_sub_ps(magnitude, threshold), _mm_setzero_ps());
+            const __m128 limited   = _mm_add_ps(_mm_min_ps(magnitude, threshold), _mm_div_ps(_mm_mul_ps(range, excess), _mm_add_ps(range, excess)));
+            _mm_storeu_ps(samples + i, _mm_or_ps(limited, _mm_and_ps(sign_bit, val)));
+        }
+        soft_limit_scalar(samples + i, count - i, knee);
+    }
+
+    void fir_lanes_sse2(const float* coefficients, std::size_t taps, const float* window, std::size_t stride, float* output, std::size_t lanes)
+    {
+        std::size_t lane = 0;
+        for (; lane + 16 <= lanes; lane += 16)
+        {
+            __m128 sum0 = _mm_setzero_ps();
+            __m128 sum1 = _mm_setzero_ps();
+            __m128 sum2 = _mm_setzero_ps();
+            __m128 sum3 = _mm_setzero_ps();
+            for (std::size_t tap = 0; tap < taps; ++tap)
+            {
+                const __m128 weight = _mm_set1_ps(coefficients[tap]);
+                const float* row    = window + (tap * stride) + lane;
+                sum0                = _mm_add_ps(sum0, _mm_mul_ps(weight, _mm_loadu_ps(row)));
+                sum1                = _mm_add_ps(sum1, _mm_mul_ps(weight, _mm_loadu_ps(row + 4)));
+                sum2                = _mm_add_ps(sum2, _mm_mul_ps(weight, _mm_loadu_ps(row + 8)));
+                sum3                = _mm_add_ps(sum3, _mm_mul_ps(weight, _mm_loadu_ps(row + 12)));
+            }
+            _mm_storeu_ps(output + lane, sum0);
+            _mm_storeu_ps(output + lane + 4, sum1);
+            _mm_storeu_ps(output + lane + 8, sum2);
+            _mm_storeu_ps(output + lane + 12, sum3);
+        }
+        fir_lanes_scalar(coefficients, taps, window + lane, stride, output + lane, lanes - lane);
+    }
+
+    // ----------------- AVX2 (selected at runtime) -----------------
+
+    AUDIO_CONVERT_AVX2_TARGET inline __m256 clamp_avx2(__m256 val)
+    {
+        return _mm256_min_ps(_mm256_set1_ps(max_float), _mm256_max_ps(_mm256_set1_ps(-max_float), val));
+    }
+
+    AUDIO_CONVERT_AVX2_TARGET void int16_to_float_avx2(const int16_t* input, float* output, std::size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(1.0F / int16_scale);
+        std::size_t  i     = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i samples = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)));
+            _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), scale));
+        }
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    AUDIO_CONVERT_AVX2_TARGET void float_to_int16_avx2(const float* input, int16_t* output, std::size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(int16_scale);
+        std::size_t  i     = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i samples = _mm256_cvttps_epi32(_mm256_mul_ps(clamp_avx2(_mm256_loadu_ps(input + i)), scale));
+            const __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(samples), _mm256_extracti128_si256(samples, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), packed);
+        }
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+    AUDIO_CONVERT_AVX2_TARGET void int32_to_float_avx2(const int32_t* input, float* output, std::size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(1.0F / int32_scale);
+        std::size_t  i     = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i samples = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+            _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), scale));
+        }
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    AUDIO_CONVERT_AVX2_TARGET void float_to_int32_avx2(const float* input, int32_t* output, std::size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(int32_scale);
+        std::size_t  i     = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256  scaled  = _mm256_mul_ps(clamp_avx2(_mm256_loadu_ps(input + i)), scale);
+            const __m256i samples = _mm256_xor_si256(_mm256_cvttps_epi32(scaled), _mm256_castps_si256(_mm256_cmp_ps(scaled, scale, _CMP_GE_OQ)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), samples);
+        }
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+    AUDIO_CONVERT_AVX2_TARGET void uint8_to_float_avx2(const uint8_t* input, float* output, std::size_t count)
+    {
+        const __m256 half   = _mm256_set1_ps(uint8_half);
+        const __m256 offset = _mm256_set1_ps(uint8_offset);
+        std::size_t  i      = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i samples = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input + i)));
+            _mm256_storeu_ps(output + i, _mm256_div_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(samples), offset), half));
+        }
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    AUDIO_CONVERT_AVX2_TARGET void float_to_uint8_avx2(const float* input, uint8_t* output, std::size_t count)
+    {
+        const __m256 half   = _mm256_set1_ps(uint8_half);
+        const __m256 offset = _mm256_set1_ps(uint8_offset);
+        std::size_t  i      = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            // Separate mul and add, no FMA : rounding must match the scalar converter.
+            const __m256i samples = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(clamp_avx2(_mm256_loadu_ps(input + i)), half), offset));
+            const __m128i words   = _mm_packs_epi32(_mm256_castsi256_si128(samples), _mm256_extracti128_si256(samples, 1));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(words, words));
+        }
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+    AUDIO_CONVERT_AVX2_TARGET void int24_in_32_to_float_avx2(const int24_in_32* input, float* output, std::size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(1.0F / int24_scale);
+        std::size_t  i     = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i words   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+            const __m256i samples = _mm256_srai_epi32(_mm256_slli_epi32(words, 8), 8);
+            _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), scale));
+        }
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    AUDIO_CONVERT_AVX2_TARGET void float_to_int24_in_32_avx2(const float* input, int24_in_32* output, std::size_t count)
+    {
+        const __m256  scale = _mm256_set1_ps(int24_scale);
+        const __m256i max   = _mm256_set1_epi32(int24_max);
+        std::size_t   i     = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i samples = _mm256_min_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(clamp_avx2(_mm256_loadu_ps(input + i)), scale)), max);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), samples);
+        }
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+    AUDIO_CONVERT_AVX2_TARGET void int24_packed_to_float_avx2(const int24_packed* input, float* output, std::size_t count)
+    {
+        // Each 128-bit lane spreads 4 samples (12 bytes) into the top 3 bytes of 4 int32 : an arithmetic shift sign-extends them.
+        const __m256i spread = _mm256_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+                                                -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+        const __m256   scale  = _mm256_set1_ps(1.0F / int24_scale);
+        const auto*    bytes  = reinterpret_cast<const uint8_t*>(input);
+        std::size_t    i      = 0;
+        for (; i + 10 <= count; i += 8) // The upper load reads 4 bytes past the 8th sample
+        {
+            const __m128i low     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + (i * 3)));
+            const __m128i high    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + (i * 3) + 12));
+            const __m256i words   = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+            const __m256i samples = _mm256_srai_epi32(_mm256_shuffle_epi8(words, spread), 8);
+            _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), scale));
+        }
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    AUDIO_CONVERT_AVX2_TARGET void float_to_int24_packed_avx2(const float* input, int24_packed* output, std::size_t count)
+    {
+        // Each 128-bit lane gathers the low 3 bytes of its 4 int32 into its first 12 bytes.
+        const __m256i gather = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                                0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        const __m256  scale  = _mm256_set1_ps(int24_scale);
+        const __m256i max    = _mm256_set1_epi32(int24_max);
+        auto*         bytes  = reinterpret_cast<uint8_t*>(output);
+        std::size_t   i      = 0;
+        for (; i + 10 <= count; i += 8) // The upper store writes 4 bytes past the 8th sample, rewritten by the next step or the tail
+        {
+            const __m256i samples = _mm256_min_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(clamp_avx2(_mm256_loadu_ps(input + i)), scale)), max);
+            const __m256i packed  = _mm256_shuffle_epi8(samples, gather);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + (i * 3)), _mm256_castsi256_si128(packed));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + (i * 3) + 12), _mm256_extracti128_si256(packed, 1));
+        }
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+    AUDIO_CONVERT_AVX2_TARGET void soft_limit_avx2(float* samples, std::size_t count, float knee)
+    {
+        const __m256 sign_bit  = _mm256_set1_ps(-0.0F);
+        const __m256 threshold = _mm256_set1_ps(knee);
+        const __m256 range     = _mm256_set1_ps(max_float - knee);
+        std::size_t  i         = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 val       = _mm256_loadu_ps(samples + i);
+            const __m256 magnitude = _mm256_andnot_ps(sign_bit, val);
+            const __m256 excess    = _mm256_max_ps(_mm256_sub_ps(magnitude, threshold), _mm256_setzero_ps());
+            const __m256 limited   = _mm256_add_ps(_mm256_min_ps(magnitude, threshold), _mm256_div_ps(_mm256_mul_ps(range, excess), _mm256_add_ps(range, excess)));
+            _mm256_storeu_ps(samples + i, _mm256_or_ps(limited, _mm256_and_ps(sign_bit, val)));
+        }
+        soft_limit_scalar(samples + i, count - i, knee);
+    }
+
+    AUDIO_CONVERT_AVX2_TARGET void fir_lanes_avx2(const float* coefficients, std::size_t taps, const float* window, std::size_t stride, float* output, std::size_t lanes)
+    {
+        // Four independent sums per tile hide the latency of the additions.
+        std::size_t lane = 0;
+        for (; lane + 32 <= lanes; lane += 32)
+        {
+            __m256 sum0 = _mm256_setzero_ps();
+            __m256 sum1 = _mm256_setzero_ps();
+            __m256 sum2 = _mm256_setzero_ps();
+            __m256 sum3 = _mm256_setzero_ps();
+            for (std::size_t tap = 0; tap < taps; ++tap)
+            {
+                const __m256 weight = _mm256_set1_ps(coefficients[tap]);
+                const float* row    = window + (tap * stride) + lane;
+                sum0                = _mm256_add_ps(sum0, _mm256_mul_ps(weight, _mm256_loadu_ps(row)));
+                sum1                = _mm256_add_ps(sum1, _mm256_mul_ps(weight, _mm256_loadu_ps(row + 8)));
+                sum2                = _mm256_add_ps(sum2, _mm256_mul_ps(weight, _mm256_loadu_ps(row + 16)));
+                sum3                = _mm256_add_ps(sum3, _mm256_mul_ps(weight, _mm256_loadu_ps(row + 24)));
+            }
+            _mm256_storeu_ps(output + lane, sum0);
+            _mm256_storeu_ps(output + lane + 8, sum1);
+            _mm256_storeu_ps(output + lane + 16, sum2);
+            _mm256_storeu_ps(output + lane + 24, sum3);
+        }
+        fir_lanes_sse2(coefficients, taps, window + lane, stride, output + lane, lanes - lane);
+    }
+
+    bool cpu_has_avx2()
+    {
+    #if defined(_MSC_VER) && !defined(__clang__)
+        int info[4] = {};
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        __cpuid(info, 1);
+        const bool os_saves_ymm = ((info[2] >> 27) & 1) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+
+        __cpuidex(info, 7, 0);
+        return os_saves_ymm && ((info[1] >> 5) & 1) != 0;
+    #else
+        return __builtin_cpu_supports("avx2") != 0;
+    #endif
+    }
+
+#elif defined(AUDIO_CONVERT_NEON)
+
+    // ----------------- NEON (AArch64) -----------------
+
+    inline float32x4_t clamp_neon(float32x4_t val)
+    {
+        return vminq_f32(vdupq_n_f32(max_float), vmaxq_f32(vdupq_n_f32(-max_float), val));
+    }
+
+    void int16_to_float_neon(const int16_t* input, float* output, std::size_t count)
+    {
+        const float32x4_t scale = vdupq_n_f32(1.0F / int16_scale);
+        std::size_t       i     = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const int16x8_t samples = vld1q_s16(input + i);
+            vst1q_f32(output + i,     vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples))), scale));
+            vst1q_f32(output + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples))), scale));
+        }
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    void float_to_int16_neon(const float* input, int16_t* output, std::size_t count)
+    {
+        const float32x4_t scale = vdupq_n_f32(int16_scale);
+        std::size_t       i     = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const int32x4_t low  = vcvtq_s32_f32(vmulq_f32(clamp_neon(vld1q_f32(input + i)), scale));
+            const int32x4_t high = vcvtq_s32_f32(vmulq_f32(clamp_neon(vld1q_f32(input + i + 4)), scale));
+            // Saturating narrow : +1.0 (32768) becomes 32767, like the scalar converter.
+            vst1q_s16(output + i, vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+        }
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+    void int32_to_float_neon(const int32_t* input, float* output, std::size_t count)
+    {
+        const float32x4_t scale = vdupq_n_f32(1.0F / int32_scale);
+        std::size_t       i     = 0;
+        for (; i + 4 <= count; i += 4)
+            vst1q_f32(output + i, vmulq_f32(vcvtq_f32_s32(vld1q_s32(input + i)), scale));
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    void float_to_int32_neon(const float* input, int32_t* output, std::size_t count)
+    {
+        const float32x4_t scale = vdupq_n_f32(int32_scale);
+        std::size_t       i     = 0;
+        for (; i + 4 <= count; i += 4)
+            vst1q_s32(output + i, vcvtq_s32_f32(vmulq_f32(clamp_neon(vld1q_f32(input + i)), scale)));
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+    void uint8_to_float_neon(const uint8_t* input, float* output, std::size_t count)
+    {
+        const float32x4_t half   = vdupq_n_f32(uint8_half);
+        const float32x4_t offset = vdupq_n_f32(uint8_offset);
+        std::size_t       i      = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const uint16x8_t  words = vmovl_u8(vld1_u8(input + i));
+            const float32x4_t low   = vcvtq_f32_u32(vmovl_u16(vget_low_u16(words)));
+            const float32x4_t high  = vcvtq_f32_u32(vmovl_u16(vget_high_u16(words)));
+            vst1q_f32(output + i,     vdivq_f32(vsubq_f32(low, offset), half));
+            vst1q_f32(output + i + 4, vdivq_f32(vsubq_f32(high, offset), half));
+        }
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    void float_to_uint8_neon(const float* input, uint8_t* output, std::size_t count)
+    {
+        const float32x4_t half   = vdupq_n_f32(uint8_half);
+        const float32x4_t offset = vdupq_n_f32(uint8_offset);
+        std::size_t       i      = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            // Separate mul and add, no fused multiply-add : rounding must match the scalar converter.
+            const float32x4_t low  = vaddq_f32(vmulq_f32(clamp_neon(vld1q_f32(input + i)), half), offset);
+            const float32x4_t high = vaddq_f32(vmulq_f32(clamp_neon(vld1q_f32(input + i + 4)), half), offset);
+            const uint16x8_t  words = vcombine_u16(vmovn_u32(vcvtq_u32_f32(low)), vmovn_u32(vcvtq_u32_f32(high)));
+            vst1_u8(output + i, vmovn_u16(words));
+        }
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+
+    void int24_in_32_to_float_neon(const int24_in_32* input, float* output, std::size_t count)
+    {
+        const float32x4_t scale = vdupq_n_f32(1.0F / int24_scale);
+        const auto*       words = reinterpret_cast<const int32_t*>(input);
+        std::size_t       i     = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const int32x4_t samples = vshrq_n_s32(vshlq_n_s32(vld1q_s32(words + i), 8), 8);
+            vst1q_f32(output + i, vmulq_f32(vcvtq_f32_s32(samples), scale));
+        }
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    void float_to_int24_in_32_neon(const float* input, int24_in_32* output, std::size_t count)
+    {
+        const float32x4_t scale = vdupq_n_f32(int24_scale);
+        const int32x4_t   max   = vdupq_n_s32(int24_max);
+        auto*             words = reinterpret_cast<int32_t*>(output);
+        std::size_t       i     = 0;
+        for (; i + 4 <= count; i += 4)
+            vst1q_s32(words + i, vminq_s32(vcvtq_s32_f32(vmulq_f32(clamp_neon(vld1q_f32(input + i)), scale)), max));
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+    // vld3 / vst3 split and merge the 3 bytes of 8 packed samples.
+    void int24_packed_to_float_neon(const int24_packed* input, float* output, std::size_t count)
+    {
+        const float32x4_t scale = vdupq_n_f32(1.0F / int24_scale);
+        const auto*       bytes = reinterpret_cast<const uint8_t*>(input);
+        std::size_t       i     = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const uint8x8x3_t planes = vld3_u8(bytes + (i * 3));
+            const uint16x8_t  b0     = vmovl_u8(planes.val[0]);
+            const uint16x8_t  b1     = vmovl_u8(planes.val[1]);
+            const uint16x8_t  b2     = vmovl_u8(planes.val[2]);
+
+            const auto assemble = [](uint16x4_t lo, uint16x4_t mid, uint16x4_t hi)
+            {
+                const uint32x4_t raw = vorrq_u32(vorrq_u32(vmovl_u16(lo), vshll_n_u16(mid, 8)), vshll_n_u16(hi, 16));
+                return vshrq_n_s32(vshlq_n_s32(vreinterpretq_s32_u32(raw), 8), 8);
+            };
+            const int32x4_t low  = assemble(vget_low_u16(b0), vget_low_u16(b1), vget_low_u16(b2));
+            const int32x4_t high = assemble(vget_high_u16(b0), vget_high_u16(b1), vget_high_u16(b2));
+            vst1q_f32(output + i,     vmulq_f32(vcvtq_f32_s32(low), scale));
+            vst1q_f32(output + i + 4, vmulq_f32(vcvtq_f32_s32(high), scale));
+        }
+        to_float_scalar(input + i, output + i, count - i);
+    }
+
+    void float_to_int24_packed_neon(const float* input, int24_packed* output, std::size_t count)
+    {
+        const float32x4_t scale = vdupq_n_f32(int24_scale);
+        const int32x4_t   max   = vdupq_n_s32(int24_max);
+        auto*             bytes = reinterpret_cast<uint8_t*>(output);
+        std::size_t       i     = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const uint32x4_t low  = vreinterpretq_u32_s32(vminq_s32(vcvtq_s32_f32(vmulq_f32(clamp_neon(vld1q_f32(input + i)), scale)), max));
+            const uint32x4_t high = vreinterpretq_u32_s32(vminq_s32(vcvtq_s32_f32(vmulq_f32(clamp_neon(vld1q_f32(input + i + 4)), scale)), max));
+
+            const auto byte_at = [&](int shift)
+            {
+                const int32x4_t right = vdupq_n_s32(-shift);
+                return vmovn_u16(vcombine_u16(vmovn_u32(vshlq_u32(low, right)), vmovn_u32(vshlq_u32(high, right))));
+            };
+            vst3_u8(bytes + (i * 3), uint8x8x3_t{{byte_at(0), byte_at(8), byte_at(16)}});
+        }
+        from_float_scalar(input + i, output + i, count - i);
+    }
+
+    void soft_limit_neon(float* samples, std::size_t count, float knee)
+    {
+        const uint32x4_t  sign_bit  = vdupq_n_u32(0x80000000U);
+        const float32x4_t threshold = vdupq_n_f32(knee);
+        const float32x4_t range     = vdupq_n_f32(max_float - knee);
+        std::size_t       i         = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const float32x4_t val       = vld1q_f32(samples + i);
+            const float32x4_t magnitude = vabsq_f32(val);
+            const float32x4_t excess    = vmaxq_f32(vsubq_f32(magnitude, threshold), vdupq_n_f32(0.0F));
+            const float32x4_t limited   = vaddq_f32(vminq_f32(magnitude, threshold), vdivq_f32(vmulq_f32(range, excess), vaddq_f32(range, excess)));
+            vst1q_f32(samples + i, vbslq_f32(sign_bit, val, limited)); // Sign of the input, magnitude of the curve
+        }
+        soft_limit_scalar(samples + i, count - i, knee);
+    }
+
+    void fir_lanes_neon(const float* coefficients, std::size_t taps, const float* window, std::size_t stride, float* output, std::size_t lanes)
+    {
+        std::size_t lane = 0;
+        for (; lane + 16 <= lanes; lane += 16)
+        {
+            float32x4_t sum0 = vdupq_n_f32(0.0F);
+            float32x4_t sum1 = vdupq_n_f32(0.0F);
+            float32x4_t sum2 = vdupq_n_f32(0.0F);
+            float32x4_t sum3 = vdupq_n_f32(0.0F);
+            for (std::size_t tap = 0; tap < taps; ++tap)
+            {
+                const float32x4_t weight = vdupq_n_f32(coefficients[tap]);
+                const float*      row    = window + (tap * stride) + lane;
+                sum0                     = vaddq_f32(sum0, vmulq_f32(weight, vld1q_f32(row)));
+                sum1                     = vaddq_f32(sum1, vmulq_f32(weight, vld1q_f32(row + 4)));
+                sum2                     = vaddq_f32(sum2, vmulq_f32(weight, vld1q_f32(row + 8)));
+                sum3                     = vaddq_f32(sum3, vmulq_f32(weight, vld1q_f32(row + 12)));
+            }
+            vst1q_f32(output + lane, sum0);
+            vst1q_f32(output + lane + 4, sum1);
+            vst1q_f32(output + lane + 8, sum2);
+            vst1q_f32(output + lane + 12, sum3);
+        }
+        fir_lanes_scalar(coefficients, taps, window + lane, stride, output + lane, lanes - lane);
+    }
+
+#endif
+
+    // ----------------- Runtime dispatch -----------------
+
+    struct convert_kernels
+    {
+        void (*int16_to_float)(const int16_t*, float*, std::size_t) = to_float_scalar<int16_t>;
+        void (*int32_to_float)(const int32_t*, float*, std::size_t) = to_float_scalar<int32_t>;
+        void (*uint8_to_float)(const uint8_t*, float*, std::size_t) = to_float_scalar<uint8_t>;
+        void (*int24_packed_to_float)(const int24_packed*, float*, std::size_t) = to_float_scalar<int24_packed>;
+        void (*int24_in_32_to_float)(const int24_in_32*, float*, std::size_t) = to_float_scalar<int24_in_32>;
+
+        void (*float_to_int16)(const float*, int16_t*, std::size_t) = from_float_scalar<int16_t>;
+        void (*float_to_int32)(const float*, int32_t*, std::size_t) = from_float_scalar<int32_t>;
+        void (*float_to_uint8)(const float*, uint8_t*, std::size_t) = from_float_scalar<uint8_t>;
+        void (*float_to_int24_packed)(const float*, int24_packed*, std::size_t) = from_float_scalar<int24_packed>;
+        void (*float_to_int24_in_32)(const float*, int24_in_32*, std::size_t) = from_float_scalar<int24_in_32>;
+
+        void (*soft_limit)(float*, std::size_t, float) = soft_limit_scalar;
+        void (*fir_lanes)(const float*, std::size_t, const float*, std::size_t, float*, std::size_t) = fir_lanes_scalar;
+    };
+
+    convert_kernels select_kernels()
+    {
+        convert_kernels kernels;
+    #if defined(AUDIO_CONVERT_X86)
+        if (cpu_has_avx2())
+            kernels = {int16_to_float_avx2, int32_to_float_avx2, uint8_to_float_avx2, int24_packed_to_float_avx2, int24_in_32_to_float_avx2,
+                       float_to_int16_avx2, float_to_int32_avx2, float_to_uint8_avx2, float_to_int24_packed_avx2, float_to_int24_in_32_avx2,
+                       soft_limit_avx2, fir_lanes_avx2};
+        else
+            kernels = {int16_to_float_sse2, int32_to_float_sse2, uint8_to_float_sse2, int24_packed_to_float_sse2, int24_in_32_to_float_sse2,
+                       float_to_int16_sse2, float_to_int32_sse2, float_to_uint8_sse2, float_to_int24_packed_sse2, float_to_int24_in_32_sse2,
+                       soft_limit_sse2, fir_lanes_sse2};
+    #elif defined(AUDIO_CONVERT_NEON)
+        kernels = {int16_to_float_neon, int32_to_float_neon, uint8_to_float_neon, int24_packed_to_float_neon, int24_in_32_to_float_neon,
+                   float_to_int16_neon, float_to_int32_neon, float_to_uint8_neon, float_to_int24_packed_neon, float_to_int24_in_32_neon,
+                   soft_limit_neon, fir_lanes_neon};
+    #endif
+        return kernels;
+    }
+
+    const convert_kernels& active_kernels()
+    {
+        static const convert_kernels kernels = select_kernels();
+        return kernels;
+    }
+} // namespace
+
+void detail::int16_to_float(const int16_t* input, float* output, std::size_t count) { active_kernels().int16_to_float(input, output, count); }
+void detail::int32_to_float(const int32_t* input, float* output, std::size_t count) { active_kernels().int32_to_float(input, output, count); }
+void detail::uint8_to_float(const uint8_t* input, float* output, std::size_t count) { active_kernels().uint8_to_float(input, output, count); }
+void detail::int24_packed_to_float(const int24_packed* input, float* output, std::size_t count) { active_kernels().int24_packed_to_float(input, output, count); }
+void detail::int24_in_32_to_float(const int24_in_32* input, float* output, std::size_t count) { active_kernels().int24_in_32_to_float(input, output, count); }
+
+void detail::float_to_int16(const float* input, int16_t* output, std::size_t count) { active_kernels().float_to_int16(input, output, count); }
+void detail::float_to_int32(const float* input, int32_t* output, std::size_t count) { active_kernels().float_to_int32(input, output, count); }
+void detail::float_to_uint8(const float* input, uint8_t* output, std::size_t count) { active_kernels().float_to_uint8(input, output, count); }
+void detail::float_to_int24_packed(const float* input, int24_packed* output, std::size_t count) { active_kernels().float_to_int24_packed(input, output, count); }
+void detail::float_to_int24_in_32(const float* input, int24_in_32* output, std::size_t count) { active_kernels().float_to_int24_in_32(input, output, count); }
+
+void detail::soft_limit(float* samples, std::size_t count, float knee) { active_kernels().soft_limit(samples, count, knee); }
+void detail::fir_lanes(const float* coefficients, std::size_t taps, const float* window, std::size_t stride, float* output, std::size_t lanes)
+{
+    active_kernels().fir_lanes(coefficients, taps, window, stride, output, lanes);
+}
+
+void detail::add_tpdf_dither(float* samples, std::size_t count, float lsb, bool toward_zero, std::uint32_t& state)
+{
+    // Difference of two uniform 16-bit draws from one xorshift32 step : triangular in (-1, 1) LSB.
+    const float scale = lsb / 65536.0F;
+    const float half  = toward_zero ? lsb / 2.0F : 0.0F;
+    std::uint32_t x   = state;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        x ^= x << 13U;
+        x ^= x >> 17U;
+        x ^= x << 5U;
+        const float dithered = samples[i] + (scale * static_cast<float>(static_cast<std::int32_t>(x & 0xFFFFU) - static_cast<std::int32_t>(x >> 16U)));
+        samples[i]           = dithered + std::copysign(half, dithered);
+    }
+    state = x;
+}
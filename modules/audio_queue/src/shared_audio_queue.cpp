@@ -0,0 +1,155 @@
+#include <string>
+#include <utility>
+
+#include "shared_audio_queue.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <cerrno>
+    #include <csignal>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace
+{
+#if defined(__unix__) || defined(__APPLE__)
+    // POSIX names are "/name" : one leading slash, none after.
+    std::string posix_name(std::string_view name)
+    {
+        return name.starts_with('/') ? std::string(name) : "/" + std::string(name);
+    }
+#endif
+} // namespace
+
+// ----------------- shared_memory -----------------
+
+auto
+shared_memory::create(std::string_view name, std::size_t size)
+-> std::optional<shared_memory>
+{
+#if defined(__unix__) || defined(__APPLE__)
+    const auto path       = posix_name(name);
+    const int  descriptor = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (descriptor < 0)
+        return std::nullopt;
+
+    void* data = MAP_FAILED;
+    if (ftruncate(descriptor, static_cast<off_t>(size)) == 0)
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    ::close(descriptor); // The mapping keeps the segment open
+
+    if (data == MAP_FAILED)
+    {
+        shm_unlink(path.c_str());
+        return std::nullopt;
+    }
+
+    shared_memory memory;
+    memory.m_data = static_cast<std::byte*>(data);
+    memory.m_size = size;
+    return memory;
+#else
+    (void)name;
+    (void)size;
+    return std::nullopt;
+#endif
+}
+
+auto
+shared_memory::open(std::string_view name)
+-> std::optional<shared_memory>
+{
+#if defined(__unix__) || defined(__APPLE__)
+    const int descriptor = shm_open(posix_name(name).c_str(), O_RDWR, 0);
+    if (descriptor < 0)
+        return std::nullopt;
+
+    // An empty segment (its creator did not size it yet) has no mapping
+    struct stat status{};
+    void*       data = MAP_FAILED;
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+        data = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    ::close(descriptor);
+
+    if (data == MAP_FAILED)
+        return std::nullopt;
+
+    shared_memory memory;
+    memory.m_data = static_cast<std::byte*>(data);
+    memory.m_size = static_cast<std::size_t>(status.st_size);
+    return memory;
+#else
+    (void)name;
+    return std::nullopt;
+#endif
+}
+
+auto
+shared_memory::remove(std::string_view name)
+-> bool
+{
+#if defined(__unix__) || defined(__APPLE__)
+    return shm_unlink(posix_name(name).c_str()) == 0;
+#else
+    (void)name;
+    return false;
+#endif
+}
+
+shared_memory::shared_memory(shared_memory&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0))
+{}
+
+auto
+shared_memory::operator=(shared_memory&& other) noexcept
+-> shared_memory&
+{
+    if (this != &other)
+    {
+        unmap();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+
+shared_memory::~shared_memory() { unmap(); }
+
+void
+shared_memory::unmap()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    if (m_data != nullptr)
+        munmap(m_data, m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+// ----------------- Processes -----------------
+
+auto
+detail::current_process()
+-> std::int64_t
+{
+#if defined(__unix__) || defined(__APPLE__)
+    return static_cast<std::int64_t>(getpid());
+#else
+    return 0;
+#endif
+}
+
+auto
+detail::process_alive(const std::int64_t process)
+-> bool
+{
+#if defined(__unix__) || defined(__APPLE__)
+    // Signal 0 only checks : EPERM is a live process of another user.
+    return process > 0 && (kill(static_cast<pid_t>(process), 0) == 0 || errno == EPERM);
+#else
+    return process != 0;
+#endif
+}
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+#include "wait_point.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <ctime>
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace
+{
+#if !defined(_WIN32) && !defined(__linux__)
+    constexpr std::chrono::microseconds word_poll_interval{250}; // Sleep of wait_on_word() without futex
+#endif
+} // namespace
+
+// ----------------- Wake-up words -----------------
+
+auto
+detail::wait_on_word(const std::atomic<std::uint32_t>& word, const std::uint32_t expected, const std::chrono::nanoseconds timeout, const bool process_shared)
+-> void
+{
+    if (timeout <= std::chrono::nanoseconds::zero())
+        return;
+
+#if defined(_WIN32)
+    (void)process_shared;
+    const auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+    WaitOnAddress(const_cast<std::atomic<std::uint32_t>*>(&word), const_cast<std::uint32_t*>(&expected), sizeof(expected),
+                  static_cast<DWORD>(std::min<long long>(milliseconds, INFINITE - 1)));
+#elif defined(__linux__)
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "futex words are plain 32-bit words");
+
+    // FUTEX_PRIVATE_FLAG unless the word is in memory shared between processes.
+    const auto     seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    const timespec relative{.tv_sec = static_cast<time_t>(seconds.count()), .tv_nsec = static_cast<long>((timeout - seconds).count())};
+    syscall(SYS_futex, reinterpret_cast<const std::uint32_t*>(&word), process_shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, expected, &relative, nullptr, 0);
+#else
+    (void)process_shared;
+    if (word.load(std::memory_order_acquire) == expected)
+        std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(timeout, word_poll_interval));
+#endif
+}
+
+auto
+detail::wake_word(const std::atomic<std::uint32_t>& word, const bool process_shared)
+-> void
+{
+#if defined(_WIN32)
+    (void)process_shared;
+    WakeByAddressAll(const_cast<std::atomic<std::uint32_t>*>(&word));
+#elif defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<const std::uint32_t*>(&word), process_shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE, std::numeric_limits<int>::max(), nullptr, nullptr, 0);
+#else
+    (void)word;
+    (void)process_shared;
+#endif
+}
+
+// ----------------- wait_point -----------------
+
+auto
+wait_point::signal()
+-> void
+{
+    m_epoch.fetch_add(1, std::memory_order_release);
+    detail::wake_word(m_epoch);
+
+    // Pairs with unlisten() : either it sees this call in flight, or this call sees the listener gone.
+    m_signalling.fetch_add(1, std::memory_order_seq_cst);
+    if (auto* listener = m_listener.load(std::memory_order_seq_cst))
+    {
+        listener->fetch_add(1, std::memory_order_release);
+        detail::wake_word(*listener);
+    }
+    m_signalling.fetch_sub(1, std::memory_order_release);
+}
+
+auto
+wait_point::unlisten(std::atomic<std::uint32_t>* word)
+-> void
+{
+    m_listener.compare_exchange_strong(word, nullptr, std::memory_order_seq_cst);
+    while (m_signalling.load(std::memory_order_seq_cst) != 0)
+        std::this_thread::yield();
+}
+
+auto
+wait_point::enter(const std::size_t level)
+-> void
+{
+    const std::uint64_t wanted  = std::min<std::uint64_t>(level, level_mask);
+    std::uint64_t       waiters = m_waiters.load(std::memory_order_relaxed);
+    std::uint64_t       entered = 0;
+    do
+    {
+        const std::uint64_t lowest = (waiters >> count_shift) == 0 ? wanted : std::min(waiters & level_mask, wanted);
+        entered                    = (((waiters >> count_shift) + 1) << count_shift) | lowest;
+    } while (!m_waiters.compare_exchange_weak(waiters, entered, std::memory_order_relaxed));
+
+    // Pairs with notify() : the condition is checked after this.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+auto
+wait_point::leave()
+-> void
+{
+    std::uint64_t waiters = m_waiters.load(std::memory_order_relaxed);
+    std::uint64_t left    = 0;
+    do
+    {
+        const std::uint64_t count = (waiters >> count_shift) - 1;
+        left                      = count == 0 ? 0 : ((count << count_shift) | (waiters & level_mask));
+    } while (!m_waiters.compare_exchange_weak(waiters, left, std::memory_order_relaxed));
+}
@@ -1,12 +1,58 @@
 #include <catch2/catch_all.hpp>
 #include "audio_queue.h"
+#include "audio_wait_service.h"
+#include "sample_convert.h"
+#include "shared_audio_queue.h"
 
 #include <vector>
 #include <numeric>
 #include <iostream>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <bit>
+#include <cmath>
+#include <coroutine>
+#include <cstring>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using Catch::Matchers::WithinAbs;
 
+// Allocation trap: counts operator new calls made by the current thread while armed.
+namespace
+{
+    thread_local bool   g_count_allocations = false;
+    thread_local size_t g_allocation_count  = 0;
+
+    struct allocation_counter
+    {
+        allocation_counter()  { g_allocation_count = 0; g_count_allocations = true; }
+        ~allocation_counter() { g_count_allocations = false; }
+
+        size_t count() const { return g_allocation_count; }
+    };
+}
+
+// Kept out of line : inlined into a caller, GCC pairs their malloc and free with the new and delete expressions
+// (-Wmismatched-new-delete).
+[[gnu::noinline]] void* operator new(std::size_t size)
+{
+    if (g_count_allocations)
+        ++g_allocation_count;
+
+    if (void* ptr = std::malloc(size != 0 ? size : 1))
+        return ptr;
+    throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete(void* ptr) noexcept { std::free(ptr); }
+[[gnu::noinline]] void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
 // Utility: generate a simple ramp waveform for predictable verification
 template <typename T>
 std::vector<T> generate_ramp(size_t frame_count, size_t channels, T start = T(0), T step = T(1))
@@ -41,7 +87,7 @@ TEST_CASE("audio_queue basic push/pop (float)", "[audio_queue]")
     REQUIRE(q.push_audio(ctx, input.data(), 256));
 
     std::vector<float> output(256 * ctx.m_channel_num, 0.0f);
-    bool full = q.pop_audio(ctx, output.data(), 256);
+    REQUIRE(q.pop_audio(ctx, output.data(), 256));
 
     REQUIRE(output.size() == input.size());
     REQUIRE(rms_diff(input, output) < 1e-6f);
@@ -55,7 +101,7 @@ TEST_CASE("audio_queue push/pop (int16_t)", "[audio_queue]")
     REQUIRE(q.push_audio(ctx, input.data(), 256));
 
     std::vector<int16_t> output(256, 0);
-    bool full = q.pop_audio(ctx, output.data(), 256);
+    REQUIRE(q.pop_audio(ctx, output.data(), 256));
 
     REQUIRE(output.size() == input.size());
     REQUIRE(rms_diff(input, output) < 2.0f);
@@ -128,4 +174,1381 @@ TEST_CASE("audio_queue round-trip conversion precision", "[audio_queue]")
         auto back = from_float(f);
         REQUIRE(std::abs(src - back) <= 2);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("audio_queue keeps resampler state across pushes", "[audio_queue][resample]")
+{
+    audio_ctx input_ctx{sample_rate::SR44100, "Mono"};
+    audio_ctx output_ctx{sample_rate::SR48000, "Mono"};
+    audio_queue<float> q(output_ctx, 1000);
+
+    constexpr size_t block_frames = 441;
+    constexpr size_t block_count  = 20;
+
+    std::vector<float> block(block_frames);
+    for (size_t b = 0; b < block_count; ++b)
+    {
+        for (size_t i = 0; i < block_frames; ++i)
+            block[i] = 0.5f * std::sin(2.0f * 3.14159265f * 440.0f * static_cast<float>(b * block_frames + i) / 44100.0f);
+        REQUIRE(q.push_audio(input_ctx, block.data(), block_frames));
+    }
+    REQUIRE(q.flush_audio(input_ctx));
+
+    // Drain frame by frame to count what the whole stream produced
+    size_t popped = 0;
+    float  sample = 0.0f;
+    while (q.pop_audio(output_ctx, &sample, 1))
+    {
+        sample = 0.0f;
+        ++popped;
+    }
+
+    // Block boundaries lose nothing : the stream length follows the ratio
+    const double expected = static_cast<double>(block_frames * block_count) * 48000.0 / 44100.0;
+    REQUIRE(std::abs(static_cast<double>(popped) - expected) <= 2.0);
+}
+
+TEST_CASE("halfband fast path for exact 2x ratios", "[audio_queue][resample]")
+{
+    const auto tone = [](size_t frames, float freq, float rate)
+    {
+        std::vector<float> out(frames);
+        for (size_t i = 0; i < frames; ++i)
+            out[i] = 0.5f * std::sin(2.0f * 3.14159265f * freq * static_cast<float>(i) / rate);
+        return out;
+    };
+    const auto drain = [](audio_queue<float>& q, const audio_ctx& ctx)
+    {
+        std::vector<float> out;
+        float sample = 0.0f;
+        while (q.pop_audio(ctx, &sample, 1))
+        {
+            out.push_back(sample);
+            sample = 0.0f;
+        }
+        return out;
+    };
+    const auto rms = [](const std::vector<float>& v, size_t skip)
+    {
+        double sum = 0.0;
+        for (size_t i = skip; i < v.size() - skip; ++i)
+            sum += static_cast<double>(v[i]) * v[i];
+        return std::sqrt(sum / static_cast<double>(v.size() - 2 * skip));
+    };
+
+    audio_ctx ctx48{sample_rate::SR48000, "Mono"};
+    audio_ctx ctx96{sample_rate::SR96000, "Mono"};
+
+    SECTION("upsampling keeps the stream length and the passband level")
+    {
+        audio_queue<float> q(ctx96, 1000);
+        const auto input = tone(4800, 1000.0f, 48000.0f);
+        for (size_t offset = 0; offset < input.size(); offset += 100) // Blocks : state kept across pushes
+            REQUIRE(q.push_audio(ctx48, input.data() + offset, 100));
+        REQUIRE(q.flush_audio(ctx48));
+
+        const auto output = drain(q, ctx96);
+        REQUIRE(std::abs(static_cast<double>(output.size()) - 9600.0) <= 64.0);
+        REQUIRE_THAT(rms(output, 200), WithinAbs(rms(input, 100), 0.005));
+    }
+
+    SECTION("decimation removes what is above the new Nyquist frequency")
+    {
+        for (auto quality : {resample_quality::best, resample_quality::medium, resample_quality::fastest})
+        {
+            audio_queue<float> pass(ctx48, 1000, quality);
+            audio_queue<float> stop(ctx48, 1000, quality);
+
+            auto low  = tone(9600, 1000.0f, 96000.0f);
+            auto high = tone(9600, 36000.0f, 96000.0f);
+            REQUIRE(pass.push_audio(ctx96, low.data(), low.size()));
+            REQUIRE(stop.push_audio(ctx96, high.data(), high.size()));
+            REQUIRE(pass.flush_audio(ctx96));
+            REQUIRE(stop.flush_audio(ctx96));
+
+            const auto passed = drain(pass, ctx48);
+            REQUIRE(std::abs(static_cast<double>(passed.size()) - 4800.0) <= 64.0);
+            REQUIRE_THAT(rms(passed, 100), WithinAbs(rms(low, 100), 0.005));
+            REQUIRE(rms(drain(stop, ctx48), 100) < rms(high, 100) * 0.01); // At least 40 dB down
+        }
+    }
+
+    SECTION("cheap tiers go through libsamplerate")
+    {
+        audio_queue<float> q(ctx96, 1000, resample_quality::linear);
+        auto input = tone(480, 1000.0f, 48000.0f);
+        REQUIRE(q.push_audio(ctx48, input.data(), input.size()));
+        REQUIRE(q.flush_audio(ctx48));
+        REQUIRE(std::abs(static_cast<double>(drain(q, ctx96).size()) - 960.0) <= 4.0);
+    }
+}
+
+TEST_CASE("compile-time pipelines match the runtime push", "[audio_queue][pipeline]")
+{
+    constexpr size_t frames = 2500;
+
+    const auto check = []<typename T, audio_format Input, audio_format Output>()
+    {
+        std::vector<T> input(frames * static_cast<size_t>(Input.m_channel_num));
+        for (size_t i = 0; i < input.size(); ++i)
+            input[i] = make_audio_converters<T>().second(0.9f * std::sin(0.01f * static_cast<float>(i)));
+
+        audio_queue<T> runtime(Output, 1000);
+        audio_queue<T> fixed(Output, 1000);
+        REQUIRE(runtime.push_audio(Input, input.data(), frames));
+        REQUIRE(fixed.template push_audio<Input, Output>(input.data(), frames));
+
+        std::vector<float> expected(frames * 4 * static_cast<size_t>(Output.m_channel_num));
+        std::vector<float> actual(expected.size());
+        const size_t expected_size = runtime.pop_float(expected);
+        REQUIRE(expected_size > 0);
+        REQUIRE(fixed.pop_float(actual) == expected_size);
+        REQUIRE(std::memcmp(expected.data(), actual.data(), expected_size * sizeof(float)) == 0);
+    };
+
+    check.operator()<float, audio_format{sample_rate::SR48000, channel_layout::Stereo}, audio_format{sample_rate::SR48000, channel_layout::Stereo}>();
+    check.operator()<int16_t, audio_format{sample_rate::SR48000, channel_layout::Mono}, audio_format{sample_rate::SR48000, channel_layout::Stereo}>();
+    check.operator()<int16_t, audio_format{sample_rate::SR48000, channel_layout::Stereo}, audio_format{sample_rate::SR48000, channel_layout::Stereo}>();
+    check.operator()<float, audio_format{sample_rate::SR48000, channel_layout::SevenPointOne}, audio_format{sample_rate::SR48000, channel_layout::Stereo}>();
+    check.operator()<uint8_t, audio_format{sample_rate::SR48000, channel_layout::FivePointOne}, audio_format{sample_rate::SR48000, channel_layout::Mono}>();
+    check.operator()<int32_t, audio_format{sample_rate::SR44100, channel_layout::Mono}, audio_format{sample_rate::SR48000, channel_layout::Stereo}>();
+    check.operator()<float, audio_format{sample_rate::SR96000, channel_layout::Stereo}, audio_format{sample_rate::SR48000, channel_layout::Stereo}>();
+
+    // The expected format is checked
+    audio_queue<float> queue(audio_format{sample_rate::SR48000, channel_layout::Stereo});
+    std::vector<float> data(64);
+    REQUIRE_FALSE(queue.push_audio<audio_format{sample_rate::SR48000, channel_layout::Stereo}, audio_format{sample_rate::SR44100, channel_layout::Stereo}>(data.data(), 32));
+}
+
+TEST_CASE("audio_queue steady-state push/pop does not allocate", "[audio_queue][realtime]")
+{
+    audio_ctx input_ctx{sample_rate::SR44100, "Mono"};
+    audio_ctx output_ctx{sample_rate::SR48000, "Stereo"};
+    audio_queue<int16_t> q(output_ctx);
+
+    // Creating the resampler and scratch buffers is the only allocation, done up front.
+    REQUIRE(q.prepare_input(input_ctx));
+    REQUIRE(q.prepare_input(output_ctx));
+
+    auto input           = generate_ramp<int16_t>(2048, 1, 0, 8);
+    auto same_ctx_input  = generate_ramp<int16_t>(256, 2, 0, 8);
+    std::vector<int16_t> output(512 * 2, 0);
+
+    size_t allocations = 0;
+    {
+        allocation_counter counter;
+        for (int i = 0; i < 4; ++i)
+        {
+            q.push_audio(input_ctx, input.data(), 2048);
+            q.push_audio(output_ctx, same_ctx_input.data(), 256);
+            q.pop_audio(output_ctx, output.data(), 512);
+        }
+        allocations = counter.count();
+    }
+    REQUIRE(allocations == 0);
+}
+
+TEST_CASE("audio_queue stats count traffic, drops and underruns", "[audio_queue][stats]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    audio_queue<int16_t> q(ctx, 10); // 480 frames, rounded up to 512
+
+    deferred_log::instance().flush(); // Start from an empty log
+    std::vector<int16_t> buffer(400 * 2, 100);
+
+    REQUIRE(q.push_audio(ctx, buffer.data(), 400));
+    REQUIRE_FALSE(q.push_audio(ctx, buffer.data(), 200)); // Only 112 frames fit
+
+    auto stats = q.stats();
+    REQUIRE(stats.m_frames_pushed == 512);
+    REQUIRE(stats.m_samples_dropped == 88 * 2);
+    REQUIRE(stats.m_fill_frames == 512);
+    REQUIRE(stats.m_high_water == 512);
+    REQUIRE(stats.m_push_latency.count() == 2);
+
+    REQUIRE(q.pop_audio(ctx, buffer.data(), 400));
+    REQUIRE_FALSE(q.pop_audio(ctx, buffer.data(), 200)); // 88 frames short
+    REQUIRE(q.discard(1000) == 0);                        // Discarding is not an underrun
+
+    stats = q.stats();
+    REQUIRE(stats.m_frames_popped == 512);
+    REQUIRE(stats.m_underruns == 1);
+    REQUIRE(stats.m_frames_short == 88);
+    REQUIRE(stats.m_fill_frames == 0);
+    REQUIRE(stats.m_high_water == 512);
+    REQUIRE(stats.m_pop_latency.count() == 2);
+    REQUIRE(stats.m_pop_latency.quantile(1.0) >= stats.m_pop_latency.quantile(0.5));
+
+    // The fill level follows the counters through overwrites and resizes
+    q.set_overflow_policy(overflow_policy::overwrite_oldest);
+    REQUIRE(q.push_audio(ctx, buffer.data(), 400));
+    REQUIRE(q.push_audio(ctx, buffer.data(), 300));
+    REQUIRE(q.stats().m_fill_frames == 512);
+    q.set_latency(5); // 256 frames
+    REQUIRE(q.discard(100 * 2) == 100 * 2);
+    REQUIRE(q.stats().m_fill_frames == q.ready_frames());
+    REQUIRE(q.ready_frames() == 156);
+    q.set_overflow_policy(overflow_policy::drop_newest);
+
+    // The drop was reported to the deferred log, not printed on the audio path
+    std::vector<std::string> messages;
+    deferred_log::instance().drain([&](const log_record& record) { messages.emplace_back(record.m_message); });
+    REQUIRE(messages.size() == 1);
+    REQUIRE(messages[0].find("dropped") != std::string::npos);
+}
+
+TEST_CASE("audio_queue overflow policies keep whole frames", "[audio_queue][overflow]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    audio_queue<float> q(ctx, 10); // 480 frames, rounded up to 512
+    REQUIRE(q.free_frames() == 512);
+
+    // Frame f holds (f, -f) : any channel shift shows up
+    auto frames_from = [](size_t first, size_t count)
+    {
+        std::vector<float> frames(count * 2);
+        for (size_t f = 0; f < count; ++f)
+        {
+            frames[f * 2]     = static_cast<float>(first + f) / 4096.0f;
+            frames[f * 2 + 1] = -static_cast<float>(first + f) / 4096.0f;
+        }
+        return frames;
+    };
+    auto first_frame = [&](std::span<const float> popped) { return static_cast<size_t>(std::lround(popped[0] * 4096.0f)); };
+
+    auto push = [&](size_t first, size_t count) { auto frames = frames_from(first, count); return q.push_audio(ctx, frames.data(), count); };
+    std::vector<float> popped(512 * 2);
+
+    SECTION("drop_newest writes the frames that fit")
+    {
+        REQUIRE(push(0, 400));
+        REQUIRE_FALSE(push(400, 200));
+        REQUIRE(q.free_frames() == 0);
+        REQUIRE(q.pop_float(popped) == popped.size());
+        REQUIRE(popped == frames_from(0, 512));
+    }
+
+    SECTION("drop_push is all or nothing")
+    {
+        q.set_overflow_policy(overflow_policy::drop_push);
+        REQUIRE(push(0, 400));
+        REQUIRE_FALSE(push(400, 200));
+        REQUIRE(q.free_frames() == 112);
+        REQUIRE(push(400, 112));
+        REQUIRE(q.pop_float(popped) == popped.size());
+        REQUIRE(popped == frames_from(0, 512));
+        REQUIRE(q.stats().m_samples_dropped == 200 * 2);
+    }
+
+    SECTION("overwrite_oldest keeps the newest frames")
+    {
+        q.set_overflow_policy(overflow_policy::overwrite_oldest);
+        REQUIRE(push(0, 400));
+        REQUIRE(push(400, 200));
+        REQUIRE(q.pop_float(popped) == popped.size());
+        REQUIRE(first_frame(popped) == 88);
+        REQUIRE(popped == frames_from(88, 512));
+
+        // Larger than the whole queue
+        REQUIRE(push(1000, 1500));
+        REQUIRE(q.pop_float(popped) == popped.size());
+        REQUIRE(popped == frames_from(1000 + 1500 - 512, 512));
+        REQUIRE(q.stats().m_frames_overwritten == 88 + (1500 - 512));
+    }
+
+    SECTION("block waits for a consumer, then times out")
+    {
+        q.set_overflow_policy(overflow_policy::block, std::chrono::milliseconds(2000));
+        REQUIRE(push(0, 512));
+
+        std::thread consumer([&]
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            std::vector<float> drained(240 * 2);
+            REQUIRE(q.pop_float(drained) == drained.size());
+        });
+        REQUIRE(push(512, 240)); // Waits for the consumer
+        consumer.join();
+
+        REQUIRE(q.pop_float(popped) == popped.size());
+        REQUIRE(popped == frames_from(240, 512));
+
+        q.set_overflow_policy(overflow_policy::block, std::chrono::milliseconds(5));
+        REQUIRE(push(0, 512));
+        REQUIRE_FALSE(push(512, 10)); // Nobody pops : times out
+    }
+
+    SECTION("a blocked push does not hold a latency change back")
+    {
+        q.set_overflow_policy(overflow_policy::block, std::chrono::milliseconds(5000));
+        REQUIRE(push(0, 512));
+
+        std::thread producer([&] { push(512, 100); }); // Sleeps until the resize makes room
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        const auto start = std::chrono::steady_clock::now();
+        q.set_latency(20); // 1024 frames
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000));
+        producer.join();
+
+        REQUIRE(q.ready_frames() == 612);
+        REQUIRE(q.pop_float(popped) == popped.size());
+        REQUIRE(popped == frames_from(0, 512));
+    }
+}
+
+TEST_CASE("audio_queue pops and drops whole frames only", "[audio_queue]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    const auto storage = GENERATE(queue_storage::interleaved, queue_storage::planar);
+    audio_queue<float> q(ctx, 10, resample_quality::best, storage);
+
+    // Frame f holds (f, -f) : a split frame shifts the channels of every later one
+    std::vector<float> frames(10 * 2);
+    for (size_t f = 0; f < 10; ++f)
+    {
+        frames[f * 2]     = static_cast<float>(f);
+        frames[f * 2 + 1] = -static_cast<float>(f);
+    }
+    REQUIRE(q.push_audio(ctx, frames.data(), 10));
+
+    REQUIRE(q.discard(3) == 2);
+
+    std::vector<float> odd(5, 0.0f);
+    REQUIRE(q.pop_float(odd) == 4);
+    REQUIRE(odd[2] == 2.0f);
+    REQUIRE(odd[3] == -2.0f);
+    REQUIRE(odd[4] == 0.0f);
+
+    std::vector<float> accumulator(3, 0.0f);
+    REQUIRE(q.pop_add(accumulator) == 2);
+    REQUIRE(accumulator[0] == 3.0f);
+    REQUIRE(accumulator[1] == -3.0f);
+    REQUIRE(accumulator[2] == 0.0f);
+
+    REQUIRE(q.ready_frames() == 6);
+    std::vector<float> rest(6 * 2, 0.0f);
+    REQUIRE(q.pop_float(rest) == rest.size());
+    REQUIRE(rest[0] == 4.0f);
+    REQUIRE(rest[1] == -4.0f);
+}
+
+TEST_CASE("audio_queue waits for frames and room instead of polling", "[audio_queue][wait]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    audio_queue<float> q(ctx, 20); // 1024 frames
+    const size_t capacity = q.capacity_frames();
+    std::vector<float> period(100 * 2, 0.5f);
+
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE_FALSE(q.wait_for_frames(480, std::chrono::milliseconds(20)));
+    REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+
+    // Woken once 480 frames are there, by the fifth push of 100
+    std::thread producer([&]
+    {
+        for (size_t i = 0; i < 10; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            q.push_audio(ctx, period.data(), 100);
+        }
+    });
+    REQUIRE(q.wait_for_frames(480, std::chrono::seconds(5)));
+    REQUIRE(q.ready_frames() >= 480);
+    producer.join();
+    REQUIRE(q.wait_for_frames(capacity * 2, std::chrono::milliseconds(0)) == (q.ready_frames() == capacity)); // Capped at the capacity
+
+    // Full queue : a producer waits for room
+    std::vector<float> fill((capacity - q.ready_frames()) * 2, 0.5f);
+    REQUIRE(q.push_audio(ctx, fill.data(), fill.size() / 2));
+    REQUIRE_FALSE(q.wait_for_space(480, std::chrono::milliseconds(0)));
+
+    std::thread consumer([&]
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::vector<float> drained(512 * 2);
+        q.pop_float(drained);
+    });
+    REQUIRE(q.wait_for_space(480, std::chrono::seconds(5)));
+    REQUIRE(q.free_frames() >= 480);
+    consumer.join();
+}
+
+TEST_CASE("blocking producer and waiting consumer stream more than a capacity", "[audio_queue][wait]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    audio_queue<float> q(ctx, 10); // 512 frames
+    q.set_overflow_policy(overflow_policy::block, std::chrono::seconds(10));
+
+    constexpr size_t total  = 48000;
+    constexpr size_t period = 480;
+    std::vector<float> input(total * 2);
+    for (size_t i = 0; i < input.size(); ++i)
+        input[i] = static_cast<float>(i % 1000) / 1000.0f;
+
+    std::vector<float> received;
+    std::thread consumer([&]
+    {
+        std::vector<float> chunk(period * 2);
+        while (received.size() < input.size())
+        {
+            if (!q.wait_for_frames(period, std::chrono::seconds(10)))
+                break;
+            q.pop_float(chunk);
+            received.insert(received.end(), chunk.begin(), chunk.end());
+        }
+    });
+
+    REQUIRE(q.push_audio(ctx, input.data(), total)); // 94 capacities : sleeps for room, wakes the consumer
+    consumer.join();
+    REQUIRE(received == input);
+    REQUIRE(q.stats().m_samples_dropped == 0);
+}
+
+namespace
+{
+    // Coroutine started at once, destroyed when it ends : enough to await in tests.
+    struct detached_task
+    {
+        struct promise_type
+        {
+            detached_task get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    struct wait_outcome
+    {
+        bool   m_woken     = false;
+        size_t m_popped    = 0;
+        bool   m_timed_out = false;
+        bool   m_done      = false;
+    };
+
+    detached_task drain_once(audio_wait_service& service, audio_queue<float>& q, wait_outcome& outcome)
+    {
+        outcome.m_woken = co_await service.frames(q, 256, std::chrono::seconds(5));
+
+        std::vector<float> block(256 * 2);
+        outcome.m_popped    = q.pop_float(block) / 2;
+        outcome.m_timed_out = !co_await service.frames(q, 1, std::chrono::milliseconds(10)); // Nothing more comes
+        outcome.m_done      = true;
+    }
+}
+
+TEST_CASE("audio_wait_service resumes the coroutines of many queues from one thread", "[audio_queue][wait]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    constexpr size_t queues = 200;
+
+    std::vector<std::unique_ptr<audio_queue<float>>> q;
+    std::vector<wait_outcome> outcomes(queues);
+    audio_wait_service service;
+
+    for (size_t i = 0; i < queues; ++i)
+        q.push_back(std::make_unique<audio_queue<float>>(ctx, 20));
+    for (size_t i = 0; i < queues; ++i)
+        drain_once(service, *q[i], outcomes[i]);
+    REQUIRE(service.pending() == queues);
+
+    std::atomic<bool> stop{false};
+    std::thread serving([&]
+    {
+        while (!stop.load())
+            service.run_once(std::chrono::milliseconds(100));
+    });
+
+    // Two pushes per queue : the first one does not reach the level
+    std::vector<float> half(128 * 2, 0.25f);
+    for (size_t i = 0; i < queues; ++i)
+        q[i]->push_audio(ctx, half.data(), 128);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    for (size_t i = 0; i < queues; ++i)
+        q[i]->push_audio(ctx, half.data(), 128);
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (service.pending() != 0 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    stop.store(true);
+    service.wake();
+    serving.join();
+
+    for (const auto& outcome : outcomes)
+    {
+        REQUIRE(outcome.m_done);
+        REQUIRE(outcome.m_woken);
+        REQUIRE(outcome.m_popped == 256);
+        REQUIRE(outcome.m_timed_out);
+    }
+}
+
+TEST_CASE("audio_wait_service leaves no listener behind once destroyed", "[audio_queue][wait]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    audio_queue<float> q(ctx, 20);
+    wait_outcome outcome;
+
+    // The service lives in a buffer of the test : a signal() reaching it after destruction shows up in the bytes.
+    alignas(audio_wait_service) std::array<std::byte, sizeof(audio_wait_service)> storage;
+    auto* service = new (storage.data()) audio_wait_service;
+
+    drain_once(*service, q, outcome);
+    std::vector<float> block(256 * 2, 0.25f);
+    REQUIRE(q.push_audio(ctx, block.data(), 256));
+    while (!outcome.m_done)
+        service->run_once(std::chrono::milliseconds(20));
+    REQUIRE(outcome.m_popped == 256);
+    REQUIRE(service->pending() == 0);
+    service->~audio_wait_service();
+    std::ranges::fill(storage, std::byte{0xA5});
+
+    q.set_latency(40); // Signals every waiter and listener of the queue
+    REQUIRE(q.push_audio(ctx, block.data(), 256));
+    REQUIRE(std::ranges::all_of(storage, [](std::byte b) { return b == std::byte{0xA5}; }));
+}
+
+TEST_CASE("audio_queue drift compensation holds the target latency", "[audio_queue][drift]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    audio_queue<float> q(ctx, 100, resample_quality::linear);
+    q.set_drift_compensation({.m_target_latency = std::chrono::milliseconds(20), .m_response = std::chrono::milliseconds(1000)});
+
+    constexpr size_t period = 480;  // 10 ms
+    constexpr size_t target = 960;  // 20 ms
+    constexpr double drift  = 5e-4; // Producer clock 500 ppm fast
+
+    std::vector<float> input(2 * (period + 1), 0.25f);
+    std::vector<float> output(2 * period);
+
+    // Consumer starts once the target is reached
+    REQUIRE(q.push_audio(ctx, input.data(), period));
+    REQUIRE(q.push_audio(ctx, input.data(), period));
+
+    // One simulated minute : without compensation, the queue would grow by 30 ms
+    double owed = 0.0;
+    for (size_t p = 0; p < 6000; ++p)
+    {
+        REQUIRE(q.pop_float(output) == output.size());
+
+        owed += static_cast<double>(period) * drift;
+        const size_t extra = static_cast<size_t>(owed);
+        owed -= static_cast<double>(extra);
+        REQUIRE(q.push_audio(ctx, input.data(), period + extra));
+    }
+
+    const auto stats = q.stats();
+    REQUIRE(stats.m_underruns == 0);
+    REQUIRE(stats.m_samples_dropped == 0);
+    REQUIRE(stats.m_fill_frames > target - 48);
+    REQUIRE(stats.m_fill_frames < target + period + 48);
+    REQUIRE_THAT(stats.m_drift_ppm, WithinAbs(-500.0, 50.0));
+}
+
+TEST_CASE("audio_queue gain and pan ramps are applied inside the pop", "[audio_queue][control]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    const auto storage = GENERATE(queue_storage::interleaved, queue_storage::planar);
+    audio_queue<float> q(ctx, 20, resample_quality::best, storage);
+
+    constexpr size_t frames = 128;
+    std::vector<float> input(frames * 2, 0.5f);
+
+    SECTION("a gain ramp goes on across pops, then holds its target")
+    {
+        REQUIRE(q.push_audio(ctx, input.data(), frames));
+
+        std::vector<float> mixed(frames * 2, 0.0f);
+        q.control().set_gain(0.0f, 0);
+        REQUIRE(q.pop_add(std::span{mixed}.first(8 * 2)) == 8 * 2);
+        q.control().set_gain(1.0f, 64);
+        REQUIRE(q.pop_add(std::span{mixed}.subspan(8 * 2, 40 * 2)) == 40 * 2);
+        REQUIRE(q.pop_add(std::span{mixed}.subspan(48 * 2)) == (frames - 48) * 2);
+        for (size_t f = 0; f < frames; ++f)
+        {
+            const float expected = f < 8 ? 0.0f : 0.5f * std::min(1.0f, static_cast<float>(f - 8) / 64.0f);
+            REQUIRE_THAT(mixed[f * 2], WithinAbs(expected, 1e-5f));
+            REQUIRE_THAT(mixed[(f * 2) + 1], WithinAbs(expected, 1e-5f));
+        }
+        REQUIRE(mixed.back() == 0.5f); // Exactly the target once the ramp is over
+    }
+
+    SECTION("pan is constant power and unity at the centre")
+    {
+        q.control().set_pan(-1.0f, 0);
+        REQUIRE(q.push_audio(ctx, input.data(), frames));
+
+        std::vector<float> left(frames, 0.0f);
+        REQUIRE(q.pop_add(left) == frames);
+        REQUIRE_THAT(left[0], WithinAbs(0.5f * std::sqrt(2.0f), 1e-6f));
+        REQUIRE_THAT(left[1], WithinAbs(0.0f, 1e-6f));
+
+        q.control().set_pan(0.0f, 256);
+        std::vector<float> centre(frames * 2, 0.0f);
+        REQUIRE(q.pop_add(std::span{centre}.first(frames)) == frames);
+        for (size_t f = 0; f < frames / 2; ++f) // Left fades down, right fades up
+        {
+            REQUIRE(centre[f * 2] <= left[0]);
+            REQUIRE(centre[(f * 2) + 1] >= 0.0f);
+        }
+
+        q.control().set_pan(0.0f, 0);
+        REQUIRE(q.push_audio(ctx, input.data(), frames));
+        std::ranges::fill(centre, 0.0f);
+        REQUIRE(q.pop_add(centre) == frames * 2);
+        for (auto s : centre)
+            REQUIRE(s == 0.5f);
+    }
+
+    SECTION("pop_audio applies the same ramps as pop_add, in both layouts")
+    {
+        audio_queue<float> reference(ctx, 20, resample_quality::best, storage);
+        for (auto* queue : {&q, &reference})
+        {
+            queue->control().set_gain(0.25f, 0);
+            queue->control().set_gain(0.75f, 100);
+            queue->control().set_pan(0.5f, 50);
+            REQUIRE(queue->push_audio(ctx, input.data(), frames));
+        }
+
+        std::vector<float> added(frames * 2, 0.0f);
+        REQUIRE(reference.pop_add(added) == frames * 2);
+
+        std::vector<float> interleaved(frames * 2, 0.0f);
+        REQUIRE(q.pop_audio(ctx, interleaved.data(), frames / 2));
+        std::vector<float> left(frames / 2, 0.0f);
+        std::vector<float> right(frames / 2, 0.0f);
+        const std::array<float*, 2> planes{left.data(), right.data()};
+        REQUIRE(q.pop_audio(ctx, planes.data(), frames / 2));
+        for (size_t f = 0; f < frames / 2; ++f)
+        {
+            interleaved[frames + (f * 2)]     = left[f];
+            interleaved[frames + (f * 2) + 1] = right[f];
+        }
+
+        for (size_t i = 0; i < added.size(); ++i)
+            REQUIRE_THAT(interleaved[i], WithinAbs(added[i], 1e-6f));
+    }
+}
+
+TEST_CASE("mix_control leaves centre, LFE and mono channels unpanned", "[control]")
+{
+    mix_control surround(channel_layout::FivePointOne);
+    surround.set_pan(1.0f, 0);
+    auto gains = surround.begin();
+
+    std::array<float, 6> frame{};
+    const std::array<float, 6> ones{1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+    gains.accumulate(frame.data(), ones.data(), 0, 1);
+    REQUIRE_THAT(frame[0], WithinAbs(0.0f, 1e-6f)); // L
+    REQUIRE_THAT(frame[1], WithinAbs(std::sqrt(2.0f), 1e-6f)); // R
+    REQUIRE(frame[2] == 1.0f); // C
+    REQUIRE(frame[3] == 1.0f); // LFE
+    REQUIRE_THAT(frame[4], WithinAbs(0.0f, 1e-6f)); // Ls
+    REQUIRE_THAT(frame[5], WithinAbs(std::sqrt(2.0f), 1e-6f)); // Rs
+
+    mix_control mono(channel_layout::Mono);
+    mono.set_pan(-1.0f, 0);
+    REQUIRE(mono.begin().m_steady[0] == 1.0f);
+}
+
+TEST_CASE("audio_queue capacity : power of two frames, int16 storage, runtime latency", "[audio_queue][capacity]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+
+    // Frame f holds (f, -f)
+    auto frames_from = [](size_t first, size_t count)
+    {
+        std::vector<float> frames(count * 2);
+        for (size_t f = 0; f < count; ++f)
+        {
+            frames[f * 2]     = static_cast<float>(first + f) / 8192.0f;
+            frames[f * 2 + 1] = -static_cast<float>(first + f) / 8192.0f;
+        }
+        return frames;
+    };
+
+    SECTION("int16 storage halves the memory")
+    {
+        const auto storage = GENERATE(queue_storage::interleaved, queue_storage::planar);
+        audio_queue<float> wide(ctx, 100, resample_quality::best, storage);
+        audio_queue<float> narrow(ctx, 100, resample_quality::best, storage, queue_precision::int16);
+        REQUIRE(wide.capacity_frames() == 8192);
+        REQUIRE(narrow.capacity_frames() == 8192);
+        REQUIRE(narrow.footprint() * 2 == wide.footprint());
+
+        auto input = frames_from(0, 3000);
+        REQUIRE(narrow.push_audio(ctx, input.data(), 3000));
+        std::vector<float> output(input.size());
+        REQUIRE(narrow.pop_float(output) == output.size());
+        for (size_t i = 0; i < output.size(); ++i)
+            REQUIRE_THAT(output[i], WithinAbs(input[i], 1.0 / 32768.0));
+    }
+
+    SECTION("set_latency keeps the newest frames")
+    {
+        audio_queue<float> q(ctx, 10);
+        REQUIRE(q.capacity_frames() == 512);
+
+        auto input = frames_from(0, 300);
+        REQUIRE(q.push_audio(ctx, input.data(), 300));
+
+        q.set_latency(100);
+        REQUIRE(q.capacity_frames() == 8192);
+        REQUIRE(q.stats().m_fill_frames == 300);
+
+        q.set_latency(5); // 240 frames, rounded up to 256
+        REQUIRE(q.capacity_frames() == 256);
+        REQUIRE(q.stats().m_frames_overwritten == 300 - 256);
+
+        std::vector<float> output(256 * 2);
+        REQUIRE(q.pop_float(output) == output.size());
+        REQUIRE(output == frames_from(300 - 256, 256));
+    }
+
+    SECTION("set_latency while a producer and a consumer run")
+    {
+        audio_queue<float> q(ctx, 20);
+        q.set_overflow_policy(overflow_policy::drop_push); // A retried block is never partly in the queue already
+        std::atomic<bool> done{false};
+
+        std::thread producer([&]
+        {
+            size_t next = 0;
+            while (!done.load())
+            {
+                auto block = frames_from(next, 64);
+                if (q.push_audio(ctx, block.data(), 64))
+                    next += 64;
+            }
+        });
+
+        // Frames come out whole, in order, but some may be dropped around a swap
+        bool   ordered = true;
+        float  last    = -1.0f;
+        std::thread consumer([&]
+        {
+            std::vector<float> block(64 * 2);
+            while (!done.load())
+            {
+                const size_t popped = q.pop_float(block);
+                for (size_t i = 0; i < popped; i += 2)
+                {
+                    ordered &= block[i] == -block[i + 1];
+                    ordered &= block[i] > last;
+                    last = block[i];
+                }
+            }
+        });
+
+        for (size_t latency : {5, 50, 10, 200, 20})
+        {
+            q.set_latency(latency);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        done.store(true);
+        producer.join();
+        consumer.join();
+
+        REQUIRE(ordered);
+        REQUIRE(q.capacity_frames() == 1024);
+    }
+}
+
+TEST_CASE("audio_ring bulk transfers wrap around", "[audio_ring]")
+{
+    audio_ring ring(100);
+
+    std::vector<float> block(70);
+    std::iota(block.begin(), block.end(), 0.0f);
+    std::vector<float> out(70, -1.0f);
+
+    // Fill, drain, then write across the end of the buffer
+    REQUIRE(ring.write(block.data(), 70) == 70);
+    REQUIRE(ring.read(out.data(), 70) == 70);
+    REQUIRE(out == block);
+
+    REQUIRE(ring.write(block.data(), 70) == 70);
+    REQUIRE(ring.free() == 30);
+    REQUIRE(ring.write(block.data(), 70) == 30); // Only what fits
+
+    std::vector<float> wrapped(100, -1.0f);
+    REQUIRE(ring.read(wrapped.data(), 100) == 100);
+    REQUIRE(std::equal(block.begin(), block.end(), wrapped.begin()));
+    REQUIRE(std::equal(block.begin(), block.begin() + 30, wrapped.begin() + 70));
+    REQUIRE(ring.size() == 0);
+}
+
+TEST_CASE("fused push maps frames straight into the ring across wrap-around", "[audio_queue][pipeline]")
+{
+    audio_ctx input_ctx{sample_rate::SR48000, "5.1"};
+    audio_ctx output_ctx{sample_rate::SR48000, "Stereo"};
+    audio_queue<int16_t> q(output_ctx, 10); // 480 frames : pushes below wrap around the ring
+
+    const auto& matrix = channel_matrix_for(channel_layout::FivePointOne, channel_layout::Stereo);
+    const auto to_float = make_audio_converters<int16_t>().first;
+
+    std::vector<int16_t> input(300 * 6);
+    std::vector<float>   popped(300 * 2);
+    for (int round = 0; round < 7; ++round)
+    {
+        for (size_t i = 0; i < input.size(); ++i)
+            input[i] = static_cast<int16_t>((i * 37 + round * 1001) % 20000) - 10000;
+
+        REQUIRE(q.push_audio(input_ctx, input.data(), 300));
+        REQUIRE(q.pop_float(popped) == popped.size());
+
+        for (size_t frame = 0; frame < 300; ++frame)
+            for (size_t out = 0; out < 2; ++out)
+            {
+                float expected = 0.0f;
+                for (size_t in = 0; in < 6; ++in)
+                    if (matrix.at(out, in) != 0.0f)
+                        expected += matrix.at(out, in) * to_float(input[frame * 6 + in]);
+                REQUIRE_THAT(popped[frame * 2 + out], WithinAbs(expected, 1e-6f));
+            }
+    }
+
+    // A push larger than the free space keeps whole frames only
+    std::vector<int16_t> large(600 * 6, 1000);
+    REQUIRE_FALSE(q.push_audio(input_ctx, large.data(), 600));
+    REQUIRE(q.pop_float(popped) == popped.size());
+}
+
+TEST_CASE("planar push/pop and planar storage match the interleaved queue", "[audio_queue][planar]")
+{
+    const auto storage  = GENERATE(queue_storage::interleaved, queue_storage::planar);
+    const auto in_rate  = GENERATE(sample_rate::SR48000, sample_rate::SR44100);
+    audio_ctx input_ctx{in_rate, "5.1"};
+    audio_ctx output_ctx{sample_rate::SR48000, "Stereo"};
+
+    audio_queue<int16_t> reference(output_ctx, 20);
+    audio_queue<int16_t> q(output_ctx, 20, resample_quality::best, storage);
+    REQUIRE(q.storage() == storage);
+
+    constexpr size_t frames = 300;
+    std::vector<int16_t> interleaved(frames * 6);
+    std::array<std::vector<int16_t>, 6> planes;
+    for (auto& plane : planes)
+        plane.resize(frames);
+
+    std::vector<int16_t> expected(frames);
+    std::array<std::vector<int16_t>, 2> popped{std::vector<int16_t>(frames / 2), std::vector<int16_t>(frames / 2)};
+    std::vector<int16_t> popped_interleaved(frames);
+
+    for (int round = 0; round < 5; ++round) // 960 frames of storage : pops wrap around
+    {
+        for (size_t i = 0; i < interleaved.size(); ++i)
+        {
+            interleaved[i] = static_cast<int16_t>(((i * 37 + round * 1001) % 20000) - 10000);
+            planes[i % 6][i / 6] = interleaved[i];
+        }
+        const std::array<const int16_t*, 6> channels{planes[0].data(), planes[1].data(), planes[2].data(),
+                                                     planes[3].data(), planes[4].data(), planes[5].data()};
+
+        REQUIRE(reference.push_audio(input_ctx, interleaved.data(), frames));
+        REQUIRE(q.push_audio(input_ctx, channels.data(), frames));
+
+        // Half of the rounds pop planar, the other half interleaved : both match the reference bit for bit
+        constexpr size_t available = frames / 2;
+        std::ranges::fill(expected, 0);
+        REQUIRE(reference.pop_audio(output_ctx, expected.data(), available));
+
+        if (round % 2 == 0)
+        {
+            std::ranges::fill(popped[0], 0);
+            std::ranges::fill(popped[1], 0);
+            const std::array<int16_t*, 2> outputs{popped[0].data(), popped[1].data()};
+            REQUIRE(q.pop_audio(output_ctx, outputs.data(), available));
+            for (size_t f = 0; f < available; ++f)
+            {
+                REQUIRE(popped[0][f] == expected[f * 2]);
+                REQUIRE(popped[1][f] == expected[f * 2 + 1]);
+            }
+        }
+        else
+        {
+            std::ranges::fill(popped_interleaved, 0);
+            REQUIRE(q.pop_audio(output_ctx, popped_interleaved.data(), available));
+            REQUIRE(popped_interleaved == expected);
+        }
+
+        // The raw float paths interleave planar storage on the fly
+        std::vector<float> reference_rest(256), rest(256, 0.0f);
+        REQUIRE(reference.pop_float(reference_rest) == q.pop_add(rest, 1.0f));
+        REQUIRE(reference_rest == rest);
+        REQUIRE(reference.discard(frames * 4) == q.discard(frames * 4));
+    }
+}
+
+TEST_CASE("audio_ring claims give back or pad what they did not use", "[audio_ring]")
+{
+    audio_ring ring(64);
+
+    // A later claim exists : the unused rest of the first one is published as silence
+    const auto first  = ring.begin_write(16);
+    const auto second = ring.begin_write(16);
+    REQUIRE(second.m_start == first.m_start + 16);
+    std::fill_n(ring.plane_at<float>(0, second.m_start), 16, 2.0f);
+    std::fill_n(ring.plane_at<float>(0, first.m_start), 16, 1.0f);
+    REQUIRE(ring.end_write(first, 8) == 16);
+    REQUIRE(ring.end_write(second, 16) == 16);
+
+    std::vector<float> out(32, -1.0f);
+    REQUIRE(ring.read(out.data(), 32) == 32);
+    REQUIRE(std::all_of(out.begin(), out.begin() + 8, [](float s) { return s == 1.0f; }));
+    REQUIRE(std::all_of(out.begin() + 8, out.begin() + 16, [](float s) { return s == 0.0f; }));
+    REQUIRE(std::all_of(out.begin() + 16, out.end(), [](float s) { return s == 2.0f; }));
+
+    // The last claim gives its rest back, for writes and reads alike
+    const auto write = ring.begin_write(40);
+    REQUIRE(ring.contiguous(write.m_start) == 32);
+    REQUIRE(ring.end_write(write, 4) == 4);
+    REQUIRE(ring.size() == 4);
+
+    const auto read = ring.begin_read(4);
+    REQUIRE(read.m_size == 4);
+    REQUIRE(ring.end_read(read, 1) == 1);
+    REQUIRE(ring.size() == 3);
+}
+
+TEST_CASE("audio_queue lends ring memory to write and read frames in place", "[audio_queue][in_place]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    const auto storage = GENERATE(queue_storage::interleaved, queue_storage::planar);
+    audio_queue<float> q(ctx, 10, resample_quality::best, storage); // 512 frames
+    REQUIRE(q.capacity_frames() == 512);
+
+    const auto sample = [](size_t frame, size_t channel) { return static_cast<float>(frame) + (channel == 0 ? 0.0f : 0.5f); };
+
+    // Move the positions near the end of the buffer : the views below wrap around
+    std::vector<float> skip(400 * 2, 0.0f);
+    REQUIRE(q.push_audio(ctx, skip.data(), 400));
+    REQUIRE(q.discard(400 * 2) == 400 * 2);
+
+    auto write = q.acquire_write(300);
+    REQUIRE(write.frames() == 300);
+    REQUIRE(write.regions() == 2);
+    REQUIRE(write.region_frames(0) == 112);
+    REQUIRE(write.region_frames(1) == 188);
+
+    size_t frame = 0;
+    for (size_t region = 0; region < write.regions(); ++region)
+        for (size_t f = 0; f < write.region_frames(region); ++f, ++frame)
+            for (size_t c = 0; c < 2; ++c)
+                if (storage == queue_storage::interleaved)
+                    write.interleaved(region)[(f * 2) + c] = sample(frame, c);
+                else
+                    write.channel(region, c)[f] = sample(frame, c);
+
+    // Only what was rendered is published, moving the view does not publish twice
+    auto moved = std::move(write);
+    REQUIRE(write.commit(300) == 0);
+    REQUIRE(moved.commit(250) == 250);
+    REQUIRE(moved.commit(250) == 0);
+    REQUIRE(q.ready_frames() == 250);
+
+    auto read = q.acquire_read(1000);
+    REQUIRE(read.frames() == 250);
+    REQUIRE(read.region_frames(0) == 112);
+    frame = 0;
+    for (size_t region = 0; region < read.regions(); ++region)
+        for (size_t f = 0; f < read.region_frames(region); ++f, ++frame)
+            for (size_t c = 0; c < 2; ++c)
+            {
+                const float stored = storage == queue_storage::interleaved ? read.interleaved(region)[(f * 2) + c] : read.channel(region, c)[f];
+                REQUIRE(stored == sample(frame, c));
+            }
+    REQUIRE(read.release(100) == 100);
+    REQUIRE(q.ready_frames() == 150);
+
+    // Copying pops see the frames left, in order
+    std::vector<float> rest(150 * 2, 0.0f);
+    REQUIRE(q.pop_float(rest) == rest.size());
+    for (size_t f = 0; f < 150; ++f)
+    {
+        REQUIRE(rest[f * 2] == sample(f + 100, 0));
+        REQUIRE(rest[(f * 2) + 1] == sample(f + 100, 1));
+    }
+
+    // Views dropped without commit or release change nothing
+    {
+        auto unused = q.acquire_write(64);
+        REQUIRE(unused.frames() == 64);
+    }
+    REQUIRE(q.ready_frames() == 0);
+    REQUIRE(q.free_frames() == 512);
+    REQUIRE(q.acquire_read(64).frames() == 0);
+
+    // The latency can change once the views are gone
+    q.set_latency(20);
+    REQUIRE(q.acquire_write(2000).frames() == 1024);
+
+    // No view on int16 storage : the samples are not floats
+    audio_queue<float> narrow(ctx, 10, resample_quality::best, storage, queue_precision::int16);
+    REQUIRE(narrow.acquire_write(64).frames() == 0);
+    REQUIRE(narrow.acquire_read(64).frames() == 0);
+}
+
+TEST_CASE("claims abandoned in reverse order keep the ring moving", "[audio_ring][in_place]")
+{
+    // The later claim ends first, from another thread : it waits for the earlier one, then gives its room back
+    audio_ring ring(64);
+
+    const auto first  = ring.begin_write(16);
+    const auto second = ring.begin_write(16);
+    std::thread abandon_write([&] { ring.end_write(second, 0); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const size_t published = ring.end_write(first, 8);
+    abandon_write.join();
+    REQUIRE(published == 16);
+    REQUIRE(ring.size() == 16);
+
+    const auto next = ring.begin_write(8);
+    REQUIRE(next.m_start == 16);
+    REQUIRE(ring.end_write(next, 8) == 8);
+    REQUIRE(ring.size() == 24);
+
+    const auto first_read  = ring.begin_read(8);
+    const auto second_read = ring.begin_read(8);
+    std::thread abandon_read([&] { ring.end_read(second_read, 0); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const size_t released = ring.end_read(first_read, 4);
+    abandon_read.join();
+    REQUIRE(released == 8);
+    REQUIRE(ring.size() == 16);
+
+    std::vector<float> out(16, -1.0f);
+    REQUIRE(ring.read(out.data(), 16) == 16);
+    REQUIRE(ring.size() == 0);
+
+    // Same through the queue views
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    const auto storage = GENERATE(queue_storage::interleaved, queue_storage::planar);
+    audio_queue<float> q(ctx, 10, resample_quality::best, storage); // 512 frames
+
+    auto write_first  = q.acquire_write(16);
+    auto write_second = q.acquire_write(16);
+    REQUIRE(write_second.frames() == 16);
+    std::thread drop_write([view = std::move(write_second)]() mutable { view.commit(0); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const size_t committed = write_first.commit(8);
+    drop_write.join();
+    REQUIRE(committed == 16);
+    REQUIRE(q.ready_frames() == 16);
+
+    std::vector<float> frames(100 * 2, 1.0f);
+    REQUIRE(q.push_audio(ctx, frames.data(), 100));
+    REQUIRE(q.ready_frames() == 116);
+
+    auto read_first  = q.acquire_read(8);
+    auto read_second = q.acquire_read(8);
+    REQUIRE(read_second.frames() == 8);
+    std::thread drop_read([view = std::move(read_second)]() mutable { view.release(0); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const size_t freed = read_first.release(4);
+    drop_read.join();
+    REQUIRE(freed == 8);
+    REQUIRE(q.ready_frames() == 108);
+
+    std::vector<float> rest(108 * 2, 0.0f);
+    REQUIRE(q.pop_float(rest) == rest.size());
+    REQUIRE(q.ready_frames() == 0);
+}
+
+TEST_CASE("audio_ring concurrent producers and consumers lose nothing", "[audio_ring]")
+{
+    audio_ring ring(1024);
+
+    constexpr size_t producer_count = 4;
+    constexpr size_t consumer_count = 2;
+    constexpr size_t block_count    = 2000;
+    constexpr size_t block_size     = 48;
+    constexpr size_t total_samples  = producer_count * block_count * block_size;
+
+    std::atomic<size_t> consumed{0};
+    std::atomic<size_t> consumed_sum{0};
+
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producer_count; ++p)
+        threads.emplace_back([&ring, p]
+        {
+            // Each producer writes its own id + 1
+            std::vector<float> block(block_size, static_cast<float>(p + 1));
+            for (size_t b = 0; b < block_count; ++b)
+                for (size_t written = 0; written < block_size;)
+                    written += ring.write(block.data() + written, block_size - written);
+        });
+
+    for (size_t c = 0; c < consumer_count; ++c)
+        threads.emplace_back([&]
+        {
+            std::vector<float> block(block_size);
+            size_t sum = 0;
+            while (consumed.load() < total_samples)
+            {
+                const size_t got = ring.read(block.data(), block_size);
+                for (size_t i = 0; i < got; ++i)
+                    sum += static_cast<size_t>(block[i]);
+                consumed += got;
+            }
+            consumed_sum += sum;
+        });
+
+    for (auto& t : threads)
+        t.join();
+
+    REQUIRE(consumed.load() == total_samples);
+    REQUIRE(consumed_sum.load() == block_count * block_size * (1 + 2 + 3 + 4));
+    REQUIRE(ring.size() == 0);
+}
+
+TEST_CASE("block converters match make_audio_converters bit for bit", "[convert]")
+{
+    // Float sweep beyond [-1, 1] to cover clamping, with an odd size to cover the scalar tails
+    std::vector<float> floats;
+    for (int i = -70000; i <= 70000; ++i)
+        floats.push_back(static_cast<float>(i) / 65536.0f);
+    floats.push_back(1.0f);
+    floats.push_back(-1.0f);
+
+    auto check = [&]<typename T>(const std::vector<T>& samples)
+    {
+        auto [to_float, from_float] = make_audio_converters<T>();
+
+        std::vector<float> as_float(samples.size());
+        convert_to_float(std::span<const T>{samples}, std::span{as_float});
+        size_t mismatches = 0;
+        for (size_t i = 0; i < samples.size(); ++i)
+            mismatches += std::bit_cast<uint32_t>(as_float[i]) != std::bit_cast<uint32_t>(to_float(samples[i]));
+        REQUIRE(mismatches == 0);
+
+        std::vector<T> back(floats.size());
+        convert_from_float(std::span<const float>{floats}, std::span{back});
+        for (size_t i = 0; i < floats.size(); ++i)
+            mismatches += back[i] != from_float(floats[i]);
+        REQUIRE(mismatches == 0);
+    };
+
+    SECTION("int16_t")
+    {
+        std::vector<int16_t> samples(65536 + 3);
+        for (size_t i = 0; i < samples.size(); ++i)
+            samples[i] = static_cast<int16_t>(i);
+        check(samples);
+    }
+
+    SECTION("int32_t")
+    {
+        std::vector<int32_t> samples;
+        for (int64_t v = std::numeric_limits<int32_t>::min(); v <= std::numeric_limits<int32_t>::max(); v += 65537 * 3)
+            samples.push_back(static_cast<int32_t>(v));
+        samples.push_back(std::numeric_limits<int32_t>::max());
+        check(samples);
+    }
+
+    SECTION("uint8_t")
+    {
+        std::vector<uint8_t> samples(256 + 5);
+        for (size_t i = 0; i < samples.size(); ++i)
+            samples[i] = static_cast<uint8_t>(i);
+        check(samples);
+    }
+
+    SECTION("int24_packed")
+    {
+        std::vector<int24_packed> samples;
+        for (int32_t v = -(1 << 23); v < (1 << 23); v += 97)
+            samples.push_back(int24_packed::from_value(v));
+        samples.push_back(int24_packed::from_value((1 << 23) - 1));
+        check(samples);
+    }
+
+    SECTION("int24_in_32")
+    {
+        // The upper byte is ignored on input : set it to garbage on half of the samples
+        std::vector<int24_in_32> samples;
+        for (int32_t v = -(1 << 23); v < (1 << 23); v += 97)
+            samples.push_back({(v & 1) != 0 ? static_cast<int32_t>(static_cast<uint32_t>(v) ^ 0x5A000000U) : v});
+        samples.push_back({(1 << 23) - 1});
+        check(samples);
+    }
+}
+
+TEST_CASE("soft_limit keeps samples below the knee and bends the rest under full scale", "[convert]")
+{
+    constexpr float knee = 0.9f;
+
+    // Odd size : vector body and scalar tail
+    std::vector<float> samples;
+    for (float v = -4.0f; v <= 4.0f; v += 0.0137f)
+        samples.push_back(v);
+    samples.push_back(0.0f);
+    samples.push_back(-0.0f);
+    const auto input = samples;
+
+    soft_limit(samples, knee);
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        const float magnitude = std::fabs(input[i]);
+        if (magnitude <= knee)
+            REQUIRE(samples[i] == input[i]);
+        else
+        {
+            const float excess = magnitude - knee;
+            const float curve  = knee + ((1.0f - knee) * excess / ((1.0f - knee) + excess));
+            REQUIRE_THAT(samples[i], WithinAbs(std::copysign(curve, input[i]), 1e-6f));
+            REQUIRE(std::fabs(samples[i]) < 1.0f);
+        }
+        if (i > 0 && input[i] > input[i - 1])
+            REQUIRE(samples[i] >= samples[i - 1]); // Monotonic
+    }
+}
+
+TEST_CASE("audio_queue push/pop packed 24-bit and 24-in-32", "[audio_queue][convert]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+
+    auto round_trip = [&]<typename T>(T)
+    {
+        audio_queue<T> q(ctx);
+        constexpr size_t frames = 333;
+
+        std::vector<T> input(frames * 2);
+        for (size_t i = 0; i < input.size(); ++i)
+            input[i] = T::from_value(static_cast<int32_t>((i * 40503) % (1 << 24)) - (1 << 23));
+
+        std::vector<T> output(frames * 2);
+        REQUIRE(q.push_audio(ctx, input.data(), frames));
+        REQUIRE(q.pop_audio(ctx, output.data(), frames));
+
+        // 24 bits fit a float mantissa : the round trip is exact
+        for (size_t i = 0; i < input.size(); ++i)
+            REQUIRE(output[i].value() == input[i].value());
+    };
+
+    round_trip(int24_packed{});
+    round_trip(int24_in_32{});
+
+    const auto [to_float, from_float] = make_audio_converters<int24_packed>();
+    REQUIRE(from_float(1.0f).value() == (1 << 23) - 1);
+    REQUIRE(from_float(-1.0f).value() == -(1 << 23));
+    REQUIRE(to_float(int24_packed::from_value(-(1 << 23))) == -1.0f);
+}
+
+TEST_CASE("specialized remix kernels match the channel matrices", "[channel]")
+{
+    const std::array<channel_layout, 4> layouts{channel_layout::Mono, channel_layout::Stereo,
+                                                channel_layout::FivePointOne, channel_layout::SevenPointOne};
+    constexpr size_t frames = 37;
+
+    for (auto origin : layouts)
+        for (auto target : layouts)
+        {
+            const size_t in_ch  = origin;
+            const size_t out_ch = target;
+            auto input = generate_ramp<float>(frames, in_ch, -0.5f, 0.013f);
+
+            std::vector<float> output(frames * out_ch, -2.0f);
+            remix_for(origin, target)(input.data(), output.data(), frames);
+
+            const auto matrix = origin.matrix_to(target);
+            for (size_t f = 0; f < frames; ++f)
+                for (size_t o = 0; o < out_ch; ++o)
+                {
+                    const float expected = std::inner_product(matrix[o].begin(), matrix[o].end(), &input[f * in_ch], 0.0f);
+                    REQUIRE(output[(f * out_ch) + o] == expected);
+                }
+        }
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST_CASE("shared_audio_queue carries frames between two attachments of a segment", "[shared_audio_queue]")
+{
+    const std::string name = "/audio_queue_test_" + std::to_string(getpid());
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+
+    auto consumer = shared_audio_queue<float>::create(name, shared_queue_role::consumer, ctx, 20, resample_quality::best,
+                                                      queue_storage::planar, queue_precision::int16);
+    REQUIRE(consumer);
+    REQUIRE(consumer->peer() == shared_queue_peer::absent);
+    REQUIRE_FALSE(shared_audio_queue<float>::create(name, shared_queue_role::consumer, ctx)); // The name is taken
+
+    // The producer takes the creator's format, and pushes int16 into the same ring
+    auto producer = shared_audio_queue<int16_t>::open(name, shared_queue_role::producer);
+    REQUIRE(producer);
+    REQUIRE(producer->queue().context() == ctx);
+    REQUIRE(producer->queue().storage() == queue_storage::planar);
+    REQUIRE(producer->queue().precision() == queue_precision::int16);
+    REQUIRE(consumer->peer() == shared_queue_peer::attached);
+
+    const size_t frames = 300;
+    std::vector<int16_t> input(frames * 2);
+    for (size_t i = 0; i < input.size(); ++i)
+        input[i] = static_cast<int16_t>((i * 37) % 20000);
+    REQUIRE(producer->push_audio(ctx, input.data(), frames));
+    REQUIRE(consumer->queue().ready_frames() == frames);
+    REQUIRE(consumer->wait_for_frames(frames, std::chrono::milliseconds{0}));
+
+    std::vector<float> output(frames * 2);
+    REQUIRE(consumer->queue().pop_float(output) == output.size());
+    for (size_t i = 0; i < input.size(); ++i)
+        REQUIRE(output[i] == static_cast<float>(input[i]) / 32768.0f);
+
+    // A shared ring keeps its capacity
+    const size_t capacity = consumer->queue().capacity_frames();
+    consumer->queue().set_latency(200);
+    REQUIRE(consumer->queue().capacity_frames() == capacity);
+
+    producer.reset();
+    REQUIRE(consumer->peer() == shared_queue_peer::detached);
+    REQUIRE_FALSE(consumer->wait_for_frames(1, std::chrono::seconds{5})); // Returns at once : nobody will push
+
+    consumer.reset();
+    REQUIRE_FALSE(shared_audio_queue<float>::open(name, shared_queue_role::producer)); // The creator removed the name
+}
+
+TEST_CASE("shared_audio_queue wakes a sleeping consumer and sees its producer die", "[shared_audio_queue]")
+{
+    const std::string name = "/audio_queue_test_fork_" + std::to_string(getpid());
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    const size_t frames = 480;
+
+    auto consumer = shared_audio_queue<float>::create(name, shared_queue_role::consumer, ctx, 100);
+    REQUIRE(consumer);
+
+    const pid_t child = fork();
+    REQUIRE(child >= 0);
+    if (child == 0)
+    {
+        // Producer process : attach, let the consumer fall asleep, push once, then die without detaching.
+        auto producer = shared_audio_queue<float>::open(name, shared_queue_role::producer);
+        std::vector<float> period(frames * 2, 0.25f);
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        const bool pushed = producer && producer->push_audio(ctx, period.data(), frames);
+        _exit(pushed ? 0 : 1);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE(consumer->wait_for_frames(frames, std::chrono::seconds{10}));
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds{5}); // Woken, not timed out
+
+    std::vector<float> output(frames * 2);
+    REQUIRE(consumer->queue().pop_float(output) == output.size());
+    REQUIRE(output.front() == 0.25f);
+    REQUIRE(output.back() == 0.25f);
+
+    int status = 0;
+    REQUIRE(waitpid(child, &status, 0) == child);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+
+    REQUIRE(consumer->peer() == shared_queue_peer::lost);
+    REQUIRE_FALSE(consumer->wait_for_frames(1, std::chrono::seconds{5}));
+
+    // Its side is free again : a new producer attaches
+    REQUIRE(shared_audio_queue<float>::open(name, shared_queue_role::producer));
+}
+#endif
@@ -0,0 +1,616 @@
+#include <catch2/catch_all.hpp>
+#include "audio_mixer.h"
+#include "offline_mixdown.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+using Catch::Matchers::WithinAbs;
+
+TEST_CASE("audio_mixer sums inputs with gain and clamps once", "[audio_mixer]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    audio_mixer<float> mixer(ctx);
+
+    auto a = mixer.add_input();
+    auto b = mixer.add_input();
+    auto c = mixer.add_input();
+    REQUIRE(a);
+    REQUIRE(b);
+    REQUIRE(c);
+
+    std::vector<float> loud(64 * 2, 0.8f);
+    std::vector<float> quiet(64 * 2, -0.7f);
+    std::vector<float> soft(64 * 2, 0.25f);
+
+    mixer.set_gain(*c, 0.5f, 0);
+    REQUIRE(mixer.input_queue(*a)->push_audio(ctx, loud.data(), 64));
+    REQUIRE(mixer.input_queue(*b)->push_audio(ctx, quiet.data(), 64));
+    REQUIRE(mixer.input_queue(*c)->push_audio(ctx, soft.data(), 64));
+
+    // 0.8 + (-0.7) + 0.5 * 0.25 : no intermediate clamp of 0.8 + ...
+    std::vector<float> output(64 * 2, 1.0f);
+    REQUIRE(mixer.mix(output.data(), 64));
+    for (auto s : output)
+        REQUIRE_THAT(s, WithinAbs(0.225f, 1e-6f));
+}
+
+TEST_CASE("audio_mixer limits the whole sum once, whatever the input order", "[audio_mixer]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    const std::array<float, 3> levels{0.9f, 0.8f, -0.75f};
+
+    const auto mix_in_order = [&](std::array<size_t, 3> order, const output_stage& stage)
+    {
+        audio_mixer<float> mixer(ctx);
+        REQUIRE(mixer.set_output_stage(stage));
+        for (auto index : order)
+        {
+            auto id = mixer.add_input();
+            std::vector<float> input(64 * 2, levels[index]);
+            REQUIRE(mixer.input_queue(*id)->push_audio(ctx, input.data(), 64));
+        }
+        std::vector<float> output(64 * 2);
+        REQUIRE(mixer.mix(output.data(), 64));
+        return output;
+    };
+
+    // 0.9 + 0.8 clips on its own : a per-input clamp would give 0.25 in this order, 0.95 in the other
+    const auto forward  = mix_in_order({0, 1, 2}, {.m_limiter = limiter_mode::clamp});
+    const auto backward = mix_in_order({2, 1, 0}, {.m_limiter = limiter_mode::clamp});
+    for (size_t i = 0; i < forward.size(); ++i)
+    {
+        REQUIRE_THAT(forward[i], WithinAbs(0.95f, 1e-6f));
+        REQUIRE_THAT(backward[i], WithinAbs(0.95f, 1e-6f));
+    }
+
+    // Soft knee : 0.95 is bent below itself, a loud sum stays under full scale
+    const auto soft = mix_in_order({0, 1, 2}, {});
+    REQUIRE(soft[0] > 0.9f);
+    REQUIRE(soft[0] < 0.95f);
+    const auto loud = mix_in_order({0, 1, 1}, {});
+    REQUIRE(loud[0] > soft[0]);
+    REQUIRE(loud[0] < 1.0f);
+}
+
+TEST_CASE("audio_mixer dithers integer outputs on request", "[audio_mixer]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    audio_mixer<int16_t> mixer(ctx);
+    auto id = mixer.add_input();
+    REQUIRE(id);
+
+    std::vector<int16_t> silence(480 * 2, 0);
+    std::vector<int16_t> output(480 * 2);
+
+    REQUIRE(mixer.input_queue(*id)->push_audio(ctx, silence.data(), 480));
+    REQUIRE(mixer.mix(output.data(), 480));
+    REQUIRE(std::ranges::all_of(output, [](int16_t s) { return s == 0; }));
+
+    REQUIRE(mixer.set_output_stage({.m_dither = true}));
+    REQUIRE(mixer.input_queue(*id)->push_audio(ctx, silence.data(), 480));
+    REQUIRE(mixer.mix(output.data(), 480));
+
+    // Triangular noise of 1 LSB peak : rounded to -1, 0 or 1, and not always 0
+    REQUIRE(std::ranges::all_of(output, [](int16_t s) { return s >= -1 && s <= 1; }));
+    REQUIRE(std::ranges::any_of(output, [](int16_t s) { return s != 0; }));
+
+    // Concurrent consumers of the render thread dither with generators of their own
+    std::vector<int16_t> tone(4800 * 2, 0);
+    REQUIRE(mixer.input_queue(*id)->push_audio(ctx, tone.data(), 4800));
+    render_config config;
+    config.m_output_latency_ms = 200;
+    REQUIRE(mixer.start(config));
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    mixer.stop();
+
+    std::array<bool, 2>        in_range{true, true};
+    std::array<std::thread, 2> consumers;
+    for (std::size_t consumer = 0; consumer < consumers.size(); ++consumer)
+        consumers[consumer] = std::thread([&, consumer]
+        {
+            std::vector<int16_t> block(240 * 2);
+            while (mixer.read(block.data(), 240))
+                in_range[consumer] = in_range[consumer] && std::ranges::all_of(block, [](int16_t s) { return s >= -1 && s <= 1; });
+        });
+    for (auto& consumer : consumers)
+        consumer.join();
+    REQUIRE(in_range[0]);
+    REQUIRE(in_range[1]);
+}
+
+TEST_CASE("audio_mixer mute, removal and short inputs", "[audio_mixer]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Mono"};
+    audio_mixer<int16_t> mixer(ctx, 2);
+
+    auto a = mixer.add_input();
+    auto b = mixer.add_input();
+    REQUIRE(a);
+    REQUIRE(b);
+    REQUIRE_FALSE(mixer.add_input()); // Registry full
+
+    std::vector<int16_t> block(32, 16384);
+    REQUIRE(mixer.input_queue(*a)->push_audio(ctx, block.data(), 32));
+    REQUIRE(mixer.input_queue(*b)->push_audio(ctx, block.data(), 32));
+
+    mixer.set_mute(*b, true);
+    std::vector<int16_t> output(32, 0);
+    REQUIRE(mixer.mix(output.data(), 32));
+    for (auto s : output)
+        REQUIRE(s == 16384);
+
+    // Both inputs are drained : next period is short and silent
+    REQUIRE_FALSE(mixer.mix(output.data(), 32));
+    for (auto s : output)
+        REQUIRE(s == 0);
+
+    REQUIRE(mixer.remove_input(*b));
+    REQUIRE(mixer.input_queue(*b) == nullptr);
+    REQUIRE_FALSE(mixer.remove_input(*b));
+    REQUIRE(mixer.add_input() == b);
+}
+
+TEST_CASE("audio_mixer resamples and remaps inputs to the output context", "[audio_mixer]")
+{
+    audio_ctx output_ctx{sample_rate::SR48000, "Stereo"};
+    audio_ctx input_ctx{sample_rate::SR48000, "Mono"};
+    audio_mixer<float> mixer(output_ctx);
+
+    auto id = mixer.add_input();
+    REQUIRE(id);
+
+    std::vector<float> mono(100, 0.5f);
+    REQUIRE(mixer.input_queue(*id)->push_audio(input_ctx, mono.data(), 100));
+
+    std::vector<float> output(100 * 2, 0.0f);
+    REQUIRE(mixer.mix(output.data(), 100));
+    for (auto s : output)
+        REQUIRE_THAT(s, WithinAbs(0.5f, 1e-6f));
+}
+
+TEST_CASE("batch_resampler runs every lane like a stream of its own", "[resampler]")
+{
+    const auto filter = polyphase_filter::shared(44100, 48000, resample_quality::best);
+    REQUIRE(filter == polyphase_filter::shared(44100, 48000, resample_quality::best));
+    REQUIRE(filter->up() == 160);
+    REQUIRE(filter->down() == 147);
+
+    // Three sines side by side, and the middle one alone
+    const auto signal = [](std::size_t lane, std::size_t frame) { return 0.5f * static_cast<float>(std::sin(2.0 * 3.14159265358979 * 1000.0 * (lane + 1) * frame / 44100.0)); };
+    batch_resampler batch(filter, 3, 480);
+    batch_resampler alone(filter, 1, 480);
+
+    std::vector<float> lane_one;
+    std::size_t        consumed = 0;
+    for (int block = 0; block < 10; ++block)
+    {
+        const std::size_t frames = batch.input_frames_for(480);
+        REQUIRE(frames == alone.input_frames_for(480));
+        for (std::size_t frame = 0; frame < frames; ++frame)
+        {
+            for (std::size_t lane = 0; lane < 3; ++lane)
+                batch.input(frame)[lane] = signal(lane, consumed + frame);
+            alone.input(frame)[0] = signal(1, consumed + frame);
+        }
+        consumed += frames;
+
+        batch.process(480, 0, 3);
+        alone.process(480, 0, 1);
+        batch.advance(480);
+        alone.advance(480);
+        for (std::size_t frame = 0; frame < 480; ++frame)
+        {
+            REQUIRE(batch.output(frame)[1] == alone.output(frame)[0]);
+            lane_one.push_back(batch.output(frame)[1]);
+        }
+    }
+    REQUIRE(consumed == 4410);
+
+    // Output frame k sits at k x 147 / 160 input frames, late by the filter delay
+    const double delay = (static_cast<double>(filter->taps()) / 2.0) + 0.5;
+    for (std::size_t frame = 480; frame < lane_one.size(); ++frame)
+    {
+        const double position = (static_cast<double>(frame) * 147.0 / 160.0) - delay;
+        REQUIRE_THAT(lane_one[frame], WithinAbs(0.5 * std::sin(2.0 * 3.14159265358979 * 2000.0 * position / 44100.0), 2e-3));
+    }
+}
+
+TEST_CASE("audio_mixer resamples the inputs of a rate in one shared batch", "[audio_mixer]")
+{
+    audio_ctx output_ctx{sample_rate::SR48000, "Stereo"};
+    audio_ctx input_ctx{sample_rate::SR44100, "Stereo"};
+    audio_mixer<float> mixer(output_ctx);
+
+    auto a = mixer.add_input(sample_rate::SR44100);
+    auto b = mixer.add_input(sample_rate::SR44100);
+    auto c = mixer.add_input(sample_rate::SR48000);
+    REQUIRE(a);
+    REQUIRE(b);
+    REQUIRE(c);
+    REQUIRE(mixer.input_queue(*a)->context().m_sample_rate == sample_rate::SR44100);
+    REQUIRE(mixer.input_queue(*c)->context().m_sample_rate == sample_rate::SR48000);
+
+    const auto push = [&](std::size_t id, const audio_ctx& ctx, float level, std::size_t frames)
+    {
+        std::vector<float> block(frames * 2, level);
+        REQUIRE(mixer.input_queue(id)->push_audio(ctx, block.data(), frames));
+    };
+    push(*a, input_ctx, 0.25f, 4410);
+    push(*b, input_ctx, 0.1f, 4410);
+    push(*c, output_ctx, 0.05f, 4800);
+
+    // Past the filter delay, each level comes out unchanged
+    std::vector<float> output(480 * 2);
+    for (int period = 0; period < 10; ++period)
+        REQUIRE(mixer.mix(output.data(), 480));
+    for (auto s : output)
+        REQUIRE_THAT(s, WithinAbs(0.4f, 1e-4f));
+
+    // A new input takes the lanes of a removed one, from silence, and a short queue is padded
+    REQUIRE(mixer.remove_input(*a));
+    auto d = mixer.add_input(sample_rate::SR44100);
+    REQUIRE(d);
+    push(*b, input_ctx, 0.1f, 4410);
+    push(*c, output_ctx, 0.05f, 4800);
+    push(*d, input_ctx, -0.2f, 4410);
+
+    REQUIRE(mixer.mix(output.data(), 480));
+    REQUIRE_THAT(output[0], WithinAbs(0.15f, 1e-4f));
+    for (int period = 1; period < 10; ++period)
+        REQUIRE(mixer.mix(output.data(), 480));
+    REQUIRE_THAT(output.back(), WithinAbs(-0.05f, 1e-4f));
+
+    // Drained : the filter tail, then silence
+    REQUIRE_FALSE(mixer.mix(output.data(), 480));
+    REQUIRE_THAT(output.back(), WithinAbs(0.0f, 1e-6f));
+
+    // Removing the last lane block shrinks the batch, a later input takes the block again from silence
+    REQUIRE(mixer.remove_input(*b));
+    auto e = mixer.add_input(sample_rate::SR44100);
+    REQUIRE(e);
+    push(*c, output_ctx, 0.05f, 4800);
+    push(*d, input_ctx, -0.2f, 4410);
+    push(*e, input_ctx, 0.3f, 4410);
+    for (int period = 0; period < 10; ++period)
+        REQUIRE(mixer.mix(output.data(), 480));
+    REQUIRE_THAT(output.back(), WithinAbs(0.15f, 1e-4f));
+}
+
+TEST_CASE("audio_mixer render thread publishes periods on schedule", "[audio_mixer]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Mono"};
+    audio_mixer<float> mixer(ctx);
+
+    auto id = mixer.add_input();
+    REQUIRE(id);
+    std::vector<float> tone(4800, 0.5f);
+    REQUIRE(mixer.input_queue(*id)->push_audio(ctx, tone.data(), 4800));
+
+    render_config config;
+    config.m_period_frame = 480;
+    REQUIRE(mixer.start(config));
+    REQUIRE_FALSE(mixer.start(config));
+
+    std::vector<float> output(480, 1.0f);
+    REQUIRE_FALSE(mixer.mix(output.data(), 480)); // The render thread owns the mix
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    mixer.stop();
+
+    const auto stats = mixer.stats();
+    REQUIRE(stats.m_periods >= 3);
+    REQUIRE(stats.m_mean_jitter <= stats.m_max_jitter);
+
+    REQUIRE(mixer.read(output.data(), 480));
+    for (auto s : output)
+        REQUIRE_THAT(s, WithinAbs(0.5f, 1e-6f));
+
+    // Once drained, the output ring reads as silence
+    while (mixer.read(output.data(), 480)) {}
+    for (auto s : output)
+        REQUIRE(s == 0.0f);
+
+    // A latency shorter than a period is refused, a restart keeps reading the same ring
+    config.m_output_latency_ms = 5;
+    REQUIRE_FALSE(mixer.start(config));
+
+    config.m_output_latency_ms = 100;
+    std::atomic<bool> reading{true};
+    std::thread consumer([&]
+    {
+        std::vector<float> block(480);
+        while (reading.load())
+            (void)mixer.read(block.data(), 480);
+    });
+    for (int restart = 0; restart < 3; ++restart)
+    {
+        REQUIRE(mixer.start(config));
+        std::this_thread::sleep_for(std::chrono::milliseconds(15));
+        mixer.stop();
+    }
+    reading.store(false);
+    consumer.join();
+}
+
+TEST_CASE("audio_mixer readers get whole 5.1 frames", "[audio_mixer]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "5.1"};
+    audio_mixer<float> mixer(ctx);
+
+    // Channel c holds (c + 1) / 8 : a frame split between readers shifts the channels
+    auto id = mixer.add_input();
+    REQUIRE(id);
+    std::vector<float> frames(2400 * 6);
+    for (size_t i = 0; i < frames.size(); ++i)
+        frames[i] = static_cast<float>((i % 6) + 1) / 8.0f;
+    REQUIRE(mixer.input_queue(*id)->push_audio(ctx, frames.data(), 2400));
+
+    // Reads of 200 frames take two steps : readers polling together interleave them on every period
+    std::atomic<bool>     reading{true};
+    std::array<bool, 2>   aligned{true, true};
+    std::array<size_t, 2> reads{};
+    std::vector<std::thread> readers;
+    for (size_t reader = 0; reader < 2; ++reader)
+        readers.emplace_back([&, reader]
+        {
+            std::vector<float> block(200 * 6);
+            while (reading.load())
+            {
+                reads[reader] += mixer.read(block.data(), 200) ? 1 : 0;
+                for (size_t i = 0; i < block.size(); ++i)
+                    if (block[i] != 0.0f && std::abs(block[i] - (static_cast<float>((i % 6) + 1) / 8.0f)) > 1e-6f)
+                        aligned[reader] = false;
+            }
+        });
+
+    render_config config;
+    config.m_period_frame = 480;
+    REQUIRE(mixer.start(config));
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    mixer.stop();
+    reading.store(false);
+    for (auto& reader : readers)
+        reader.join();
+
+    REQUIRE(reads[0] + reads[1] >= 2);
+    REQUIRE(aligned[0]);
+    REQUIRE(aligned[1]);
+}
+
+TEST_CASE("work_pool runs every index exactly once", "[audio_mixer]")
+{
+    work_pool pool(4);
+    REQUIRE(pool.size() == 4);
+
+    std::vector<std::atomic<int>> hits(1000);
+    for (int round = 0; round < 50; ++round)
+    {
+        // Workers take their new scheduling (refused without privileges) on the next call, work is unchanged
+        if (round == 25)
+            pool.promote_workers(1, std::array<unsigned, 1>{0});
+        pool.parallel_for(hits.size(), [&](std::size_t index) { hits[index].fetch_add(1); });
+    }
+
+    for (auto& hit : hits)
+        REQUIRE(hit.load() == 50);
+}
+
+TEST_CASE("audio_mixer parallel mix is bit-reproducible across thread counts", "[audio_mixer]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    constexpr std::size_t inputs = 37;
+    constexpr std::size_t frames = 1500;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-0.1f, 0.1f);
+    std::vector<std::vector<float>> streams(inputs, std::vector<float>(frames * 2));
+    for (auto& stream : streams)
+        for (auto& s : stream)
+            s = dist(rng);
+
+    const auto render = [&](std::size_t threads)
+    {
+        audio_mixer<float> mixer(ctx, 64, 200, threads);
+        for (std::size_t i = 0; i < inputs; ++i)
+        {
+            auto id = mixer.add_input();
+            REQUIRE(id);
+            mixer.set_gain(*id, 0.5f + (0.01f * static_cast<float>(i)));
+            REQUIRE(mixer.input_queue(*id)->push_audio(ctx, streams[i].data(), frames));
+        }
+        std::vector<float> output(frames * 2);
+        REQUIRE(mixer.mix(output.data(), frames));
+        return output;
+    };
+
+    const auto reference = render(1);
+    for (std::size_t threads : {2, 3, 8})
+    {
+        const auto output = render(threads);
+        REQUIRE(std::memcmp(output.data(), reference.data(), output.size() * sizeof(float)) == 0);
+    }
+}
+
+namespace
+{
+    // Write a WAV file, map it and view its samples : the mapping must outlive the view.
+    template <typename Sample>
+    std::pair<mapped_file, pcm_stream> mapped_wav(const std::filesystem::path& path, audio_ctx ctx, const std::vector<Sample>& samples)
+    {
+        auto writer = wav_writer::create(path, ctx, *pcm_encoding_of<Sample>());
+        REQUIRE(writer);
+        REQUIRE(writer->write(std::as_bytes(std::span{samples})));
+        REQUIRE(writer->close());
+
+        auto file = mapped_file::open(path);
+        REQUIRE(file);
+        auto stream = parse_wav(file->bytes());
+        REQUIRE(stream);
+        return {std::move(*file), *stream};
+    }
+} // namespace
+
+TEST_CASE("WAV files are written by blocks and viewed in place", "[audio_file]")
+{
+    const auto dir = std::filesystem::temp_directory_path();
+    audio_ctx ctx{sample_rate::SR44100, "5.1"};
+
+    std::vector<int16_t> samples(1001 * 6);
+    for (size_t i = 0; i < samples.size(); ++i)
+        samples[i] = static_cast<int16_t>((i * 7919) % 65536);
+
+    auto [file, stream] = mapped_wav(dir / "audio_file_test.wav", ctx, samples);
+    REQUIRE(stream.m_context == ctx);
+    REQUIRE(stream.m_encoding == pcm_encoding::int16);
+    REQUIRE(stream.frame_count() == 1001);
+    REQUIRE(stream.m_data.data() == file.bytes().data() + 44); // No copy
+    REQUIRE(std::memcmp(stream.m_data.data(), samples.data(), stream.m_data.size()) == 0);
+
+    // Raw PCM : whole frames only
+    const auto raw = raw_pcm(file.bytes().subspan(44, 100), ctx, pcm_encoding::int16);
+    REQUIRE(raw.frame_count() == 8);
+    REQUIRE(raw.m_data.size() == 96);
+
+    // Truncated data chunk (stream written without its size) : cut to the frames present
+    REQUIRE(parse_wav(file.bytes().first(44 + 60))->frame_count() == 5);
+
+    // Not a WAV, unsupported rate
+    REQUIRE_FALSE(parse_wav(file.bytes().subspan(4)));
+    std::vector<std::byte> odd_rate(file.bytes().begin(), file.bytes().end());
+    odd_rate[24] = std::byte{0x40}; // 44100 -> 44096
+    REQUIRE_FALSE(parse_wav(odd_rate));
+
+    std::filesystem::remove(dir / "audio_file_test.wav");
+}
+
+TEST_CASE("offline mix-down matches the real-time mix loop", "[audio_file][audio_mixer]")
+{
+    const auto dir = std::filesystem::temp_directory_path();
+    audio_ctx output_ctx{sample_rate::SR48000, "Stereo"};
+    audio_ctx voice_ctx{sample_rate::SR44100, "Mono"};
+
+    // An int16 stem at the output rate, a float stem to convert and resample, of different lengths
+    std::vector<int16_t> music(48000 / 2 * 2);
+    for (size_t i = 0; i < music.size(); ++i)
+        music[i] = static_cast<int16_t>(6000 * std::sin(static_cast<double>(i / 2) * 0.02));
+    std::vector<float> voice(44100 / 3);
+    for (size_t i = 0; i < voice.size(); ++i)
+        voice[i] = 0.3f * static_cast<float>(std::sin(static_cast<double>(i) * 0.05));
+
+    auto [music_file, music_stream] = mapped_wav(dir / "mixdown_music.wav", output_ctx, music);
+    auto [voice_file, voice_stream] = mapped_wav(dir / "mixdown_voice.wav", voice_ctx, voice);
+
+    offline_mixdown<int16_t> mixdown(output_ctx, 4);
+    const auto music_id = mixdown.add_input(music_stream);
+    const auto voice_id = mixdown.add_input(voice_stream);
+    REQUIRE(music_id);
+    REQUIRE(voice_id);
+    mixdown.mixer().set_gain(*voice_id, 0.8f, 0);
+    REQUIRE(mixdown.output_frames() == 24000);
+
+    std::vector<int16_t> offline;
+    const auto stats = mixdown.render([&](std::span<const int16_t> period)
+    {
+        offline.insert(offline.end(), period.begin(), period.end());
+        return true;
+    });
+    REQUIRE(stats.m_complete);
+    REQUIRE(stats.m_frames == 24000);
+    REQUIRE(offline.size() == 24000 * 2);
+
+    // Real-time path : producers push the frames of each period, the mixer mixes it
+    audio_mixer<int16_t> mixer(output_ctx, 4);
+    const auto music_rt = mixer.add_input();
+    const auto voice_rt = mixer.add_input();
+    mixer.set_gain(*voice_rt, 0.8f, 0);
+
+    std::vector<int16_t> voice_int16(voice.size());
+    convert_from_float(std::span<const float>{voice}, std::span{voice_int16});
+
+    std::vector<int16_t> realtime;
+    std::vector<int16_t> period(480 * 2);
+    size_t music_pushed = 0;
+    size_t voice_pushed = 0;
+    for (size_t done = 0; done < 24000; done += 480)
+    {
+        const size_t music_until = std::min(music.size() / 2, done + 480);
+        const size_t voice_until = std::min(voice.size(), ((done + 480) * 44100 + 47999) / 48000);
+        mixer.input_queue(*music_rt)->push_audio(output_ctx, music.data() + (music_pushed * 2), music_until - music_pushed);
+        mixer.input_queue(*voice_rt)->push_audio(voice_ctx, voice_int16.data() + voice_pushed, voice_until - voice_pushed);
+        if (voice_pushed < voice.size() && voice_until == voice.size())
+            mixer.input_queue(*voice_rt)->flush_audio(voice_ctx);
+        music_pushed = music_until;
+        voice_pushed = voice_until;
+
+        mixer.mix(period.data(), 480);
+        realtime.insert(realtime.end(), period.begin(), period.end());
+    }
+    REQUIRE(offline == realtime);
+
+    // The same mix, streamed to a file
+    offline_mixdown<int16_t> to_file(output_ctx, 4);
+    to_file.add_input(music_stream);
+    to_file.mixer().set_gain(*to_file.add_input(voice_stream), 0.8f, 0);
+    REQUIRE(to_file.render_to_file(dir / "mixdown_out.wav"));
+
+    auto output = mapped_file::open(dir / "mixdown_out.wav");
+    REQUIRE(output);
+    const auto rendered = parse_wav(output->bytes());
+    REQUIRE(rendered);
+    REQUIRE(rendered->m_context == output_ctx);
+    REQUIRE(rendered->m_data.size() == offline.size() * sizeof(int16_t));
+    REQUIRE(std::memcmp(rendered->m_data.data(), offline.data(), rendered->m_data.size()) == 0);
+
+    for (const auto* name : {"mixdown_music.wav", "mixdown_voice.wav", "mixdown_out.wav"})
+        std::filesystem::remove(dir / name);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST_CASE("audio_mixer pops an input a producer pushes through shared memory", "[audio_mixer][shared_audio_queue]")
+{
+    audio_ctx ctx{sample_rate::SR48000, "Stereo"};
+    audio_mixer<float> mixer(ctx);
+    const std::string name = "/audio_mixer_test_" + std::to_string(getpid());
+
+    auto local  = mixer.add_input();
+    auto shared = mixer.add_shared_input(name);
+    REQUIRE(local);
+    REQUIRE(shared);
+    REQUIRE(mixer.shared_input(*local) == nullptr);
+    REQUIRE(mixer.shared_input(*shared) != nullptr);
+    REQUIRE_FALSE(mixer.add_shared_input(name)); // One input per name
+
+    // The producer side, as another process would open it
+    auto producer = shared_audio_queue<int16_t>::open(name, shared_queue_role::producer);
+    REQUIRE(producer);
+    REQUIRE(mixer.shared_input(*shared)->peer() == shared_queue_peer::attached);
+
+    std::vector<float>   quiet(64 * 2, 0.1f);
+    std::vector<int16_t> period(64 * 2, 8192); // 0.25
+    REQUIRE(mixer.input_queue(*local)->push_audio(ctx, quiet.data(), 64));
+    REQUIRE(producer->push_audio(ctx, period.data(), 64));
+
+    std::vector<float> output(64 * 2);
+    REQUIRE(mixer.mix(output.data(), 64));
+    for (auto s : output)
+        REQUIRE_THAT(s, WithinAbs(0.35f, 1e-6f));
+    REQUIRE(producer->wait_for_space(producer->queue().capacity_frames(), std::chrono::milliseconds{0}));
+
+    REQUIRE(mixer.remove_input(*shared));
+    REQUIRE(producer->peer() == shared_queue_peer::detached);
+    REQUIRE_FALSE(shared_audio_queue<int16_t>::open(name, shared_queue_role::producer));
+}
+#endif